@@ -0,0 +1,66 @@
+#include "BenchmarkModule.h"
+
+#include "core/Application.h"
+#include "moduels/render3d/Render3DModule.h"
+
+#include <iostream>
+#include <string_view>
+
+int main(int argc, char** argv)
+{
+	using namespace MVE;
+
+	BenchmarkSettings settings {};
+	WindowProperties windowProperties {};
+	windowProperties.headless = true;
+	std::string profilePath;
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg = argv[i];
+		bool hasValue		 = i + 1 < argc;
+		if (arg == "--scene" && hasValue)
+			settings.sceneName = argv[++i];
+		else if (arg == "--warmup" && hasValue)
+			settings.warmupFrames = std::stoul(argv[++i]);
+		else if (arg == "--frames" && hasValue)
+			settings.measuredFrames = std::stoul(argv[++i]);
+		else if (arg == "--output" && hasValue)
+			settings.outputPath = argv[++i];
+		else if (arg == "--width" && hasValue)
+			windowProperties.width = std::stoul(argv[++i]);
+		else if (arg == "--height" && hasValue)
+			windowProperties.height = std::stoul(argv[++i]);
+		else if (arg == "--profile" && hasValue)
+			profilePath = argv[++i];
+		else if (arg == "--cpu-culling")
+			settings.cpuCulling = true;
+		else if (arg == "--list") {
+			for (auto& name : Scenes::Names()) { std::cout << name << "\n"; }
+			return 0;
+		} else {
+			std::cerr << "Usage: VulkanEngineBench [--scene name] [--warmup N] [--frames N] [--output file.json]\n"
+						 "                         [--width W] [--height H] [--profile trace.json] [--cpu-culling]\n"
+						 "                         [--list]\n";
+			return 1;
+		}
+	}
+
+	if (!Scenes::Exists(settings.sceneName)) {
+		std::cerr << "Unknown scene '" << settings.sceneName << "', use --list to see the available scenes\n";
+		return 1;
+	}
+
+	auto app = Application::Create(windowProperties)
+				   ->SetFrameLimit(settings.TotalFrames())
+				   ->AddModule<Render3DModule>(settings.sceneName, settings.cpuCulling)
+				   ->AddModule<BenchmarkModule>(settings);
+
+	if (!profilePath.empty())
+		Profiler::BeginSession(profilePath);
+
+	app->Run();
+
+	Profiler::EndSession();
+
+	delete app;
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "BenchmarkModule.h"
+
+#include "moduels/render3d/Defragmenter.h"
+#include "moduels/render3d/MeshPool.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace MVE
+{
+
+namespace
+{
+struct Percentiles
+{
+	float mean = 0.0f;
+	float p50  = 0.0f;
+	float p95  = 0.0f;
+	float p99  = 0.0f;
+	float max  = 0.0f;
+};
+
+// Nearest rank percentiles
+Percentiles ComputePercentiles(std::vector<float> samples)
+{
+	Percentiles result;
+	if (samples.empty())
+		return result;
+
+	std::sort(samples.begin(), samples.end());
+	auto rank = [&](float percentile) {
+		size_t index = std::ceil(percentile / 100.0f * samples.size());
+		return samples[std::clamp<size_t>(index, 1, samples.size()) - 1];
+	};
+
+	double sum = 0.0;
+	for (float s : samples) { sum += s; }
+
+	result.mean = sum / samples.size();
+	result.p50	= rank(50.0f);
+	result.p95	= rank(95.0f);
+	result.p99	= rank(99.0f);
+	result.max	= samples.back();
+	return result;
+}
+
+void WritePercentiles(std::ofstream& out, const char* name, const std::vector<float>& samples)
+{
+	auto p = ComputePercentiles(samples);
+	out << "\t\"" << name << "\": {\"samples\": " << samples.size() << ", \"mean\": " << p.mean
+		<< ", \"p50\": " << p.p50 << ", \"p95\": " << p.p95 << ", \"p99\": " << p.p99 << ", \"max\": " << p.max
+		<< "},\n";
+}
+
+void WriteHeaps(std::ofstream& out, const std::vector<HeapStats>& heaps)
+{
+	out << "[";
+	for (size_t i = 0; i < heaps.size(); i++) {
+		auto& heap = heaps[i];
+		out << (i > 0 ? ", " : "") << "{\"heapSize\": " << heap.heapSize
+			<< ", \"allocatedBytes\": " << heap.allocatedBytes << ", \"usedBytes\": " << heap.usedBytes
+			<< ", \"allocationCount\": " << heap.allocationCount << ", \"resourceCount\": " << heap.resourceCount
+			<< "}";
+	}
+	out << "]";
+}
+} // namespace
+
+void BenchmarkModule::OnAttach()
+{
+	renderModule = Application::Get()->GetModule<Render3DModule>();
+	MVE_ASSERT(renderModule != nullptr, "BenchmarkModule requires a Render3DModule");
+
+	cpuFrameTimes.reserve(settings.measuredFrames);
+	gpuFrameTimes.reserve(settings.measuredFrames);
+}
+
+void BenchmarkModule::OnUpdate(Timestep dt)
+{
+	// Timestep is clamped by the application, so frame times are measured here instead
+	uint64_t now = Profiler::Now();
+	if (settings.IsMeasured(frame))
+		cpuFrameTimes.push_back((now - lastFrameStart) / 1e6f);
+	lastFrameStart = now;
+
+	// GPU results lag a few frames behind, so they are matched by frame number
+	auto& gpuProfiler = renderModule->GetRenderer().GetGpuProfiler();
+	AddGpuSample(gpuProfiler.GetFrameResults());
+
+	renderStats = renderModule->GetFrameStats();
+
+	frame++;
+	if (frame == settings.TotalFrames()) {
+		// The last measured frames are still in flight, waiting for them gives every measured frame a GPU sample
+		vkDeviceWaitIdle(renderModule->GetDevice().VulkanDevice());
+		for (auto& results : gpuProfiler.ResolvePending()) { AddGpuSample(results); }
+		WriteResults();
+	}
+}
+
+void BenchmarkModule::AddGpuSample(const GpuFrameResults& results)
+{
+	if (results.scopes.empty() || results.frameNumber == lastGpuFrame)
+		return;
+
+	lastGpuFrame = results.frameNumber;
+	if (settings.IsMeasured(results.frameNumber))
+		gpuFrameTimes.push_back(results.frameMilliseconds);
+}
+
+void BenchmarkModule::WriteResults()
+{
+	std::ofstream out(settings.outputPath);
+	if (!out) {
+		MVE_ERROR("Failed to open benchmark output file {}", settings.outputPath);
+		return;
+	}
+
+	auto& device	= renderModule->GetDevice();
+	auto memory		= device.GetMemoryStats();
+	auto defragment = device.GetDefragmenter().GetStats();
+	auto meshPool	= device.GetMeshPool().GetStats();
+
+	out << "{\n";
+	out << "\t\"scene\": \"" << settings.sceneName << "\",\n";
+	out << "\t\"culling\": \"" << (renderModule->CullsOnGpu() ? "gpu" : "cpu") << "\",\n";
+	out << "\t\"warmupFrames\": " << settings.warmupFrames << ",\n";
+	out << "\t\"measuredFrames\": " << settings.measuredFrames << ",\n";
+	WritePercentiles(out, "cpuFrameMs", cpuFrameTimes);
+	WritePercentiles(out, "gpuFrameMs", gpuFrameTimes);
+	out << "\t\"drawCalls\": " << renderStats.drawCalls << ",\n";
+	out << "\t\"triangles\": " << renderStats.triangles << ",\n";
+	out << "\t\"culledObjects\": " << renderStats.culledObjects << ",\n";
+	out << "\t\"memory\": {\"allocatedBytes\": " << memory.allocatedBytes
+		<< ", \"peakAllocatedBytes\": " << memory.peakAllocatedBytes
+		<< ", \"allocationCount\": " << memory.allocationCount << ", \"usedBytes\": " << memory.usedBytes
+		<< ", \"resourceCount\": " << memory.resourceCount << ",\n\t\t\"heaps\": ";
+	WriteHeaps(out, device.GetMemoryAllocator().GetHeapStats());
+	out << ",\n\t\t\"defragmenter\": {\"movedBytes\": " << defragment.movedBytes
+		<< ", \"movedResources\": " << defragment.movedResources << "},\n\t\t\"meshPool\": {\"pageCount\": "
+		<< meshPool.pageCount << ", \"usedBytes\": " << meshPool.usedBytes
+		<< ", \"reservedBytes\": " << meshPool.reservedBytes << "}}\n";
+	out << "}\n";
+
+	auto cpu = ComputePercentiles(cpuFrameTimes);
+	auto gpu = ComputePercentiles(gpuFrameTimes);
+	MVE_INFO("Benchmark '{}': CPU p50 {:.3f} ms p99 {:.3f} ms, GPU p50 {:.3f} ms p99 {:.3f} ms. Written to {}",
+			 settings.sceneName, cpu.p50, cpu.p99, gpu.p50, gpu.p99, settings.outputPath);
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "moduels/Module.h"
+#include "moduels/render3d/Render3DModule.h"
+
+namespace MVE
+{
+
+struct BenchmarkSettings
+{
+	std::string sceneName	= "cerberus";
+	uint32_t warmupFrames	= 100;
+	uint32_t measuredFrames = 500;
+	std::string outputPath	= "bench_results.json";
+	bool cpuCulling			= false; // Measures the CPU culling path on devices that could cull on the GPU
+
+	// Frames the application has to run for the benchmark to finish
+	uint32_t TotalFrames() const { return warmupFrames + measuredFrames + 1; }
+	// Frame 0 has no previous frame to measure the CPU time from
+	bool IsMeasured(uint64_t frameIndex) const { return frameIndex > warmupFrames && frameIndex < TotalFrames(); }
+};
+
+/// Collects frame timings from a Render3DModule and writes a JSON report once enough frames were measured.
+/// Must be added after the Render3DModule so it sees each frame after it was recorded.
+class BenchmarkModule : public Module
+{
+  public:
+	BenchmarkModule(const BenchmarkSettings& settings): settings(settings) {}
+
+	void OnAttach() override;
+	void OnUpdate(Timestep dt) override;
+	const char* GetName() const override { return "BenchmarkModule"; }
+
+  private:
+	void AddGpuSample(const GpuFrameResults& results);
+	void WriteResults();
+
+  private:
+	BenchmarkSettings settings;
+	Render3DModule* renderModule = nullptr;
+
+	uint32_t frame			= 0;
+	uint64_t lastFrameStart = 0;
+	uint64_t lastGpuFrame	= UINT64_MAX;
+
+	std::vector<float> cpuFrameTimes;
+	std::vector<float> gpuFrameTimes;
+	RenderStats renderStats;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "core/JobSystem.h"
+#include "core/TransformBatch.h"
+
+#include <glm/gtx/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+// Compares the per-object glm matrix math TransformComponent used to do with TransformBatch, single threaded and
+// spread over the JobSystem.
+
+using namespace MVE;
+
+namespace
+{
+constexpr int REPETITIONS = 50;
+
+struct Transforms
+{
+	std::vector<float> components[10]; // Translation xyz, rotation xyzw, scale xyz
+
+	TransformSoA SoA(size_t first, size_t count) const
+	{
+		auto at = [&](int c) { return components[c].data() + first; };
+		return {{at(0), at(1), at(2)}, {at(3), at(4), at(5), at(6)}, {at(7), at(8), at(9)}, count};
+	}
+};
+
+Transforms RandomTransforms(size_t count)
+{
+	std::mt19937 rng(1337);
+	auto random = [&](float min, float max) { return min + (max - min) * ((rng() >> 8) * (1.0f / 16777216.0f)); };
+
+	Transforms t;
+	for (auto& c : t.components) { c.resize(count); }
+	for (size_t i = 0; i < count; i++) {
+		glm::quat q = glm::normalize(glm::quat(random(-1, 1), random(-1, 1), random(-1, 1), random(-1, 1)));
+		for (int c = 0; c < 3; c++) { t.components[c][i] = random(-50.0f, 50.0f); }
+		for (int c = 0; c < 4; c++) { t.components[3 + c][i] = q[c]; }
+		for (int c = 0; c < 3; c++) { t.components[7 + c][i] = random(0.2f, 2.0f); }
+	}
+	return t;
+}
+
+// Median of REPETITIONS runs, in milliseconds
+template<typename Function>
+double Measure(Function&& function)
+{
+	std::vector<double> times;
+	for (int i = 0; i < REPETITIONS; i++) {
+		auto start = std::chrono::steady_clock::now();
+		function();
+		times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+void Run(size_t count)
+{
+	auto t = RandomTransforms(count);
+	std::vector<glm::mat4> models(count);
+	std::vector<glm::mat3> normals(count);
+
+	double glmTime = Measure([&] {
+		for (size_t i = 0; i < count; i++) {
+			glm::vec3 translation {t.components[0][i], t.components[1][i], t.components[2][i]};
+			glm::quat rotation {t.components[6][i], t.components[3][i], t.components[4][i], t.components[5][i]};
+			glm::vec3 scale {t.components[7][i], t.components[8][i], t.components[9][i]};
+
+			models[i]  = glm::translate(glm::toMat4(rotation) * glm::scale(glm::mat4 {1.0}, scale), translation);
+			normals[i] = glm::transpose(glm::inverse(glm::mat3(models[i])));
+		}
+	});
+
+	double batchTime = Measure([&] { TransformBatch::Compute(t.SoA(0, count), models.data(), normals.data()); });
+
+	double jobsTime = Measure([&] {
+		JobSystem::ParallelFor(count, 1024, [&](uint32_t begin, uint32_t end) {
+			TransformBatch::Compute(t.SoA(begin, end - begin), models.data() + begin, normals.data() + begin);
+		});
+	});
+
+	std::printf("%7zu  %10.3f  %10.3f (%5.2fx)  %10.3f (%5.2fx)\n", count, glmTime, batchTime, glmTime / batchTime,
+				jobsTime, glmTime / jobsTime);
+}
+} // namespace
+
+int main()
+{
+	JobSystem::Init();
+
+	std::printf("TransformBatch: %s, %u threads, median of %d runs in ms\n\n", TransformBatch::InstructionSet(),
+				JobSystem::ThreadCount(), REPETITIONS);
+	std::printf("%7s  %10s  %19s  %19s\n", "Objects", "glm", "Batch", "Batch + jobs");
+	Run(10000);
+	Run(100000);
+
+	JobSystem::Shutdown();
+	return 0;
+}
\ No newline at end of file
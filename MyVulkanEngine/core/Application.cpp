@@ -2,28 +2,48 @@
 
 #include "Timestep.h"
 
+#include <chrono>
+
 namespace MVE
 {
 Application* Application::s_Instance = nullptr;
 
+// glfwGetTime is not available when running headless, so the loop keeps its own clock.
+static float GetTime()
+{
+	using namespace std::chrono;
+	static const auto start = steady_clock::now();
+	return duration<float>(steady_clock::now() - start).count();
+}
+
 void Application::Run()
 {
+	Profiler::SetThreadName("Main");
+	MVE_PROFILE_SCOPE("Application::Run");
+
 	// init
 	for (auto& m : modules) { m->OnAttach(); }
 
 	Timestep dt {0.0f};
-	float lastFrameTime = glfwGetTime();
+	float lastFrameTime = GetTime();
 	float currentTime;
+	uint32_t frameCount = 0;
 
 	// loop
-	while (!window.ShouldClose()) {
-		currentTime	  = glfwGetTime();
+	while (!window.ShouldClose() && (frameLimit == 0 || frameCount < frameLimit)) {
+		MVE_PROFILE_SCOPE("Frame");
+
+		currentTime	  = GetTime();
 		dt			  = currentTime - lastFrameTime;
 		lastFrameTime = currentTime;
 		dt			  = glm::min((float)dt, MAX_FRAME_TIME);
 
 		window.OnUpdate();
-		for (auto& m : modules) { m->OnUpdate(dt); }
+		for (auto& m : modules) {
+			MVE_PROFILE_SCOPE(m->GetName());
+			m->OnUpdate(dt);
+		}
+		frameCount++;
 	}
 }
 } // namespace MVE
\ No newline at end of file
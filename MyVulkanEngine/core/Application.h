@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Input.h"
+#include "JobSystem.h"
 #include "Window.h"
 #include "moduels/Module.h"
 
@@ -14,13 +15,17 @@ namespace MVE
 class Application
 {
   private:
-	Application() { Log::Init(); }
+	Application(const WindowProperties& windowProperties): window(windowProperties)
+	{
+		Log::Init();
+		JobSystem::Init();
+	}
 
   public:
-	static Application* Create()
+	static Application* Create(const WindowProperties& windowProperties = WindowProperties())
 	{
 		MVE_ASSERT(s_Instance == nullptr, "Application already exists. There can only be one application");
-		s_Instance = new Application();
+		s_Instance = new Application(windowProperties);
 		return s_Instance;
 	}
 	static Application* Get() { return s_Instance; }
@@ -32,12 +37,30 @@ class Application
 			m->OnDetach();
 			delete m;
 		}
+		JobSystem::Shutdown();
 	};
 
+	template<typename T, typename... Args>
+	Application* AddModule(Args&&... args)
+	{
+		modules.push_back(new T(std::forward<Args>(args)...));
+		return this;
+	}
+
 	template<typename T>
-	Application* AddModule()
+	T* GetModule()
+	{
+		for (auto m : modules) {
+			if (auto module = dynamic_cast<T*>(m))
+				return module;
+		}
+		return nullptr;
+	}
+
+	// Stop after running this many frames. 0 runs until the window is closed.
+	Application* SetFrameLimit(uint32_t frames)
 	{
-		modules.push_back(new T());
+		frameLimit = frames;
 		return this;
 	}
 
@@ -52,5 +75,6 @@ class Application
 	static constexpr float MAX_FRAME_TIME = 1 / 30.0f;
 	std::vector<Module*> modules;
 	Window window;
+	uint32_t frameLimit = 0;
 }; // namespace MVE
 } // namespace MVE
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "Bounds.h"
+
+#include "SimdVec.h"
+
+namespace MVE
+{
+
+BoundingSphere BoundingSphere::Transformed(const glm::mat4& transform) const
+{
+	float scale2 = glm::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+							glm::max(glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+									 glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+	return {glm::vec3(transform * glm::vec4(center, 1.0f)), radius * glm::sqrt(scale2)};
+}
+
+float Aabb::SurfaceArea() const
+{
+	glm::vec3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool Aabb::Contains(const Aabb& other) const
+{
+	return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+}
+
+bool Aabb::Overlaps(const Aabb& other) const
+{
+	return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+}
+
+bool Aabb::Overlaps(const BoundingSphere& sphere) const
+{
+	glm::vec3 offset = glm::clamp(sphere.center, min, max) - sphere.center;
+	return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+}
+
+bool Aabb::Intersects(const Ray& ray, float maxDistance, float& distance) const
+{
+	// Slab test, a zero direction component divides to infinity, which the comparisons handle
+	glm::vec3 inverseDirection = 1.0f / ray.direction;
+	glm::vec3 t0			   = (min - ray.origin) * inverseDirection;
+	glm::vec3 t1			   = (max - ray.origin) * inverseDirection;
+	glm::vec3 enters		   = glm::min(t0, t1);
+	glm::vec3 exits			   = glm::max(t0, t1);
+
+	float enter = glm::max(glm::max(enters.x, enters.y), glm::max(enters.z, 0.0f));
+	float exit	= glm::min(glm::min(exits.x, exits.y), glm::min(exits.z, maxDistance));
+	distance	= enter;
+	return enter <= exit;
+}
+
+void Aabb::Grow(const glm::vec3& point)
+{
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void Aabb::Grow(const Aabb& other)
+{
+	min = glm::min(min, other.min);
+	max = glm::max(max, other.max);
+}
+
+Aabb Aabb::Expanded(float margin) const
+{
+	return {min - glm::vec3(margin), max + glm::vec3(margin)};
+}
+
+Aabb Aabb::Transformed(const glm::mat4& transform) const
+{
+	if (IsEmpty())
+		return *this;
+
+	// Each world axis extent is the sum of the box's extents projected onto it
+	glm::mat3 absolute {glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])),
+						glm::abs(glm::vec3(transform[2]))};
+	glm::vec3 center(transform * glm::vec4(Center(), 1.0f));
+	glm::vec3 extents = absolute * Extents();
+	return {center - extents, center + extents};
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+	auto row = [&](int i) {
+		return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	};
+
+	planes[0] = row(3) + row(0); // Left
+	planes[1] = row(3) - row(0); // Right
+	planes[2] = row(3) + row(1); // Top, Vulkan's y points down
+	planes[3] = row(3) - row(1); // Bottom
+	planes[4] = row(2);			 // Near
+	planes[5] = row(3) - row(2); // Far
+
+	for (auto& plane : planes) { plane /= glm::length(glm::vec3(plane)); }
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const
+{
+	for (auto& plane : planes) {
+		if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+			return false;
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const Aabb& box) const
+{
+	glm::vec3 center  = box.Center();
+	glm::vec3 extents = box.Extents();
+	for (auto& plane : planes) {
+		glm::vec3 normal(plane);
+		if (glm::dot(normal, center) + glm::dot(glm::abs(normal), extents) + plane.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+bool Frustum::Contains(const Aabb& box) const
+{
+	glm::vec3 center  = box.Center();
+	glm::vec3 extents = box.Extents();
+	for (auto& plane : planes) {
+		glm::vec3 normal(plane);
+		if (glm::dot(normal, center) - glm::dot(glm::abs(normal), extents) + plane.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+namespace
+{
+// Tests V::WIDTH spheres starting at first, a sphere is visible when it's not fully behind any plane
+template<typename V>
+size_t CullBlock(const std::array<glm::vec4, 6>& planes, const SphereSoA& s, size_t first, uint8_t* visible)
+{
+	V cx	 = V::Load(s.center[0] + first);
+	V cy	 = V::Load(s.center[1] + first);
+	V cz	 = V::Load(s.center[2] + first);
+	V radius = V::Load(s.radius + first);
+
+	V closest = V::Set(std::numeric_limits<float>::max());
+	for (auto& plane : planes) {
+		V distance = V::Set(plane.x) * cx + V::Set(plane.y) * cy + V::Set(plane.z) * cz + V::Set(plane.w);
+		closest	   = Min(closest, distance + radius);
+	}
+
+	alignas(32) float lanes[V::WIDTH];
+	closest.Store(lanes);
+
+	size_t count = 0;
+	for (size_t lane = 0; lane < V::WIDTH; lane++) {
+		visible[first + lane] = lanes[lane] >= 0.0f;
+		count += visible[first + lane];
+	}
+	return count;
+}
+} // namespace
+
+size_t Frustum::CullSpheres(const SphereSoA& spheres, uint8_t* visible) const
+{
+	size_t count = 0;
+	size_t i	 = 0;
+	for (; i + SimdVec::WIDTH <= spheres.count; i += SimdVec::WIDTH) {
+		count += CullBlock<SimdVec>(planes, spheres, i, visible);
+	}
+	for (; i < spheres.count; i++) { count += CullBlock<ScalarVec>(planes, spheres, i, visible); }
+	return count;
+}
+
+} // namespace MVE
\ No newline at end of file
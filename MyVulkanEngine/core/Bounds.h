@@ -0,0 +1,78 @@
+#pragma once
+
+namespace MVE
+{
+
+struct Ray
+{
+	glm::vec3 origin {0.0f};
+	glm::vec3 direction {0.0f, 0.0f, -1.0f}; // Normalized, so distances along the ray are in world units
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center {0.0f};
+	float radius = 0.0f;
+
+	// Encloses the sphere after transform, the radius grows with the largest axis scale
+	BoundingSphere Transformed(const glm::mat4& transform) const;
+};
+
+/// Axis aligned bounding box. A default constructed box is empty, so it can be grown from nothing.
+struct Aabb
+{
+	glm::vec3 min {std::numeric_limits<float>::max()};
+	glm::vec3 max {std::numeric_limits<float>::lowest()};
+
+	bool IsEmpty() const { return min.x > max.x; }
+	glm::vec3 Center() const { return (min + max) * 0.5f; }
+	glm::vec3 Extents() const { return (max - min) * 0.5f; }
+	float SurfaceArea() const;
+
+	bool Contains(const Aabb& other) const;
+	bool Overlaps(const Aabb& other) const;
+	bool Overlaps(const BoundingSphere& sphere) const;
+	// distance is where the ray enters the box, or 0 when it starts inside
+	bool Intersects(const Ray& ray, float maxDistance, float& distance) const;
+
+	void Grow(const glm::vec3& point);
+	void Grow(const Aabb& other);
+	Aabb Expanded(float margin) const;
+	// Encloses the box after transform, which may be looser than the transformed geometry
+	Aabb Transformed(const glm::mat4& transform) const;
+};
+
+/// Bounding spheres with one array per component, so a SIMD register can test several at once.
+struct SphereSoA
+{
+	const float* center[3] {}; // x, y, z
+	const float* radius = nullptr;
+	size_t count		= 0;
+};
+
+/// The six planes of a view frustum with their normals pointing inside. Tests are conservative, a volume near a corner
+/// of the frustum may pass without being visible.
+class Frustum
+{
+  public:
+	Frustum() = default;
+	// viewProjection is projection * view with Vulkan's 0 to 1 depth range
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	bool Intersects(const BoundingSphere& sphere) const;
+	bool Intersects(const Aabb& box) const;
+	// True when the whole box is inside
+	bool Contains(const Aabb& box) const;
+
+	// Sets visible[i] to 1 when sphere i intersects the frustum and 0 otherwise, with the same SIMD width as
+	// TransformBatch. Returns the number of visible spheres.
+	size_t CullSpheres(const SphereSoA& spheres, uint8_t* visible) const;
+
+	// Left, right, top, bottom, near, far. Normals point inside and are normalized, so xyz . p + w is a distance.
+	const std::array<glm::vec4, 6>& Planes() const { return planes; }
+
+  private:
+	std::array<glm::vec4, 6> planes {};
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "Bvh.h"
+
+#include <algorithm>
+
+namespace MVE
+{
+
+namespace
+{
+Aabb Union(Aabb a, const Aabb& b)
+{
+	a.Grow(b);
+	return a;
+}
+} // namespace
+
+int32_t Bvh::Insert(const Aabb& box, uint32_t userData)
+{
+	int32_t proxy		  = AllocateNode();
+	nodes[proxy].box	  = box.Expanded(margin);
+	nodes[proxy].userData = userData;
+	nodes[proxy].height	  = 0;
+	InsertLeaf(proxy);
+	proxyCount++;
+	return proxy;
+}
+
+void Bvh::Remove(int32_t proxy)
+{
+	MVE_ASSERT(proxy >= 0 && proxy < int32_t(nodes.size()) && nodes[proxy].IsLeaf(), "Invalid BVH proxy {}", proxy);
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	proxyCount--;
+}
+
+bool Bvh::Move(int32_t proxy, const Aabb& box)
+{
+	MVE_ASSERT(proxy >= 0 && proxy < int32_t(nodes.size()) && nodes[proxy].IsLeaf(), "Invalid BVH proxy {}", proxy);
+	if (nodes[proxy].box.Contains(box))
+		return false;
+
+	RemoveLeaf(proxy);
+	nodes[proxy].box = box.Expanded(margin);
+	InsertLeaf(proxy);
+	return true;
+}
+
+void Bvh::Clear()
+{
+	nodes.clear();
+	root	   = NULL_NODE;
+	freeList   = NULL_NODE;
+	proxyCount = 0;
+}
+
+int32_t Bvh::AllocateNode()
+{
+	if (freeList == NULL_NODE) {
+		nodes.emplace_back();
+		return int32_t(nodes.size() - 1);
+	}
+
+	int32_t index = freeList;
+	freeList	  = nodes[index].parent;
+	nodes[index]  = {};
+	return index;
+}
+
+void Bvh::FreeNode(int32_t index)
+{
+	nodes[index].parent = freeList;
+	nodes[index].height = -1;
+	freeList			= index;
+}
+
+void Bvh::InsertLeaf(int32_t leaf)
+{
+	if (root == NULL_NODE) {
+		root			   = leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	// Descend towards the sibling that grows the total surface area the least
+	Aabb leafBox  = nodes[leaf].box;
+	int32_t index = root;
+	while (!nodes[index].IsLeaf()) {
+		const Node& node = nodes[index];
+		float area		 = node.box.SurfaceArea();
+		float combined	 = Union(node.box, leafBox).SurfaceArea();
+
+		// Pairing with this node creates a parent of the combined area, descending grows this node's box anyway
+		float cost			  = 2.0f * combined;
+		float inheritanceCost = 2.0f * (combined - area);
+
+		auto descendCost = [&](int32_t child) {
+			const Node& childNode = nodes[child];
+			float grownArea		  = Union(childNode.box, leafBox).SurfaceArea();
+			return (childNode.IsLeaf() ? grownArea : grownArea - childNode.box.SurfaceArea()) + inheritanceCost;
+		};
+		float cost1 = descendCost(node.child1);
+		float cost2 = descendCost(node.child2);
+
+		if (cost < cost1 && cost < cost2)
+			break;
+		index = cost1 < cost2 ? node.child1 : node.child2;
+	}
+
+	int32_t sibling	  = index;
+	int32_t oldParent = nodes[sibling].parent;
+	int32_t newParent = AllocateNode();
+
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box	= Union(nodes[sibling].box, leafBox);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent	= newParent;
+	nodes[leaf].parent		= newParent;
+
+	if (oldParent == NULL_NODE) {
+		root = newParent;
+	} else if (nodes[oldParent].child1 == sibling) {
+		nodes[oldParent].child1 = newParent;
+	} else {
+		nodes[oldParent].child2 = newParent;
+	}
+
+	RefitAncestors(nodes[leaf].parent);
+}
+
+void Bvh::RemoveLeaf(int32_t leaf)
+{
+	if (leaf == root) {
+		root = NULL_NODE;
+		return;
+	}
+
+	int32_t parent		= nodes[leaf].parent;
+	int32_t grandParent = nodes[parent].parent;
+	int32_t sibling		= nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	FreeNode(parent);
+	nodes[sibling].parent = grandParent;
+
+	if (grandParent == NULL_NODE) {
+		root = sibling;
+		return;
+	}
+
+	if (nodes[grandParent].child1 == parent)
+		nodes[grandParent].child1 = sibling;
+	else
+		nodes[grandParent].child2 = sibling;
+	RefitAncestors(grandParent);
+}
+
+void Bvh::RefitAncestors(int32_t index)
+{
+	while (index != NULL_NODE) {
+		index = Balance(index);
+
+		Node& node	= nodes[index];
+		node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+		node.box	= Union(nodes[node.child1].box, nodes[node.child2].box);
+
+		index = node.parent;
+	}
+}
+
+int32_t Bvh::Balance(int32_t indexA)
+{
+	Node& a = nodes[indexA];
+	if (a.IsLeaf() || a.height < 2)
+		return indexA;
+
+	int32_t indexB = a.child1;
+	int32_t indexC = a.child2;
+	Node& b		   = nodes[indexB];
+	Node& c		   = nodes[indexC];
+
+	int32_t balance = c.height - b.height;
+	if (balance >= -1 && balance <= 1)
+		return indexA;
+
+	// The taller child takes A's place and A takes over one of its children, the shorter one of them stays
+	bool rotateC		  = balance > 1;
+	int32_t indexUp		  = rotateC ? indexC : indexB;
+	Node& up			  = nodes[indexUp];
+	Node& other			  = rotateC ? b : c;
+	int32_t indexUpChild1 = up.child1;
+	int32_t indexUpChild2 = up.child2;
+	Node& upChild1		  = nodes[indexUpChild1];
+	Node& upChild2		  = nodes[indexUpChild2];
+
+	up.child1 = indexA;
+	up.parent = a.parent;
+	a.parent  = indexUp;
+
+	if (up.parent == NULL_NODE)
+		root = indexUp;
+	else if (nodes[up.parent].child1 == indexA)
+		nodes[up.parent].child1 = indexUp;
+	else
+		nodes[up.parent].child2 = indexUp;
+
+	// The taller grandchild stays with the rotated node, the shorter one moves under A
+	bool keepChild1	   = upChild1.height > upChild2.height;
+	int32_t indexKept  = keepChild1 ? indexUpChild1 : indexUpChild2;
+	int32_t indexMoved = keepChild1 ? indexUpChild2 : indexUpChild1;
+	Node& kept		   = nodes[indexKept];
+	Node& moved		   = nodes[indexMoved];
+
+	up.child2	 = indexKept;
+	moved.parent = indexA;
+	if (rotateC)
+		a.child2 = indexMoved;
+	else
+		a.child1 = indexMoved;
+
+	a.box	  = Union(other.box, moved.box);
+	up.box	  = Union(a.box, kept.box);
+	a.height  = 1 + std::max(other.height, moved.height);
+	up.height = 1 + std::max(a.height, kept.height);
+
+	return indexUp;
+}
+
+} // namespace MVE
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "Bounds.h"
+
+namespace MVE
+{
+
+/// Dynamic bounding volume hierarchy of AABBs, kept balanced with tree rotations so queries visit O(log n) nodes plus
+/// the ones they hit. Leaves store a fat box, the proxy's box grown by a margin, so objects that move a little only
+/// need a containment check and only those that leave their fat box are reinserted.
+class Bvh
+{
+  public:
+	static constexpr int32_t NULL_NODE = -1;
+
+  public:
+	Bvh(float margin = 0.1f): margin(margin) {}
+
+	// Returns a proxy id, stable until the proxy is removed
+	int32_t Insert(const Aabb& box, uint32_t userData);
+	void Remove(int32_t proxy);
+	// Returns true when the proxy left its fat box and was reinserted
+	bool Move(int32_t proxy, const Aabb& box);
+	void Clear();
+
+	uint32_t GetUserData(int32_t proxy) const { return nodes[proxy].userData; }
+	const Aabb& GetFatBox(int32_t proxy) const { return nodes[proxy].box; }
+	size_t ProxyCount() const { return proxyCount; }
+	int32_t Height() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+	// function(userData) for every proxy whose fat box overlaps the volume
+	template<typename Function>
+	void Query(const Aabb& box, Function&& function) const
+	{
+		Traverse([&](const Aabb& nodeBox) { return box.Overlaps(nodeBox) ? OVERLAPS : OUTSIDE; }, function);
+	}
+	template<typename Function>
+	void Query(const BoundingSphere& sphere, Function&& function) const
+	{
+		Traverse([&](const Aabb& nodeBox) { return nodeBox.Overlaps(sphere) ? OVERLAPS : OUTSIDE; }, function);
+	}
+	// Subtrees fully inside the frustum are reported without testing any of their nodes
+	template<typename Function>
+	void Query(const Frustum& frustum, Function&& function) const
+	{
+		Traverse(
+			[&](const Aabb& nodeBox) {
+				if (!frustum.Intersects(nodeBox))
+					return OUTSIDE;
+				return frustum.Contains(nodeBox) ? INSIDE : OVERLAPS;
+			},
+			function);
+	}
+
+	// function(userData, distance) is called for every fat box the ray hits within maxDistance, nearest subtrees first.
+	// It returns the new maxDistance, so returning distance finds the closest hit, maxDistance all of them and 0 stops.
+	template<typename Function>
+	void RayCast(const Ray& ray, float maxDistance, Function&& function) const
+	{
+		if (root == NULL_NODE)
+			return;
+
+		std::array<int32_t, MAX_STACK> stack;
+		uint32_t count = 0;
+		stack[count++] = root;
+		while (count > 0) {
+			const Node& node = nodes[stack[--count]];
+
+			float distance;
+			if (!node.box.Intersects(ray, maxDistance, distance))
+				continue;
+
+			if (node.IsLeaf()) {
+				maxDistance = function(node.userData, distance);
+				if (maxDistance <= 0.0f)
+					return;
+				continue;
+			}
+
+			MVE_ASSERT(count + 2 <= MAX_STACK, "BVH is too deep to traverse");
+			// The nearer child is pushed last so it's visited first and can shorten the ray for the other one
+			float toChild1 = glm::dot(nodes[node.child1].box.Center() - ray.origin, ray.direction);
+			float toChild2 = glm::dot(nodes[node.child2].box.Center() - ray.origin, ray.direction);
+			stack[count++] = toChild1 < toChild2 ? node.child2 : node.child1;
+			stack[count++] = toChild1 < toChild2 ? node.child1 : node.child2;
+		}
+	}
+
+  private:
+	static constexpr uint32_t MAX_STACK = 128;
+
+	enum Overlap
+	{
+		OUTSIDE,
+		OVERLAPS,
+		INSIDE
+	};
+
+	struct Node
+	{
+		Aabb box;
+		int32_t parent	  = NULL_NODE; // Next free node while the node is unused
+		int32_t child1	  = NULL_NODE;
+		int32_t child2	  = NULL_NODE;
+		int32_t height	  = 0; // Leaves are 0, free nodes -1
+		uint32_t userData = 0;
+
+		bool IsLeaf() const { return child1 == NULL_NODE; }
+	};
+
+	// classify(box) decides whether to skip, descend into or report the whole subtree of a node
+	template<typename Classify, typename Function>
+	void Traverse(Classify&& classify, Function&& function) const
+	{
+		if (root == NULL_NODE)
+			return;
+
+		std::array<int32_t, MAX_STACK> stack;
+		uint32_t count = 0;
+		stack[count++] = root;
+		while (count > 0) {
+			int32_t index	 = stack[--count];
+			const Node& node = nodes[index];
+
+			Overlap overlap = classify(node.box);
+			if (overlap == OUTSIDE)
+				continue;
+
+			if (node.IsLeaf()) {
+				function(node.userData);
+			} else if (overlap == INSIDE) {
+				ReportAll(index, function);
+			} else {
+				MVE_ASSERT(count + 2 <= MAX_STACK, "BVH is too deep to traverse");
+				stack[count++] = node.child1;
+				stack[count++] = node.child2;
+			}
+		}
+	}
+
+	template<typename Function>
+	void ReportAll(int32_t subtree, Function&& function) const
+	{
+		std::array<int32_t, MAX_STACK> stack;
+		uint32_t count = 0;
+		stack[count++] = subtree;
+		while (count > 0) {
+			const Node& node = nodes[stack[--count]];
+			if (node.IsLeaf()) {
+				function(node.userData);
+				continue;
+			}
+			MVE_ASSERT(count + 2 <= MAX_STACK, "BVH is too deep to traverse");
+			stack[count++] = node.child1;
+			stack[count++] = node.child2;
+		}
+	}
+
+	int32_t AllocateNode();
+	void FreeNode(int32_t index);
+	void InsertLeaf(int32_t leaf);
+	void RemoveLeaf(int32_t leaf);
+	// Refits the boxes and heights from index up to the root, rotating unbalanced nodes on the way
+	void RefitAncestors(int32_t index);
+	// Rotates a child of index up when its subtrees' heights differ by more than one, returns the subtree's new root
+	int32_t Balance(int32_t index);
+
+  private:
+	float margin;
+	std::vector<Node> nodes;
+	int32_t root	  = NULL_NODE;
+	int32_t freeList  = NULL_NODE;
+	size_t proxyCount = 0;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -3,90 +3,162 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
-// TODO: remove model from game object into a seperate component.
 #include "moduels/render3d/MaterialSystem.h"
 #include "moduels/render3d/Model.h"
 
+#include "Registry.h"
+#include "TransformSystem.h"
+
 namespace MVE
 {
-struct TransformComponent
+/// Translation, rotation and scale relative to the parent, or to the world if there is none. The matrices are cached
+/// and only rebuilt by TransformSystem::Update when the transform or one of its ancestors changed.
+class TransformComponent
 {
+  public:
+	const glm::vec3& GetTranslation() const { return translation; }
+	const glm::quat& GetRotation() const { return rotation; }
+	const glm::vec3& GetScale() const { return scale; }
+
+	void SetTranslation(const glm::vec3& value)
+	{
+		translation = value;
+		dirty		= true;
+	}
+	void SetRotation(const glm::quat& value)
+	{
+		rotation = value;
+		dirty	 = true;
+	}
+	void SetScale(const glm::vec3& value)
+	{
+		scale = value;
+		dirty = true;
+	}
+
+	// Valid after the transform system's update
+	const glm::mat4& LocalMatrix() const { return localMatrix; }
+	const glm::mat4& WorldMatrix() const { return worldMatrix; }
+	const glm::mat3& NormalMatrix() const { return normalMatrix; }
+	// Changes whenever the world matrix does, cheaper to compare than the matrix
+	uint32_t Version() const { return version; }
+
+	glm::vec3 Forward() const { return glm::rotate(rotation, glm::vec3 {0.0, 0.0, -1.0}); }
+	glm::vec3 Back() const { return -Forward(); }
+	glm::vec3 Right() const { return glm::rotate(rotation, glm::vec3 {1.0, 0.0, 0.0}); }
+	glm::vec3 Left() const { return -Right(); }
+	glm::vec3 Up() const { return glm::rotate(rotation, glm::vec3 {0.0, 1.0, 0.0}); }
+	glm::vec3 Down() const { return -Up(); }
+
+  private:
+	friend class TransformSystem;
+
 	glm::vec3 translation {};
 	glm::vec3 scale {1.0f, 1.0f, 1.0f};
 	glm::quat rotation {1.0f, 0.0f, 0.0f, 0.0f};
 
-	glm::mat4 Mat4();
-	glm::mat3 NormalMatrix();
+	glm::mat4 localMatrix {1.0f};
+	glm::mat4 worldMatrix {1.0f};
+	glm::mat3 normalMatrix {1.0f};
+	uint32_t version = 0; // Incremented every time worldMatrix changes
+	bool dirty		 = true;
+};
+
+// Only entities that have a parent have this component, so roots can be updated without looking at the hierarchy
+struct ParentComponent
+{
+	Entity parent		   = NULL_ENTITY;
+	uint32_t parentVersion = UINT32_MAX; // Version of the parent's world matrix ours was built from
+};
+
+// Replace the component instead of assigning its model. GPU culling only looks at a renderable again when it moved or
+// one of its components was added or removed.
+struct MeshRendererComponent
+{
+	std::shared_ptr<Model> model;
+};
 
-	glm::vec3 Forward() { return glm::rotate(rotation, glm::vec3 {0.0, 0.0, -1.0}); }
-	glm::vec3 Back() { return -Forward(); }
-	glm::vec3 Right() { return glm::rotate(rotation, glm::vec3 {1.0, 0.0, 0.0}); }
-	glm::vec3 Left() { return -Right(); }
-	glm::vec3 Up() { return glm::rotate(rotation, glm::vec3 {0.0, 1.0, 0.0}); }
-	glm::vec3 Down() { return -Up(); }
+// Replaced like MeshRendererComponent
+struct MaterialComponent
+{
+	MaterialId id = NULL_HANDLE; // The default material, MaterialSystem::Resolve turns it into its real id
 };
 
 struct PointLightComponent
 {
 	float lightIntensity = 1.0f;
+	glm::vec3 color {1.0f};
+	float range = 0.0f; // Distance where the light fades out, 0 derives it from the intensity
 };
 
 struct DirectionalLightComponent
 {
 	float lightIntensity = 1.0f;
+	glm::vec3 color {1.0f};
 };
 
+/// Handle to an entity in a Registry, for code that builds scenes one object at a time. Systems should iterate the
+/// registry's views instead.
 class GameObject
 {
   public:
-	using id_t = uint32_t;
-	using Map  = std::unordered_map<id_t, GameObject>;
+	using id_t = Entity;
 
   public:
-	static GameObject Create()
+	// Every game object has a transform
+	static GameObject Create(Registry& registry)
 	{
-		static id_t nextId = 0;
-		return GameObject(nextId++);
+		GameObject object(registry, registry.Create());
+		object.Add<TransformComponent>();
+		return object;
 	}
-	static GameObject CreatePointLight(float intensity = 10.0f, float radius = 0.1f, glm::vec3 color = glm::vec3 {1.0})
+	static GameObject CreatePointLight(Registry& registry, float intensity = 10.0f, float radius = 0.1f,
+									   glm::vec3 color = glm::vec3 {1.0})
 	{
-		auto light			  = Create();
-		light.pointLight	  = std::make_unique<PointLightComponent>(intensity);
-		light.color			  = color;
-		light.transform.scale = glm::vec3(radius);
+		auto light = Create(registry);
+		light.Add<PointLightComponent>(intensity, color);
+		light.Transform().SetScale(glm::vec3(radius));
 		return light;
 	}
-	static GameObject CreateDirectionalLight(float intensity = 10.0f, glm::vec3 color = glm::vec3 {1.0})
+	static GameObject CreateDirectionalLight(Registry& registry, float intensity = 10.0f,
+											 glm::vec3 color = glm::vec3 {1.0})
 	{
-		auto light			   = Create();
-		light.directionalLight = std::make_unique<DirectionalLightComponent>(intensity);
-		light.color			   = color;
+		auto light = Create(registry);
+		light.Add<DirectionalLightComponent>(intensity, color);
 		return light;
 	}
 
-  private:
-	GameObject(id_t objId): id(objId) {}
-
   public:
-	GameObject(const GameObject&)		= delete;
-	void operator=(const GameObject&)	= delete;
-	GameObject(GameObject&&)			= default;
-	GameObject& operator=(GameObject&&) = default;
+	GameObject(Registry& registry, id_t objId): registry(&registry), id(objId) {}
 
-	~GameObject() {}
+	template<typename T, typename... Args>
+	T& Add(Args&&... args)
+	{
+		return registry->Emplace<T>(id, std::forward<Args>(args)...);
+	}
+	template<typename T>
+	T& Get()
+	{
+		return registry->Get<T>(id);
+	}
+	template<typename T>
+	bool Has()
+	{
+		return registry->Has<T>(id);
+	}
 
-	id_t getId() const { return id; }
+	TransformComponent& Transform() { return Get<TransformComponent>(); }
+	// Attaches this object to parent, whose world matrix then applies on top of ours
+	void SetParent(const GameObject& parent) { TransformSystem::SetParent(*registry, id, parent.id); }
 
-  public:
-	std::shared_ptr<Model> model;
-	MaterialId materialId = 0;
+	// Removes the object and all of its components, other handles to it stop validating
+	void Destroy() { registry->Destroy(id); }
+	bool IsValid() const { return registry->IsValid(id); }
 
-	glm::vec3 color {1.0f};
-	TransformComponent transform {};
-	std::unique_ptr<PointLightComponent> pointLight				= nullptr;
-	std::unique_ptr<DirectionalLightComponent> directionalLight = nullptr;
+	id_t getId() const { return id; }
 
   private:
+	Registry* registry;
 	id_t id;
 };
 
@@ -12,6 +12,9 @@ static GLFWwindow* GetGLFWwindow()
 
 bool Input::GetKey(KeyCode::KeyCode key)
 {
+	if (GetGLFWwindow() == nullptr)
+		return false;
+
 	auto state = glfwGetKey(GetGLFWwindow(), key);
 	return state == GLFW_PRESS || state == GLFW_REPEAT;
 }
@@ -32,11 +35,17 @@ glm::vec2 Input::GetVector(KeyCode::KeyCode negativeX, KeyCode::KeyCode positive
 
 bool Input::GetMouseButton(int button)
 {
+	if (GetGLFWwindow() == nullptr)
+		return false;
+
 	return glfwGetMouseButton(GetGLFWwindow(), button) == GLFW_PRESS;
 }
 
 glm::vec2 Input::GetMousePosition()
 {
+	if (GetGLFWwindow() == nullptr)
+		return {};
+
 	double x, y;
 	glfwGetCursorPos(GetGLFWwindow(), &x, &y);
 	return {x, y};
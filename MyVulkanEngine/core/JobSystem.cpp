@@ -0,0 +1,304 @@
+#include "JobSystem.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace MVE
+{
+
+namespace
+{
+struct Job
+{
+	JobSystem::JobFunction function;
+	JobCounter* counter;
+};
+
+// A lock per deque is cheap next to the size of the jobs the engine runs, and keeps stealing simple
+struct alignas(64) WorkQueue
+{
+	std::mutex mutex;
+	std::deque<Job> jobs;
+};
+
+std::vector<std::unique_ptr<WorkQueue>> s_Queues;
+WorkQueue s_BackgroundQueue; // Run in the order they were queued
+std::vector<std::thread> s_Workers;
+std::vector<std::string> s_WorkerNames;
+
+std::atomic<bool> s_Running {false};
+std::atomic<uint32_t> s_QueuedJobs {0};
+std::atomic<uint32_t> s_NextQueue {0};
+
+// Idle workers sleep here. s_QueuedJobs is checked under the mutex, so a push can't slip between check and wait.
+std::mutex s_WakeMutex;
+std::condition_variable s_WakeCondition;
+
+thread_local uint32_t t_ThreadIndex = JobSystem::INVALID_THREAD_INDEX;
+
+void Push(Job job)
+{
+	// Threads outside the system don't own a queue, their jobs are spread over all of them
+	uint32_t index = t_ThreadIndex;
+	if (index == JobSystem::INVALID_THREAD_INDEX)
+		index = s_NextQueue.fetch_add(1, std::memory_order_relaxed) % s_Queues.size();
+
+	// Counted before the job is visible, so a thief taking it right away never drops the count below 0
+	s_QueuedJobs.fetch_add(1, std::memory_order_relaxed);
+
+	auto& queue = *s_Queues[index];
+	std::lock_guard lock(queue.mutex);
+	queue.jobs.push_back(std::move(job));
+}
+
+void WakeWorkers(bool all)
+{
+	{
+		std::lock_guard lock(s_WakeMutex);
+	}
+	if (all)
+		s_WakeCondition.notify_all();
+	else
+		s_WakeCondition.notify_one();
+}
+
+bool TryPop(uint32_t index, bool background, Job& job)
+{
+	if (s_QueuedJobs.load(std::memory_order_acquire) == 0)
+		return false;
+
+	// Newest job from our own queue first, its data is most likely still in cache
+	if (index != JobSystem::INVALID_THREAD_INDEX) {
+		auto& queue = *s_Queues[index];
+		std::lock_guard lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			s_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// Otherwise steal the oldest job of another thread, every thread starts at a different victim
+	uint32_t queueCount = s_Queues.size();
+	uint32_t start		= index == JobSystem::INVALID_THREAD_INDEX ? 0 : index + 1;
+	for (uint32_t i = 0; i < queueCount; i++) {
+		auto& queue = *s_Queues[(start + i) % queueCount];
+		std::lock_guard lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			s_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// Background jobs last, so waiting threads are helped first
+	if (background) {
+		std::lock_guard lock(s_BackgroundQueue.mutex);
+		if (!s_BackgroundQueue.jobs.empty()) {
+			job = std::move(s_BackgroundQueue.jobs.front());
+			s_BackgroundQueue.jobs.pop_front();
+			s_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+} // namespace
+
+void JobSystem::Init(uint32_t workerCount)
+{
+	MVE_ASSERT(!s_Running, "JobSystem is already running");
+
+	if (workerCount == 0)
+		workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	t_ThreadIndex = 0;
+
+	s_Queues.clear();
+	for (uint32_t i = 0; i < workerCount + 1; i++) { s_Queues.push_back(std::make_unique<WorkQueue>()); }
+
+	// The profiler keeps pointers to the names, so they are all created before any worker starts
+	s_WorkerNames.clear();
+	for (uint32_t i = 1; i <= workerCount; i++) { s_WorkerNames.push_back("Worker " + std::to_string(i)); }
+
+	s_Running = true;
+	for (uint32_t i = 1; i <= workerCount; i++) { s_Workers.emplace_back(WorkerMain, i); }
+
+	MVE_INFO("JobSystem started with {} worker threads", workerCount);
+}
+
+void JobSystem::Shutdown()
+{
+	if (!s_Running)
+		return;
+
+	// Run whatever is left so nobody waits on a counter forever
+	while (TryRunJob(true)) {}
+
+	s_Running = false;
+	WakeWorkers(true);
+	for (auto& worker : s_Workers) { worker.join(); }
+
+	s_Workers.clear();
+	s_Queues.clear();
+}
+
+void JobSystem::Run(JobFunction function, JobCounter* counter)
+{
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	Schedule(std::move(function), counter);
+}
+
+void JobSystem::RunBackground(JobFunction function, JobCounter* counter)
+{
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+	if (!s_Running) {
+		function();
+		Finish(counter);
+		return;
+	}
+
+	s_QueuedJobs.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard lock(s_BackgroundQueue.mutex);
+		s_BackgroundQueue.jobs.push_back({std::move(function), counter});
+	}
+	WakeWorkers(false);
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, JobFunction function, JobCounter* counter)
+{
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		std::lock_guard lock(dependency.mutex);
+		if (!dependency.IsDone()) {
+			dependency.continuations.push_back({std::move(function), counter});
+			return;
+		}
+	}
+	Schedule(std::move(function), counter);
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, RangeJobFunction function, JobCounter& counter)
+{
+	if (count == 0)
+		return;
+
+	batchSize			= std::max(batchSize, 1u);
+	uint32_t batchCount = (count + batchSize - 1) / batchSize;
+	counter.pending.fetch_add(batchCount, std::memory_order_relaxed);
+
+	// Shared by all batches instead of copying the function and its captures into every job
+	auto shared = std::make_shared<RangeJobFunction>(std::move(function));
+	for (uint32_t begin = 0; begin < count; begin += batchSize) {
+		uint32_t end = std::min(begin + batchSize, count);
+		auto batch	 = [shared, begin, end] { (*shared)(begin, end); };
+
+		if (s_Running) {
+			Push({std::move(batch), &counter});
+		} else {
+			batch();
+			Finish(&counter);
+		}
+	}
+
+	if (s_Running)
+		WakeWorkers(batchCount > 1);
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const RangeJobFunction& function)
+{
+	JobCounter counter;
+	ParallelFor(count, batchSize, function, counter);
+	Wait(counter);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	MVE_PROFILE_FUNCTION();
+
+	// The main thread leaves the background jobs to the workers, it may be inside a frame
+	bool background = t_ThreadIndex != 0;
+	while (!counter.IsDone()) {
+		if (!TryRunJob(background))
+			std::this_thread::yield();
+	}
+
+	// The thread that finished the last job may still hold the counter's lock. Once we got it, that thread is done
+	// with the counter and it can be destroyed.
+	std::lock_guard lock(counter.mutex);
+}
+
+uint32_t JobSystem::ThreadCount()
+{
+	return s_Running ? s_Queues.size() : 1;
+}
+
+uint32_t JobSystem::ThreadIndex()
+{
+	return t_ThreadIndex;
+}
+
+void JobSystem::Schedule(JobFunction function, JobCounter* counter)
+{
+	// Without workers everything still works, just on the calling thread
+	if (!s_Running) {
+		function();
+		Finish(counter);
+		return;
+	}
+
+	Push({std::move(function), counter});
+	WakeWorkers(false);
+}
+
+void JobSystem::Finish(JobCounter* counter)
+{
+	if (counter == nullptr)
+		return;
+
+	std::vector<JobCounter::Continuation> ready;
+	{
+		std::lock_guard lock(counter->mutex);
+		if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			ready.swap(counter->continuations);
+	}
+	for (auto& continuation : ready) { Schedule(std::move(continuation.function), continuation.counter); }
+}
+
+bool JobSystem::TryRunJob(bool background)
+{
+	Job job;
+	if (!TryPop(t_ThreadIndex, background, job))
+		return false;
+
+	job.function();
+	Finish(job.counter);
+	return true;
+}
+
+void JobSystem::WorkerMain(uint32_t index)
+{
+	t_ThreadIndex = index;
+	Profiler::SetThreadName(s_WorkerNames[index - 1].c_str());
+
+	while (s_Running.load(std::memory_order_acquire)) {
+		if (TryRunJob(true))
+			continue;
+
+		std::unique_lock lock(s_WakeMutex);
+		s_WakeCondition.wait(lock, [] {
+			return s_QueuedJobs.load(std::memory_order_acquire) > 0 || !s_Running.load(std::memory_order_acquire);
+		});
+	}
+}
+
+} // namespace MVE
\ No newline at end of file
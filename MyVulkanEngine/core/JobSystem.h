@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace MVE
+{
+
+/// Counts the unfinished jobs that were started with it. Jobs can be made to wait for a counter with
+/// JobSystem::RunAfter, and a thread can wait for one with JobSystem::Wait, which must be called before the counter is
+/// destroyed.
+class JobCounter
+{
+  public:
+	JobCounter() = default;
+
+	JobCounter(const JobCounter&)	  = delete;
+	void operator=(const JobCounter&) = delete;
+
+	bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+  private:
+	friend class JobSystem;
+
+	struct Continuation
+	{
+		std::function<void()> function;
+		JobCounter* counter;
+	};
+
+	std::atomic<uint32_t> pending {0};
+	std::mutex mutex; // Guards continuations and the transition of pending to 0
+	std::vector<Continuation> continuations;
+};
+
+/// Fixed pool of worker threads, one less than the number of hardware threads, so together with the main thread every
+/// core is busy. Every thread has its own deque: it pushes and pops jobs at the back, and threads that run out of work
+/// steal the oldest jobs from the front of the others. Threads waiting for a counter run jobs instead of blocking.
+/// Background jobs go into a queue of their own that only the workers take from, so the main thread never picks one
+/// up while it waits inside a frame.
+class JobSystem
+{
+  public:
+	using JobFunction	   = std::function<void()>;
+	using RangeJobFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+	static constexpr uint32_t INVALID_THREAD_INDEX = UINT32_MAX;
+
+	// Must be called from the main thread. workerCount 0 uses one worker per hardware thread besides the main one.
+	static void Init(uint32_t workerCount = 0);
+	static void Shutdown();
+
+	// Runs function on any thread. counter, if given, is done once the job finished.
+	static void Run(JobFunction function, JobCounter* counter = nullptr);
+	// Like Run, but never on the main thread. For long jobs, like pipeline compiles and asset loads, that would stall
+	// the frame the main thread is waiting in.
+	static void RunBackground(JobFunction function, JobCounter* counter = nullptr);
+	// Like Run, but the job doesn't start before dependency is done
+	static void RunAfter(JobCounter& dependency, JobFunction function, JobCounter* counter = nullptr);
+
+	// Splits [0, count) into batches of at most batchSize indices and runs function once per batch
+	static void ParallelFor(uint32_t count, uint32_t batchSize, RangeJobFunction function, JobCounter& counter);
+	// Blocking version, the calling thread helps until every batch finished
+	static void ParallelFor(uint32_t count, uint32_t batchSize, const RangeJobFunction& function);
+
+	// Runs other jobs on the calling thread until counter is done
+	static void Wait(JobCounter& counter);
+
+	// Number of threads that run jobs, including the main thread
+	static uint32_t ThreadCount();
+	// 0 for the main thread, 1 to ThreadCount() - 1 for workers and INVALID_THREAD_INDEX for any other thread.
+	// Useful for indexing per-thread data.
+	static uint32_t ThreadIndex();
+
+  private:
+	// Queues a job whose counter was already incremented
+	static void Schedule(JobFunction function, JobCounter* counter);
+	static void Finish(JobCounter* counter);
+	// Background jobs are only taken if background is true
+	static bool TryRunJob(bool background);
+	static void WorkerMain(uint32_t index);
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "Profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+namespace MVE
+{
+
+namespace
+{
+constexpr uint32_t EVENTS_PER_CHUNK = 4096;
+
+// Written only by the owning thread. count is published with release so the session writer can read every event
+// below it without locking, and full chunks are never touched again.
+struct EventChunk
+{
+	Profiler::Event events[EVENTS_PER_CHUNK];
+	std::atomic<uint32_t> count {0};
+	std::atomic<EventChunk*> next {nullptr};
+};
+
+struct ThreadBuffer
+{
+	EventChunk* head = new EventChunk();
+	EventChunk* tail = head;
+	uint32_t threadId;
+	std::atomic<const char*> name {nullptr};
+	ThreadBuffer* next = nullptr;
+};
+
+std::atomic<ThreadBuffer*> s_Buffers {nullptr};
+std::atomic<uint32_t> s_NextThreadId {0};
+
+std::mutex s_SessionMutex;
+std::string s_SessionPath;
+uint64_t s_SessionStart = 0;
+
+// Buffers are kept for the lifetime of the process so events from threads that already exited still get written.
+ThreadBuffer* CreateBuffer()
+{
+	auto b		= new ThreadBuffer();
+	b->threadId = s_NextThreadId.fetch_add(1, std::memory_order_relaxed);
+	b->next		= s_Buffers.load(std::memory_order_relaxed);
+	while (!s_Buffers.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed)) {}
+	return b;
+}
+
+ThreadBuffer& GetThreadBuffer()
+{
+	thread_local ThreadBuffer* buffer = CreateBuffer();
+	return *buffer;
+}
+
+ThreadBuffer& GetGpuBuffer()
+{
+	static ThreadBuffer* buffer = [] {
+		auto b = CreateBuffer();
+		b->name.store("GPU", std::memory_order_relaxed);
+		return b;
+	}();
+	return *buffer;
+}
+
+ThreadBuffer& GetComputeBuffer()
+{
+	static ThreadBuffer* buffer = [] {
+		auto b = CreateBuffer();
+		b->name.store("GPU Compute", std::memory_order_relaxed);
+		return b;
+	}();
+	return *buffer;
+}
+
+void PushEvent(ThreadBuffer& buffer, const Profiler::Event& event)
+{
+	uint32_t index = buffer.tail->count.load(std::memory_order_relaxed);
+	if (index == EVENTS_PER_CHUNK) {
+		auto chunk = new EventChunk();
+		buffer.tail->next.store(chunk, std::memory_order_release);
+		buffer.tail = chunk;
+		index		= 0;
+	}
+
+	buffer.tail->events[index] = event;
+	buffer.tail->count.store(index + 1, std::memory_order_release);
+}
+
+void WriteEscaped(std::ofstream& out, const char* str)
+{
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			out << '\\';
+		out << *str;
+	}
+}
+
+// Trace timestamps are in microseconds. Written from the integer nanoseconds so they stay exact however long the
+// session runs, a double with the stream's default precision rounds them to 10 us after a second.
+void WriteMicroseconds(std::ofstream& out, uint64_t nanoseconds)
+{
+	out << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+}
+} // namespace
+
+void Profiler::BeginSession(const std::string& filePath)
+{
+	std::lock_guard lock(s_SessionMutex);
+	if (recording) {
+		MVE_WARN("Profiler session already in progress, writing to {}", s_SessionPath);
+		return;
+	}
+
+	s_SessionPath  = filePath;
+	s_SessionStart = Now();
+	recording	   = true;
+}
+
+void Profiler::EndSession()
+{
+	std::lock_guard lock(s_SessionMutex);
+	if (!recording)
+		return;
+
+	recording			= false;
+	uint64_t sessionEnd = Now();
+
+	std::ofstream out(s_SessionPath);
+	if (!out) {
+		MVE_ERROR("Failed to open profiler output file {}", s_SessionPath);
+		return;
+	}
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first		 = true;
+	size_t numEvents = 0;
+	auto separator	 = [&]() -> std::ofstream& {
+		  if (!first)
+			  out << ",";
+		  first = false;
+		  return out;
+	};
+
+	for (auto b = s_Buffers.load(std::memory_order_acquire); b != nullptr; b = b->next) {
+		if (auto name = b->name.load(std::memory_order_relaxed)) {
+			separator() << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << b->threadId
+						<< ",\"args\":{\"name\":\"";
+			WriteEscaped(out, name);
+			out << "\"}}";
+		}
+
+		for (auto chunk = b->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire)) {
+			uint32_t count = chunk->count.load(std::memory_order_acquire);
+			for (uint32_t i = 0; i < count; i++) {
+				auto& e = chunk->events[i];
+				if (e.start < s_SessionStart || e.end > sessionEnd)
+					continue;
+
+				separator() << "\n{\"ph\":\"X\",\"name\":\"";
+				WriteEscaped(out, e.name);
+				out << "\",\"pid\":0,\"tid\":" << b->threadId << ",\"ts\":";
+				WriteMicroseconds(out, e.start - s_SessionStart);
+				out << ",\"dur\":";
+				WriteMicroseconds(out, e.end - e.start);
+				out << "}";
+				numEvents++;
+			}
+		}
+	}
+	out << "\n]}";
+
+	MVE_INFO("Wrote {} profiler events to {}", numEvents, s_SessionPath);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	GetThreadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+void Profiler::RecordEvent(const char* name, uint64_t start, uint64_t end)
+{
+	PushEvent(GetThreadBuffer(), {name, start, end});
+}
+
+void Profiler::RecordGpuEvent(const char* name, uint64_t start, uint64_t end)
+{
+	PushEvent(GetGpuBuffer(), {name, start, end});
+}
+
+void Profiler::RecordComputeEvent(const char* name, uint64_t start, uint64_t end)
+{
+	PushEvent(GetComputeBuffer(), {name, start, end});
+}
+
+uint64_t Profiler::Now()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace MVE
\ No newline at end of file
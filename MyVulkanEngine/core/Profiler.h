@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace MVE
+{
+
+/// Hierarchical CPU scope profiler. Scopes are recorded into per-thread buffers that only their owning thread writes
+/// to, so recording never takes a lock. EndSession writes everything recorded since BeginSession as Chrome trace JSON,
+/// which can be opened in chrome://tracing or ui.perfetto.dev.
+class Profiler
+{
+  public:
+	struct Event
+	{
+		const char* name; // Must outlive the session, scope names are expected to be string literals
+		uint64_t start;	  // Nanoseconds, see Now()
+		uint64_t end;
+	};
+
+	static void BeginSession(const std::string& filePath);
+	static void EndSession();
+	static bool IsRecording() { return recording.load(std::memory_order_relaxed); }
+
+	static void SetThreadName(const char* name);
+	static void RecordEvent(const char* name, uint64_t start, uint64_t end);
+	// Events on the "GPU" track. Timestamps must already be converted to the CPU clock, and only one thread may
+	// record GPU events.
+	static void RecordGpuEvent(const char* name, uint64_t start, uint64_t end);
+	// Events on the "GPU Compute" track, for work on the async compute queue that overlaps the frames. Timestamps are
+	// on the CPU clock as well, and calls from different threads must not overlap.
+	static void RecordComputeEvent(const char* name, uint64_t start, uint64_t end);
+
+	static uint64_t Now();
+
+  private:
+	inline static std::atomic<bool> recording = false;
+};
+
+class ProfileScope
+{
+  public:
+	ProfileScope(const char* name): name(name), start(Profiler::IsRecording() ? Profiler::Now() : 0) {}
+	~ProfileScope()
+	{
+		if (start != 0 && Profiler::IsRecording())
+			Profiler::RecordEvent(name, start, Profiler::Now());
+	}
+
+	ProfileScope(const ProfileScope&)	= delete;
+	void operator=(const ProfileScope&) = delete;
+
+  private:
+	const char* name;
+	uint64_t start;
+};
+
+} // namespace MVE
+
+// clang-format off
+#ifdef MVE_ENABLE_PROFILING
+	#define MVE_PROFILE_CONCAT_IMPL(a, b) a##b
+	#define MVE_PROFILE_CONCAT(a, b) MVE_PROFILE_CONCAT_IMPL(a, b)
+	#define MVE_PROFILE_SCOPE(name) ::MVE::ProfileScope MVE_PROFILE_CONCAT(profileScope, __LINE__)(name)
+	#define MVE_PROFILE_FUNCTION() MVE_PROFILE_SCOPE(__func__)
+#else
+	#define MVE_PROFILE_SCOPE(name)
+	#define MVE_PROFILE_FUNCTION()
+#endif
+// clang-format on
\ No newline at end of file
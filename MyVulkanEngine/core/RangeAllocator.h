@@ -0,0 +1,81 @@
+#pragma once
+
+namespace MVE
+{
+
+/// First fit allocator of ranges inside [0, capacity), for sub-allocating big buffers. Free ranges are kept sorted by
+/// offset and merged with their neighbours when freed, so the space fragments only while ranges are alive.
+class RangeAllocator
+{
+  public:
+	static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+	explicit RangeAllocator(uint64_t capacity = 0): capacity(capacity), freeSize(capacity)
+	{
+		if (capacity > 0)
+			freeRanges.emplace(0, capacity);
+	}
+
+	// Returns INVALID_OFFSET when no free range is big enough. alignment has to be a power of two.
+	uint64_t Allocate(uint64_t size, uint64_t alignment = 1)
+	{
+		MVE_ASSERT(size > 0 && (alignment & (alignment - 1)) == 0, "Invalid allocation of {} bytes aligned to {}",
+				   size, alignment);
+
+		for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+			auto [offset, rangeSize] = *it;
+			uint64_t aligned		 = (offset + alignment - 1) & ~(alignment - 1);
+			if (aligned + size > offset + rangeSize)
+				continue;
+
+			// The padding in front and the rest behind stay free
+			freeRanges.erase(it);
+			if (aligned > offset)
+				freeRanges.emplace(offset, aligned - offset);
+			if (aligned + size < offset + rangeSize)
+				freeRanges.emplace(aligned + size, offset + rangeSize - aligned - size);
+
+			freeSize -= size;
+			return aligned;
+		}
+		return INVALID_OFFSET;
+	}
+
+	void Free(uint64_t offset, uint64_t size)
+	{
+		MVE_ASSERT(offset + size <= capacity, "Range {}+{} is outside the allocator", offset, size);
+		freeSize += size;
+
+		auto next = freeRanges.lower_bound(offset);
+		if (next != freeRanges.begin()) {
+			auto previous = std::prev(next);
+			MVE_ASSERT(previous->first + previous->second <= offset, "Range at {} was freed twice", offset);
+			if (previous->first + previous->second == offset) {
+				offset = previous->first;
+				size += previous->second;
+				freeRanges.erase(previous);
+			}
+		}
+		if (next != freeRanges.end()) {
+			MVE_ASSERT(offset + size <= next->first, "Range at {} was freed twice", offset);
+			if (offset + size == next->first) {
+				size += next->second;
+				freeRanges.erase(next);
+			}
+		}
+		freeRanges.emplace(offset, size);
+	}
+
+	uint64_t Capacity() const { return capacity; }
+	uint64_t FreeSize() const { return freeSize; }
+	uint64_t UsedSize() const { return capacity - freeSize; }
+	// Number of separate free ranges, 1 means the free space is in one piece
+	size_t FreeRangeCount() const { return freeRanges.size(); }
+
+  private:
+	uint64_t capacity;
+	uint64_t freeSize;
+	std::map<uint64_t, uint64_t> freeRanges; // Offset -> size
+};
+
+} // namespace MVE
\ No newline at end of file
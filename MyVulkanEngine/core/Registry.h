@@ -0,0 +1,241 @@
+#pragma once
+
+#include "SlotMap.h"
+
+#include <atomic>
+#include <tuple>
+
+namespace MVE
+{
+
+// Generational handle, see Handle. Components are stored by the entity's slot index.
+using Entity				 = uint32_t;
+constexpr Entity NULL_ENTITY = NULL_HANDLE;
+
+class ComponentPoolBase
+{
+  public:
+	virtual ~ComponentPoolBase() = default;
+
+	virtual void Remove(Entity entity) = 0;
+
+	// Also checks the generation, a stale entity whose slot was reused doesn't match the new occupant's components
+	bool Contains(Entity entity) const
+	{
+		uint32_t index = Handle::Index(entity);
+		return index < sparse.size() && sparse[index] != INVALID_INDEX && entities[sparse[index]] == entity;
+	}
+	size_t Size() const { return entities.size(); }
+	const std::vector<Entity>& Entities() const { return entities; }
+	// Incremented whenever a component is added or removed, for systems that cache what they derive from the pool
+	uint32_t StructureVersion() const { return structureVersion; }
+
+  protected:
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	uint32_t structureVersion = 0;
+
+	std::vector<uint32_t> sparse; // Slot index -> index into the dense arrays
+	std::vector<Entity> entities; // Dense, entities[i] owns components[i]
+};
+
+/// Sparse set of one component type. Components are packed in a dense array, removing one moves the last component
+/// into its place, so pointers and references to components are only valid until the pool changes.
+template<typename T>
+class ComponentPool : public ComponentPoolBase
+{
+  public:
+	template<typename... Args>
+	T& Emplace(Entity entity, Args&&... args)
+	{
+		MVE_ASSERT(!Contains(entity), "Entity {:#x} already has this component", entity);
+
+		uint32_t index = Handle::Index(entity);
+		if (index >= sparse.size())
+			sparse.resize(index + 1, INVALID_INDEX);
+
+		sparse[index] = entities.size();
+		entities.push_back(entity);
+		structureVersion++;
+		return components.emplace_back(T {std::forward<Args>(args)...});
+	}
+
+	void Remove(Entity entity) override
+	{
+		if (!Contains(entity))
+			return;
+
+		uint32_t index = sparse[Handle::Index(entity)];
+		Entity last	   = entities.back();
+
+		if (index != entities.size() - 1) {
+			entities[index]				= last;
+			components[index]			= std::move(components.back());
+			sparse[Handle::Index(last)] = index;
+		}
+		sparse[Handle::Index(entity)] = INVALID_INDEX;
+
+		entities.pop_back();
+		components.pop_back();
+		structureVersion++;
+	}
+
+	T& Get(Entity entity)
+	{
+		MVE_ASSERT(Contains(entity), "Entity {:#x} doesn't have this component", entity);
+		return components[sparse[Handle::Index(entity)]];
+	}
+	T* TryGet(Entity entity) { return Contains(entity) ? &components[sparse[Handle::Index(entity)]] : nullptr; }
+
+	std::vector<T>& Data() { return components; }
+
+  private:
+	std::vector<T> components;
+};
+
+/// Iterates every entity that has all of the Components. The smallest pool drives the iteration and the others are
+/// only probed, so a view over a rare component is cheap no matter how many entities there are. Components must not be
+/// added or removed while iterating.
+template<typename... Components>
+class View
+{
+  public:
+	View(ComponentPool<Components>&... componentPools): pools(&componentPools...)
+	{
+		auto consider = [this](const ComponentPoolBase& pool) {
+			if (driver == nullptr || pool.Size() < driver->size())
+				driver = &pool.Entities();
+		};
+		(consider(componentPools), ...);
+	}
+
+	// function(Entity, Components&...)
+	template<typename Function>
+	void Each(Function&& function)
+	{
+		if constexpr (sizeof...(Components) == 1) {
+			// A single pool is already dense, no lookups needed
+			auto& pool		 = *std::get<0>(pools);
+			auto& components = pool.Data();
+			for (size_t i = 0; i < components.size(); i++) { function(pool.Entities()[i], components[i]); }
+		} else {
+			for (Entity entity : *driver) {
+				if ((std::get<ComponentPool<Components>*>(pools)->Contains(entity) && ...))
+					function(entity, std::get<ComponentPool<Components>*>(pools)->Get(entity)...);
+			}
+		}
+	}
+
+	// Upper bound of the number of entities in the view
+	size_t SizeHint() const { return driver->size(); }
+
+  private:
+	std::tuple<ComponentPool<Components>*...> pools;
+	const std::vector<Entity>* driver = nullptr;
+};
+
+/// Owns all entities and their components. An entity is only an id, all of its data lives in one pool per component
+/// type, so systems stream through contiguous arrays of exactly the components they need.
+class Registry
+{
+  public:
+	Registry() = default;
+
+	Registry(const Registry&)		= delete;
+	void operator=(const Registry&) = delete;
+
+	// Slots of destroyed entities are reused, so storage stays bounded by the peak number of live entities
+	Entity Create() { return entities.Allocate(); }
+
+	void Destroy(Entity entity)
+	{
+		if (!IsValid(entity))
+			return;
+
+		for (auto& pool : pools) {
+			if (pool)
+				pool->Remove(entity);
+		}
+		entities.Free(entity);
+	}
+
+	bool IsValid(Entity entity) const { return entities.IsValid(entity); }
+
+	template<typename T, typename... Args>
+	T& Emplace(Entity entity, Args&&... args)
+	{
+		return Pool<T>().Emplace(entity, std::forward<Args>(args)...);
+	}
+
+	template<typename T>
+	void Remove(Entity entity)
+	{
+		Pool<T>().Remove(entity);
+	}
+
+	template<typename T>
+	T& Get(Entity entity)
+	{
+		return Pool<T>().Get(entity);
+	}
+
+	template<typename T>
+	T* TryGet(Entity entity)
+	{
+		return Pool<T>().TryGet(entity);
+	}
+
+	template<typename T>
+	bool Has(Entity entity)
+	{
+		return Pool<T>().Contains(entity);
+	}
+
+	template<typename... Components>
+	MVE::View<Components...> View()
+	{
+		return MVE::View<Components...>(Pool<Components>()...);
+	}
+
+	template<typename T>
+	ComponentPool<T>& Pool()
+	{
+		uint32_t typeId = ComponentTypeId<T>();
+		if (typeId >= pools.size())
+			pools.resize(typeId + 1);
+		if (!pools[typeId])
+			pools[typeId] = std::make_unique<ComponentPool<T>>();
+		return static_cast<ComponentPool<T>&>(*pools[typeId]);
+	}
+
+	// One T per registry, created on first use, for what systems keep about the registry between frames
+	template<typename T>
+	T& Context()
+	{
+		uint32_t typeId = ComponentTypeId<T>();
+		if (typeId >= contexts.size())
+			contexts.resize(typeId + 1);
+		if (!contexts[typeId])
+			contexts[typeId] = std::make_shared<T>();
+		return *static_cast<T*>(contexts[typeId].get());
+	}
+
+	size_t EntityCount() const { return entities.Size(); }
+
+  private:
+	template<typename T>
+	static uint32_t ComponentTypeId()
+	{
+		static const uint32_t id = nextComponentTypeId.fetch_add(1, std::memory_order_relaxed);
+		return id;
+	}
+
+  private:
+	inline static std::atomic<uint32_t> nextComponentTypeId = 0;
+
+	std::vector<std::unique_ptr<ComponentPoolBase>> pools; // Indexed by ComponentTypeId
+	std::vector<std::shared_ptr<void>> contexts;		   // Indexed by ComponentTypeId too
+	HandleAllocator entities;
+};
+
+} // namespace MVE
\ No newline at end of file
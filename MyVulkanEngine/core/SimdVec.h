@@ -0,0 +1,72 @@
+#pragma once
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define MVE_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define MVE_SIMD_SSE
+#endif
+
+namespace MVE
+{
+
+/// Thin wrappers so SIMD kernels are written once for every register width, MSVC has no operators on intrinsic types.
+/// SimdVec is the widest register the build targets: AVX2 with MVE_ENABLE_AVX2, SSE on other x86 builds and ScalarVec
+/// everywhere else. Store expects an address aligned to 32 bytes.
+struct ScalarVec
+{
+	static constexpr size_t WIDTH = 1;
+	float v;
+
+	static ScalarVec Load(const float* p) { return {*p}; }
+	static ScalarVec Set(float f) { return {f}; }
+	void Store(float* p) const { *p = v; }
+
+	friend ScalarVec operator+(ScalarVec a, ScalarVec b) { return {a.v + b.v}; }
+	friend ScalarVec operator-(ScalarVec a, ScalarVec b) { return {a.v - b.v}; }
+	friend ScalarVec operator*(ScalarVec a, ScalarVec b) { return {a.v * b.v}; }
+	friend ScalarVec operator/(ScalarVec a, ScalarVec b) { return {a.v / b.v}; }
+	friend ScalarVec Min(ScalarVec a, ScalarVec b) { return {a.v < b.v ? a.v : b.v}; }
+	friend ScalarVec Max(ScalarVec a, ScalarVec b) { return {a.v > b.v ? a.v : b.v}; }
+};
+
+#if defined(MVE_SIMD_AVX2)
+struct SimdVec
+{
+	static constexpr size_t WIDTH = 8;
+	__m256 v;
+
+	static SimdVec Load(const float* p) { return {_mm256_loadu_ps(p)}; }
+	static SimdVec Set(float f) { return {_mm256_set1_ps(f)}; }
+	void Store(float* p) const { _mm256_store_ps(p, v); }
+
+	friend SimdVec operator+(SimdVec a, SimdVec b) { return {_mm256_add_ps(a.v, b.v)}; }
+	friend SimdVec operator-(SimdVec a, SimdVec b) { return {_mm256_sub_ps(a.v, b.v)}; }
+	friend SimdVec operator*(SimdVec a, SimdVec b) { return {_mm256_mul_ps(a.v, b.v)}; }
+	friend SimdVec operator/(SimdVec a, SimdVec b) { return {_mm256_div_ps(a.v, b.v)}; }
+	friend SimdVec Min(SimdVec a, SimdVec b) { return {_mm256_min_ps(a.v, b.v)}; }
+	friend SimdVec Max(SimdVec a, SimdVec b) { return {_mm256_max_ps(a.v, b.v)}; }
+};
+#elif defined(MVE_SIMD_SSE)
+struct SimdVec
+{
+	static constexpr size_t WIDTH = 4;
+	__m128 v;
+
+	static SimdVec Load(const float* p) { return {_mm_loadu_ps(p)}; }
+	static SimdVec Set(float f) { return {_mm_set1_ps(f)}; }
+	void Store(float* p) const { _mm_store_ps(p, v); }
+
+	friend SimdVec operator+(SimdVec a, SimdVec b) { return {_mm_add_ps(a.v, b.v)}; }
+	friend SimdVec operator-(SimdVec a, SimdVec b) { return {_mm_sub_ps(a.v, b.v)}; }
+	friend SimdVec operator*(SimdVec a, SimdVec b) { return {_mm_mul_ps(a.v, b.v)}; }
+	friend SimdVec operator/(SimdVec a, SimdVec b) { return {_mm_div_ps(a.v, b.v)}; }
+	friend SimdVec Min(SimdVec a, SimdVec b) { return {_mm_min_ps(a.v, b.v)}; }
+	friend SimdVec Max(SimdVec a, SimdVec b) { return {_mm_max_ps(a.v, b.v)}; }
+};
+#else
+using SimdVec = ScalarVec;
+#endif
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+namespace MVE
+{
+
+/// 32-bit generational handle: the low bits index a slot and the high bits hold that slot's generation when the handle
+/// was created. Freeing a slot bumps its generation, so every handle to the old occupant stops validating instead of
+/// aliasing whatever gets the slot next.
+class Handle
+{
+  public:
+	static constexpr uint32_t INDEX_BITS	  = 20;
+	static constexpr uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+	static constexpr uint32_t MAX_INDEX		  = (1u << INDEX_BITS) - 1;
+	static constexpr uint32_t MAX_GENERATION  = (1u << GENERATION_BITS) - 1;
+
+	static constexpr uint32_t Make(uint32_t index, uint32_t generation) { return generation << INDEX_BITS | index; }
+	static constexpr uint32_t Index(uint32_t handle) { return handle & MAX_INDEX; }
+	static constexpr uint32_t Generation(uint32_t handle) { return handle >> INDEX_BITS; }
+};
+
+// Live slots have generations from 1 up, so 0 is never a valid handle
+constexpr uint32_t NULL_HANDLE = 0;
+
+/// Hands out generational handles and recycles the slots of freed ones. Slots whose generation would wrap around are
+/// retired instead of reused, so a stale handle can never validate again.
+class HandleAllocator
+{
+  public:
+	uint32_t Allocate()
+	{
+		if (!freeList.empty()) {
+			uint32_t index = freeList.back();
+			freeList.pop_back();
+			liveCount++;
+			return Handle::Make(index, generations[index]);
+		}
+
+		uint32_t index = generations.size();
+		MVE_ASSERT(index <= Handle::MAX_INDEX, "Out of handles, at most {} can be alive", Handle::MAX_INDEX + 1);
+		generations.push_back(1);
+		liveCount++;
+		return Handle::Make(index, 1);
+	}
+
+	void Free(uint32_t handle)
+	{
+		if (!IsValid(handle))
+			return;
+
+		uint32_t index = Handle::Index(handle);
+		liveCount--;
+		if (generations[index] == Handle::MAX_GENERATION) {
+			generations[index] = 0; // Retired, matches no handle
+			return;
+		}
+		generations[index]++;
+		freeList.push_back(index);
+	}
+
+	bool IsValid(uint32_t handle) const
+	{
+		uint32_t index = Handle::Index(handle);
+		return index < generations.size() && generations[index] == Handle::Generation(handle);
+	}
+
+	size_t Size() const { return liveCount; }
+	// Number of slots ever used, the bound for anything indexed by Handle::Index
+	size_t Capacity() const { return generations.size(); }
+
+  private:
+	std::vector<uint32_t> generations;
+	std::vector<uint32_t> freeList;
+	size_t liveCount = 0;
+};
+
+/// Values addressed by generational handles. Lookups are O(1) and validated, and the values are kept in one dense array
+/// for iteration. Removing a value moves the last one into its place, so references are invalidated by any change.
+template<typename T>
+class SlotMap
+{
+  public:
+	template<typename... Args>
+	uint32_t Emplace(Args&&... args)
+	{
+		uint32_t handle = allocator.Allocate();
+		uint32_t index	= Handle::Index(handle);
+		if (index >= denseIndices.size())
+			denseIndices.resize(index + 1);
+
+		denseIndices[index] = values.size();
+		values.emplace_back(std::forward<Args>(args)...);
+		handles.push_back(handle);
+		return handle;
+	}
+
+	void Remove(uint32_t handle)
+	{
+		if (!Contains(handle))
+			return;
+
+		uint32_t dense		= denseIndices[Handle::Index(handle)];
+		uint32_t lastHandle = handles.back();
+
+		if (dense != values.size() - 1) {
+			values[dense]							= std::move(values.back());
+			handles[dense]							= lastHandle;
+			denseIndices[Handle::Index(lastHandle)] = dense;
+		}
+
+		values.pop_back();
+		handles.pop_back();
+		allocator.Free(handle);
+	}
+
+	bool Contains(uint32_t handle) const { return allocator.IsValid(handle); }
+
+	T& Get(uint32_t handle)
+	{
+		MVE_ASSERT(Contains(handle), "Invalid or stale handle {:#x}", handle);
+		return values[denseIndices[Handle::Index(handle)]];
+	}
+	const T& Get(uint32_t handle) const
+	{
+		MVE_ASSERT(Contains(handle), "Invalid or stale handle {:#x}", handle);
+		return values[denseIndices[Handle::Index(handle)]];
+	}
+	T* TryGet(uint32_t handle) { return Contains(handle) ? &values[denseIndices[Handle::Index(handle)]] : nullptr; }
+	const T* TryGet(uint32_t handle) const
+	{
+		return Contains(handle) ? &values[denseIndices[Handle::Index(handle)]] : nullptr;
+	}
+
+	size_t Size() const { return values.size(); }
+
+	// Dense arrays, Handles()[i] is the handle of Values()[i]
+	std::vector<T>& Values() { return values; }
+	const std::vector<uint32_t>& Handles() const { return handles; }
+
+  private:
+	HandleAllocator allocator;
+	std::vector<uint32_t> denseIndices; // Slot index -> index into values
+	std::vector<T> values;
+	std::vector<uint32_t> handles;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "SpatialIndex.h"
+
+#include "GameObject.h"
+
+namespace MVE
+{
+
+template<typename BoxFunction>
+void SpatialIndex::Sync(Bvh& tree, std::vector<Proxy>& proxies, Entity entity, uint32_t version, const void* shape,
+						BoxFunction&& boxFunction)
+{
+	uint32_t index = Handle::Index(entity);
+	if (index >= proxies.size())
+		proxies.resize(index + 1);
+
+	auto& proxy	   = proxies[index];
+	proxy.lastSeen = frame;
+
+	if (proxy.entity != entity) {
+		// New entity, or a new one reusing the slot of a destroyed one that wasn't pruned yet
+		if (proxy.node != Bvh::NULL_NODE)
+			tree.Remove(proxy.node);
+		proxy.entity  = entity;
+		proxy.node	  = tree.Insert(boxFunction(), entity);
+		proxy.version = version;
+		proxy.shape	  = shape;
+		return;
+	}
+
+	if (proxy.version == version && proxy.shape == shape)
+		return;
+
+	tree.Move(proxy.node, boxFunction());
+	proxy.version = version;
+	proxy.shape	  = shape;
+}
+
+void SpatialIndex::Update(Registry& registry, bool updateRenderables)
+{
+	MVE_PROFILE_FUNCTION();
+	frame++;
+
+	size_t renderableCount = 0;
+	if (updateRenderables) {
+		registry.View<TransformComponent, MeshRendererComponent>().Each(
+			[&](Entity entity, TransformComponent& transform, MeshRendererComponent& meshRenderer) {
+				if (meshRenderer.model == nullptr)
+					return;
+
+				Sync(renderables, renderableProxies, entity, transform.Version(), meshRenderer.model.get(), [&]() {
+					return meshRenderer.model->GetBoundingBox().Transformed(transform.WorldMatrix());
+				});
+				renderableCount++;
+			});
+	}
+
+	size_t pointLightCount = 0;
+	registry.View<TransformComponent, PointLightComponent>().Each(
+		[&](Entity entity, TransformComponent& transform, PointLightComponent& light) {
+			Sync(pointLights, pointLightProxies, entity, transform.Version(), nullptr, [&]() {
+				Aabb box {};
+				box.Grow(transform.GetTranslation());
+				return box.Expanded(transform.GetScale().x);
+			});
+			pointLightCount++;
+		});
+
+	// Every synced entity has a proxy, so extra proxies belong to entities that are gone
+	if (updateRenderables && renderables.ProxyCount() != renderableCount)
+		Prune(renderables, renderableProxies);
+	if (pointLights.ProxyCount() != pointLightCount)
+		Prune(pointLights, pointLightProxies);
+}
+
+Entity SpatialIndex::Pick(Registry& registry, const Ray& ray, float maxDistance) const
+{
+	Entity closest = NULL_ENTITY;
+	renderables.RayCast(ray, maxDistance, [&](uint32_t entity, float) {
+		auto transform	  = registry.TryGet<TransformComponent>(entity);
+		auto meshRenderer = registry.TryGet<MeshRendererComponent>(entity);
+		if (transform == nullptr || meshRenderer == nullptr || meshRenderer->model == nullptr)
+			return maxDistance;
+
+		// The fat box was hit, check the model's own box
+		float distance;
+		auto box = meshRenderer->model->GetBoundingBox().Transformed(transform->WorldMatrix());
+		if (box.Intersects(ray, maxDistance, distance)) {
+			closest		= entity;
+			maxDistance = distance;
+		}
+		return maxDistance;
+	});
+	return closest;
+}
+
+void SpatialIndex::Prune(Bvh& tree, std::vector<Proxy>& proxies)
+{
+	for (auto& proxy : proxies) {
+		if (proxy.node == Bvh::NULL_NODE || proxy.lastSeen == frame)
+			continue;
+
+		tree.Remove(proxy.node);
+		proxy = {};
+	}
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Bvh.h"
+#include "Registry.h"
+
+namespace MVE
+{
+
+/// BVHs over the renderable objects and point lights of a registry, so culling, light queries and picking don't have
+/// to visit every entity. Update only rebuilds the boxes of entities whose world matrix or model changed, and most of
+/// those stay inside their fat boxes.
+class SpatialIndex
+{
+  public:
+	SpatialIndex() = default;
+
+	SpatialIndex(const SpatialIndex&)	= delete;
+	void operator=(const SpatialIndex&) = delete;
+
+	// Call once per frame, after TransformSystem::Update. Also picks up created and destroyed entities. Without
+	// updateRenderables that tree is left as it is, for renderers that cull on the GPU.
+	void Update(Registry& registry, bool updateRenderables = true);
+
+	// The user data of both trees is the entity. Renderables are the objects with a MeshRendererComponent, bounded by
+	// their model's box, and point lights are bounded by their radius.
+	const Bvh& Renderables() const { return renderables; }
+	const Bvh& PointLights() const { return pointLights; }
+
+	// Closest renderable whose bounding box the ray hits, NULL_ENTITY if there is none
+	Entity Pick(Registry& registry, const Ray& ray, float maxDistance = std::numeric_limits<float>::max()) const;
+
+  private:
+	struct Proxy
+	{
+		Entity entity	  = NULL_ENTITY;
+		int32_t node	  = Bvh::NULL_NODE;
+		uint32_t version  = 0;		 // Transform version the box was built from
+		const void* shape = nullptr; // A different model needs a new box even if the transform didn't change
+		uint32_t lastSeen = 0;
+	};
+
+	// Inserts the entity's proxy or moves it when it changed, boxFunction() is only called then
+	template<typename BoxFunction>
+	void Sync(Bvh& tree, std::vector<Proxy>& proxies, Entity entity, uint32_t version, const void* shape,
+			  BoxFunction&& boxFunction);
+	// Removes the proxies of entities that weren't synced this frame
+	void Prune(Bvh& tree, std::vector<Proxy>& proxies);
+
+  private:
+	Bvh renderables;
+	Bvh pointLights;
+	std::vector<Proxy> renderableProxies; // Indexed by the entity's slot index
+	std::vector<Proxy> pointLightProxies;
+	uint32_t frame = 0;
+};
+
+} // namespace MVE
@@ -0,0 +1,199 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace MVE
+{
+
+TlsfAllocator::TlsfAllocator(uint64_t capacity): capacity(capacity), freeSize(capacity)
+{
+	heads.fill(INVALID_NODE);
+	if (capacity == 0)
+		return;
+
+	uint32_t node	 = CreateNode();
+	nodes[node].size = capacity;
+	InsertFree(node);
+}
+
+TlsfAllocator::Range TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	MVE_ASSERT(size > 0 && (alignment & (alignment - 1)) == 0, "Invalid allocation of {} bytes aligned to {}", size,
+			   alignment);
+
+	// Big enough for the worst case padding, so the node found always fits
+	uint32_t node = FindFree(size + alignment - 1);
+	if (node == INVALID_NODE)
+		return {};
+	RemoveFree(node);
+
+	// The padding in front and the rest behind go back to the free lists
+	uint64_t offset	 = nodes[node].offset;
+	uint64_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+	if (aligned > offset) {
+		uint32_t padding = node;
+		node			 = Split(padding, nodes[padding].size - (aligned - offset));
+		InsertFree(padding);
+	}
+	if (nodes[node].size > size)
+		InsertFree(Split(node, nodes[node].size - size));
+
+	freeSize -= size;
+	return {aligned, node};
+}
+
+void TlsfAllocator::Free(uint32_t node)
+{
+	MVE_ASSERT(node < nodes.size() && !nodes[node].free, "Node {} isn't allocated", node);
+	freeSize += nodes[node].size;
+
+	uint32_t previous = nodes[node].prevPhysical;
+	if (previous != INVALID_NODE && nodes[previous].free) {
+		RemoveFree(previous);
+		Merge(previous, node);
+		node = previous;
+	}
+	uint32_t next = nodes[node].nextPhysical;
+	if (next != INVALID_NODE && nodes[next].free) {
+		RemoveFree(next);
+		Merge(node, next);
+	}
+	InsertFree(node);
+}
+
+void TlsfAllocator::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+	if (size < SL_COUNT) {
+		fl = 0;
+		sl = uint32_t(size);
+		return;
+	}
+
+	uint32_t msb = 63 - std::countl_zero(size);
+	fl			 = msb - SL_LOG2 + 1;
+	sl			 = uint32_t(size >> (msb - SL_LOG2)) ^ SL_COUNT;
+}
+
+uint32_t TlsfAllocator::FindFree(uint64_t size) const
+{
+	// Rounded up to the next size class, every node in that class or above is big enough
+	uint64_t rounded = size;
+	if (size >= SL_COUNT) {
+		uint32_t msb = 63 - std::countl_zero(size);
+		rounded		 = std::max(size, size + (uint64_t(1) << (msb - SL_LOG2)) - 1);
+	}
+
+	uint32_t fl, sl;
+	Mapping(rounded, fl, sl);
+
+	uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+	if (slMap == 0) {
+		uint64_t flMap = fl + 1 < 64 ? flBitmap & (~uint64_t(0) << (fl + 1)) : 0;
+		if (flMap != 0) {
+			fl	  = std::countr_zero(flMap);
+			slMap = slBitmaps[fl];
+		}
+	}
+	if (slMap != 0)
+		return heads[fl * SL_COUNT + std::countr_zero(slMap)];
+
+	// Nothing above, but size's own class may still hold a node that's big enough
+	Mapping(size, fl, sl);
+	for (uint32_t node = heads[fl * SL_COUNT + sl]; node != INVALID_NODE; node = nodes[node].nextFree) {
+		if (nodes[node].size >= size)
+			return node;
+	}
+	return INVALID_NODE;
+}
+
+void TlsfAllocator::InsertFree(uint32_t node)
+{
+	uint32_t fl, sl;
+	Mapping(nodes[node].size, fl, sl);
+	uint32_t& head = heads[fl * SL_COUNT + sl];
+
+	nodes[node].free	 = true;
+	nodes[node].prevFree = INVALID_NODE;
+	nodes[node].nextFree = head;
+	if (head != INVALID_NODE)
+		nodes[head].prevFree = node;
+	head = node;
+
+	flBitmap |= uint64_t(1) << fl;
+	slBitmaps[fl] |= 1u << sl;
+	freeRangeCount++;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t node)
+{
+	uint32_t fl, sl;
+	Mapping(nodes[node].size, fl, sl);
+	uint32_t& head = heads[fl * SL_COUNT + sl];
+
+	auto& n = nodes[node];
+	if (n.prevFree != INVALID_NODE)
+		nodes[n.prevFree].nextFree = n.nextFree;
+	if (n.nextFree != INVALID_NODE)
+		nodes[n.nextFree].prevFree = n.prevFree;
+	if (head == node)
+		head = n.nextFree;
+
+	if (head == INVALID_NODE) {
+		slBitmaps[fl] &= ~(1u << sl);
+		if (slBitmaps[fl] == 0)
+			flBitmap &= ~(uint64_t(1) << fl);
+	}
+
+	n.free	   = false;
+	n.prevFree = INVALID_NODE;
+	n.nextFree = INVALID_NODE;
+	freeRangeCount--;
+}
+
+uint32_t TlsfAllocator::Split(uint32_t node, uint64_t size)
+{
+	uint32_t tail = CreateNode();
+	auto& n		  = nodes[node];
+	auto& t		  = nodes[tail];
+
+	t.offset	   = n.offset + n.size - size;
+	t.size		   = size;
+	t.prevPhysical = node;
+	t.nextPhysical = n.nextPhysical;
+	if (n.nextPhysical != INVALID_NODE)
+		nodes[n.nextPhysical].prevPhysical = tail;
+	n.nextPhysical = tail;
+	n.size -= size;
+	return tail;
+}
+
+void TlsfAllocator::Merge(uint32_t node, uint32_t next)
+{
+	auto& n = nodes[node];
+	n.size += nodes[next].size;
+	n.nextPhysical = nodes[next].nextPhysical;
+	if (n.nextPhysical != INVALID_NODE)
+		nodes[n.nextPhysical].prevPhysical = node;
+	DestroyNode(next);
+}
+
+uint32_t TlsfAllocator::CreateNode()
+{
+	if (unusedNodes.empty()) {
+		nodes.emplace_back();
+		return nodes.size() - 1;
+	}
+
+	uint32_t node = unusedNodes.back();
+	unusedNodes.pop_back();
+	nodes[node] = {};
+	return node;
+}
+
+void TlsfAllocator::DestroyNode(uint32_t node)
+{
+	unusedNodes.push_back(node);
+}
+
+} // namespace MVE
\ No newline at end of file
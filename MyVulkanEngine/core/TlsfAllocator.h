@@ -0,0 +1,79 @@
+#pragma once
+
+namespace MVE
+{
+
+/// Two level segregated fit allocator of ranges inside [0, capacity). Free ranges are kept in size class lists, the
+/// first level splits sizes by powers of two and the second level splits every power of two into SL_COUNT classes.
+/// Bitmaps of the non empty lists make Allocate and Free O(1), and freed ranges are merged with their free neighbours.
+/// Unlike RangeAllocator a range is freed by the node Allocate returned, the offset alone isn't enough.
+class TlsfAllocator
+{
+  public:
+	static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+	static constexpr uint32_t INVALID_NODE	 = UINT32_MAX;
+
+	struct Range
+	{
+		uint64_t offset = INVALID_OFFSET;
+		uint32_t node	= INVALID_NODE; // Passed to Free
+	};
+
+  public:
+	explicit TlsfAllocator(uint64_t capacity = 0);
+
+	// Returns a range with INVALID_OFFSET when no free range is big enough. alignment has to be a power of two.
+	Range Allocate(uint64_t size, uint64_t alignment = 1);
+	void Free(uint32_t node);
+
+	uint64_t Capacity() const { return capacity; }
+	uint64_t FreeSize() const { return freeSize; }
+	uint64_t UsedSize() const { return capacity - freeSize; }
+	// Number of separate free ranges, 1 means the free space is in one piece
+	size_t FreeRangeCount() const { return freeRangeCount; }
+	bool IsEmpty() const { return freeSize == capacity; }
+
+  private:
+	static constexpr uint32_t SL_LOG2  = 5;
+	static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+	// Sizes below SL_COUNT all map to the first level 0, every size class there holds exactly one size
+	static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+
+	struct Node
+	{
+		uint64_t offset		  = 0;
+		uint64_t size		  = 0;
+		uint32_t prevPhysical = INVALID_NODE; // Neighbours in the address space
+		uint32_t nextPhysical = INVALID_NODE;
+		uint32_t prevFree	  = INVALID_NODE; // Neighbours in the size class list, only for free nodes
+		uint32_t nextFree	  = INVALID_NODE;
+		bool free			  = false;
+	};
+
+	// Size class that holds size
+	static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+	// Free node of at least size bytes, INVALID_NODE if there is none
+	uint32_t FindFree(uint64_t size) const;
+	void InsertFree(uint32_t node);
+	void RemoveFree(uint32_t node);
+	// New node after node in the address space, holding its last size bytes
+	uint32_t Split(uint32_t node, uint64_t size);
+	// Merges next into node, next must follow node in the address space
+	void Merge(uint32_t node, uint32_t next);
+	uint32_t CreateNode();
+	void DestroyNode(uint32_t node);
+
+  private:
+	uint64_t capacity;
+	uint64_t freeSize;
+	size_t freeRangeCount = 0;
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> unusedNodes;
+
+	uint64_t flBitmap = 0; // Bit fl is set when any list of that first level has a node
+	std::array<uint32_t, FL_COUNT> slBitmaps {};
+	std::array<uint32_t, FL_COUNT * SL_COUNT> heads; // First free node of each size class
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "TransformBatch.h"
+
+#include "SimdVec.h"
+
+namespace MVE
+{
+
+namespace
+{
+// Computes V::WIDTH transforms starting at first. Matrices are written column major, like glm stores them.
+template<typename V>
+void ComputeBlock(const TransformSoA& t, size_t first, float* models, float* normals)
+{
+	V tx = V::Load(t.translation[0] + first);
+	V ty = V::Load(t.translation[1] + first);
+	V tz = V::Load(t.translation[2] + first);
+	V qx = V::Load(t.rotation[0] + first);
+	V qy = V::Load(t.rotation[1] + first);
+	V qz = V::Load(t.rotation[2] + first);
+	V qw = V::Load(t.rotation[3] + first);
+	V sx = V::Load(t.scale[0] + first);
+	V sy = V::Load(t.scale[1] + first);
+	V sz = V::Load(t.scale[2] + first);
+
+	V one = V::Set(1.0f);
+	V two = V::Set(2.0f);
+
+	V xx = qx * qx, yy = qy * qy, zz = qz * qz;
+	V xy = qx * qy, xz = qx * qz, yz = qy * qz;
+	V wx = qw * qx, wy = qw * qy, wz = qw * qz;
+
+	// Rotation matrix columns, same as glm::mat3_cast
+	V r00 = one - two * (yy + zz), r01 = two * (xy + wz), r02 = two * (xz - wy);
+	V r10 = two * (xy - wz), r11 = one - two * (xx + zz), r12 = two * (yz + wx);
+	V r20 = two * (xz + wy), r21 = two * (yz - wx), r22 = one - two * (xx + yy);
+
+	// Model = R * S * T, so the translation column is (R * S) * t
+	V m00 = r00 * sx, m01 = r01 * sx, m02 = r02 * sx;
+	V m10 = r10 * sy, m11 = r11 * sy, m12 = r12 * sy;
+	V m20 = r20 * sz, m21 = r21 * sz, m22 = r22 * sz;
+	V m30 = m00 * tx + m10 * ty + m20 * tz;
+	V m31 = m01 * tx + m11 * ty + m21 * tz;
+	V m32 = m02 * tx + m12 * ty + m22 * tz;
+
+	alignas(32) float lanes[21][V::WIDTH];
+	const V modelValues[12] = {m00, m01, m02, m10, m11, m12, m20, m21, m22, m30, m31, m32};
+	for (int i = 0; i < 12; i++) { modelValues[i].Store(lanes[i]); }
+
+	if (normals) {
+		// inverse(R * S)^T = R * inverse(S), the columns of R divided by the scale
+		V ix = one / sx, iy = one / sy, iz = one / sz;
+		const V normalValues[9] = {r00 * ix, r01 * ix, r02 * ix, r10 * iy, r11 * iy,
+								   r12 * iy, r20 * iz, r21 * iz, r22 * iz};
+		for (int i = 0; i < 9; i++) { normalValues[i].Store(lanes[12 + i]); }
+	}
+
+	for (size_t lane = 0; lane < V::WIDTH; lane++) {
+		float* m = models + (first + lane) * 16;
+		for (int column = 0; column < 4; column++) {
+			m[column * 4 + 0] = lanes[column * 3 + 0][lane];
+			m[column * 4 + 1] = lanes[column * 3 + 1][lane];
+			m[column * 4 + 2] = lanes[column * 3 + 2][lane];
+			m[column * 4 + 3] = column == 3 ? 1.0f : 0.0f;
+		}
+
+		if (normals) {
+			float* n = normals + (first + lane) * 9;
+			for (int i = 0; i < 9; i++) { n[i] = lanes[12 + i][lane]; }
+		}
+	}
+}
+} // namespace
+
+void TransformBatch::Compute(const TransformSoA& transforms, glm::mat4* modelMatrices, glm::mat3* normalMatrices,
+							 bool uniformOrPositiveScale)
+{
+	static_assert(sizeof(glm::mat4) == 16 * sizeof(float) && sizeof(glm::mat3) == 9 * sizeof(float));
+
+	auto models	 = reinterpret_cast<float*>(modelMatrices);
+	auto normals = uniformOrPositiveScale ? reinterpret_cast<float*>(normalMatrices) : nullptr;
+
+	size_t i = 0;
+	for (; i + SimdVec::WIDTH <= transforms.count; i += SimdVec::WIDTH) {
+		ComputeBlock<SimdVec>(transforms, i, models, normals);
+	}
+	for (; i < transforms.count; i++) { ComputeBlock<ScalarVec>(transforms, i, models, normals); }
+
+	if (normalMatrices && !uniformOrPositiveScale) {
+		for (size_t j = 0; j < transforms.count; j++) {
+			normalMatrices[j] = glm::transpose(glm::inverse(glm::mat3(modelMatrices[j])));
+		}
+	}
+}
+
+const char* TransformBatch::InstructionSet()
+{
+#if defined(MVE_SIMD_AVX2)
+	return "AVX2";
+#elif defined(MVE_SIMD_SSE)
+	return "SSE";
+#else
+	return "Scalar";
+#endif
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace MVE
+{
+
+/// Translation, rotation and scale of count transforms with one array per component, so a SIMD register can load the
+/// same component of several transforms at once.
+struct TransformSoA
+{
+	const float* translation[3] {}; // x, y, z
+	const float* rotation[4] {};	// Quaternion x, y, z, w
+	const float* scale[3] {};		// x, y, z
+	size_t count = 0;
+};
+
+/// Computes model and normal matrices for many transforms at once. The model matrix is the same as
+/// TransformComponent's local matrix. Uses AVX2 when the engine is built with MVE_ENABLE_AVX2, SSE on other x86 builds
+/// and plain C++ everywhere else.
+class TransformBatch
+{
+  public:
+	// With uniformOrPositiveScale the normal matrix is built directly as rotation * inverse scale, which equals the
+	// inverse transpose of the model matrix for any scale without zero components. Otherwise it falls back to a general
+	// inverse per transform. normalMatrices may be null when only model matrices are needed.
+	static void Compute(const TransformSoA& transforms, glm::mat4* modelMatrices, glm::mat3* normalMatrices,
+						bool uniformOrPositiveScale = true);
+
+	// Name of the instruction set Compute was built for
+	static const char* InstructionSet();
+};
+
+} // namespace MVE
\ No newline at end of file
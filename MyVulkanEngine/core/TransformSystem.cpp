@@ -0,0 +1,170 @@
+#include "TransformSystem.h"
+
+#include "GameObject.h"
+#include "JobSystem.h"
+#include "TransformBatch.h"
+
+#include <algorithm>
+
+namespace MVE
+{
+
+constexpr uint32_t TRANSFORMS_PER_JOB	= 1024;
+constexpr uint32_t TRANSFORMS_PER_BATCH = 256; // Keeps the SoA scratch small enough for the stack
+
+void TransformSystem::SetParent(Registry& registry, Entity child, Entity parent)
+{
+	if (parent == NULL_ENTITY) {
+		registry.Remove<ParentComponent>(child);
+		registry.Get<TransformComponent>(child).dirty = true;
+		registry.Context<Hierarchy>().changed		  = true;
+		return;
+	}
+
+	for (Entity ancestor = parent; ancestor != NULL_ENTITY; ancestor = GetParent(registry, ancestor)) {
+		if (ancestor == child) {
+			MVE_ERROR("Can't parent entity {} to {}, it would become its own ancestor", child, parent);
+			return;
+		}
+	}
+
+	if (auto component = registry.TryGet<ParentComponent>(child))
+		*component = {parent};
+	else
+		registry.Emplace<ParentComponent>(child, parent);
+	registry.Get<TransformComponent>(child).dirty = true;
+	registry.Context<Hierarchy>().changed		  = true;
+}
+
+Entity TransformSystem::GetParent(Registry& registry, Entity entity)
+{
+	auto component = registry.TryGet<ParentComponent>(entity);
+	return component ? component->parent : NULL_ENTITY;
+}
+
+void TransformSystem::Update(Registry& registry)
+{
+	MVE_PROFILE_FUNCTION();
+
+	auto& transforms = registry.Pool<TransformComponent>();
+	auto& parents	 = registry.Pool<ParentComponent>();
+	auto& changes	 = registry.Context<Changes>();
+	changes.entities.clear();
+	changes.update++;
+
+	// Local matrices of everything that changed, and the world matrices of the roots among them
+	std::vector<uint32_t> dirty;
+	auto& data = transforms.Data();
+	for (uint32_t i = 0; i < data.size(); i++) {
+		if (data[i].dirty)
+			dirty.push_back(i);
+	}
+
+	if (!dirty.empty()) {
+		JobSystem::ParallelFor(dirty.size(), TRANSFORMS_PER_JOB, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t first = begin; first < end; first += TRANSFORMS_PER_BATCH) {
+				uint32_t count = std::min(end - first, TRANSFORMS_PER_BATCH);
+				RebuildLocalMatrices(transforms, parents, dirty.data() + first, count);
+			}
+		});
+
+		// The roots among them are done, the children are added below once their world matrix was rebuilt
+		for (uint32_t index : dirty) {
+			Entity entity = transforms.Entities()[index];
+			if (!parents.Contains(entity))
+				changes.entities.push_back(entity);
+		}
+	}
+
+	if (parents.Size() == 0)
+		return;
+
+	// Children, shallowest first so every parent is already up to date when its children are visited. Destroying an
+	// entity removes its ParentComponent, so the pool's version covers that too.
+	auto& hierarchy = registry.Context<Hierarchy>();
+	if (hierarchy.changed || hierarchy.parentsVersion != parents.StructureVersion()) {
+		std::vector<std::pair<uint32_t, Entity>> depths;
+		depths.reserve(parents.Size());
+		for (Entity entity : parents.Entities()) {
+			uint32_t depth = 0;
+			for (Entity ancestor = entity; parents.Contains(ancestor); ancestor = parents.Get(ancestor).parent) {
+				depth++;
+			}
+			depths.emplace_back(depth, entity);
+		}
+		std::sort(depths.begin(), depths.end());
+
+		hierarchy.order.clear();
+		for (auto& [depth, entity] : depths) { hierarchy.order.push_back(entity); }
+		hierarchy.parentsVersion = parents.StructureVersion();
+		hierarchy.changed		 = false;
+	}
+
+	for (Entity entity : hierarchy.order) {
+		auto& transform		  = transforms.Get(entity);
+		auto& parent		  = parents.Get(entity);
+		auto* parentTransform = transforms.TryGet(parent.parent);
+
+		// A destroyed parent leaves its children at the root
+		uint32_t parentVersion = parentTransform ? parentTransform->version : 0;
+		if (!transform.dirty && parent.parentVersion == parentVersion)
+			continue;
+
+		// The local matrix is already up to date
+		transform.dirty		   = false;
+		transform.worldMatrix  = parentTransform ? parentTransform->worldMatrix * transform.localMatrix
+												 : transform.localMatrix;
+		transform.normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform.worldMatrix)));
+		transform.version++;
+		parent.parentVersion = parentVersion;
+		changes.entities.push_back(entity);
+	}
+}
+
+void TransformSystem::RebuildLocalMatrices(ComponentPool<TransformComponent>& transforms,
+										   ComponentPool<ParentComponent>& parents, const uint32_t* indices,
+										   uint32_t count)
+{
+	auto& data	   = transforms.Data();
+	auto& entities = transforms.Entities();
+
+	std::array<std::array<float, TRANSFORMS_PER_BATCH>, 10> soa;
+	std::array<glm::mat4, TRANSFORMS_PER_BATCH> models;
+	std::array<glm::mat3, TRANSFORMS_PER_BATCH> normals;
+
+	for (uint32_t i = 0; i < count; i++) {
+		auto& transform = data[indices[i]];
+		soa[0][i]		= transform.translation.x;
+		soa[1][i]		= transform.translation.y;
+		soa[2][i]		= transform.translation.z;
+		soa[3][i]		= transform.rotation.x;
+		soa[4][i]		= transform.rotation.y;
+		soa[5][i]		= transform.rotation.z;
+		soa[6][i]		= transform.rotation.w;
+		soa[7][i]		= transform.scale.x;
+		soa[8][i]		= transform.scale.y;
+		soa[9][i]		= transform.scale.z;
+	}
+
+	TransformSoA input {{soa[0].data(), soa[1].data(), soa[2].data()},
+						{soa[3].data(), soa[4].data(), soa[5].data(), soa[6].data()},
+						{soa[7].data(), soa[8].data(), soa[9].data()},
+						count};
+	TransformBatch::Compute(input, models.data(), normals.data());
+
+	for (uint32_t i = 0; i < count; i++) {
+		auto& transform		  = data[indices[i]];
+		transform.localMatrix = models[i];
+
+		// Children stay dirty, their world matrix needs the parent's, which may not be ready yet
+		if (parents.Contains(entities[indices[i]]))
+			continue;
+
+		transform.worldMatrix  = models[i];
+		transform.normalMatrix = normals[i];
+		transform.dirty		   = false;
+		transform.version++;
+	}
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Registry.h"
+
+namespace MVE
+{
+
+class TransformComponent;
+struct ParentComponent;
+
+/// Keeps the cached matrices of every TransformComponent up to date. Roots are rebuilt only when they were changed,
+/// children when they or any of their ancestors were, so a static scene costs one pass over the dirty flags. The order
+/// the children are visited in is kept until the hierarchy changes.
+class TransformSystem
+{
+  public:
+	// Pass NULL_ENTITY as the parent to detach child. Making an entity its own ancestor is refused. Parents must only
+	// be changed through here, or by adding and removing ParentComponents.
+	static void SetParent(Registry& registry, Entity child, Entity parent);
+	static Entity GetParent(Registry& registry, Entity entity);
+
+	// What the updates changed, for systems that only want to look at the entities that moved
+	struct Changes
+	{
+		std::vector<Entity> entities; // Whose world matrix changed in the last Update
+		uint32_t update = 0;		  // Number of Update calls so far, a system that skipped one has to look at all
+	};
+
+	// Call once per frame, after gameplay code moved things and before anything reads the matrices
+	static void Update(Registry& registry);
+	static const Changes& GetChanges(Registry& registry) { return registry.Context<Changes>(); }
+
+  private:
+	// The entities with a ParentComponent, shallowest first
+	struct Hierarchy
+	{
+		std::vector<Entity> order;
+		uint32_t parentsVersion = 0;	// StructureVersion of the ParentComponent pool order was built for
+		bool changed			= true; // SetParent was called since
+	};
+
+	// Batched through TransformBatch. Also finishes the roots among them, whose world matrix is the local one.
+	static void RebuildLocalMatrices(ComponentPool<TransformComponent>& transforms,
+									 ComponentPool<ParentComponent>& parents, const uint32_t* indices, uint32_t count);
+};
+
+} // namespace MVE
\ No newline at end of file
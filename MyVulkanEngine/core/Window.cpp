@@ -5,6 +5,9 @@ namespace MVE
 
 Window::Window(const WindowProperties& props): properties(props)
 {
+	if (props.headless)
+		return;
+
 	glfwSetErrorCallback(
 		[](int code, const char* description) { MVE_ERROR("GLFW Error! ({})\n{}", code, description); });
 
@@ -29,12 +32,19 @@ Window::Window(const WindowProperties& props): properties(props)
 
 Window::~Window()
 {
+	if (windowPtr == nullptr)
+		return;
+
 	glfwDestroyWindow(windowPtr);
 	glfwTerminate();
 }
 
 void Window::OnUpdate()
 {
+	MVE_PROFILE_SCOPE("Window::OnUpdate");
+	if (windowPtr == nullptr)
+		return;
+
 	glfwPollEvents();
 	// glfwSwapBuffers(windowPtr);
 }
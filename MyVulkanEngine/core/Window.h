@@ -10,6 +10,7 @@ struct WindowProperties
 	std::string title = "My Vulkan Engine";
 	uint32_t width	  = 1280;
 	uint32_t height	  = 720;
+	bool headless	  = false; // No GLFW window or surface, the renderer draws into an offscreen target.
 };
 
 class Window
@@ -22,7 +23,8 @@ class Window
 
 	void OnUpdate();
 
-	bool ShouldClose() { return glfwWindowShouldClose(windowPtr); }
+	bool ShouldClose() { return windowPtr != nullptr && glfwWindowShouldClose(windowPtr); }
+	bool IsHeadless() const { return properties.headless; }
 
 	GLFWwindow* GetNativeWindow() const { return windowPtr; }
 
@@ -33,6 +35,6 @@ class Window
 	WindowProperties properties;
 
   private:
-	GLFWwindow* windowPtr;
+	GLFWwindow* windowPtr = nullptr;
 };
 } // namespace MVE
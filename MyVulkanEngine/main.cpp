@@ -1,13 +1,41 @@
-﻿#include "Core/Application.h"
+﻿#include "core/Application.h"
 #include "moduels/render3d/Render3DModule.h"
 
-int main()
+#include <string_view>
+
+int main(int argc, char** argv)
 {
 	using namespace MVE;
 
-	auto app = Application::Create()->AddModule<Render3DModule>();
+	WindowProperties windowProperties {};
+	uint32_t frameLimit = 0;
+	std::string profilePath;
+	std::string sceneName = "cerberus";
+	bool cpuCulling		  = false;
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg = argv[i];
+		if (arg == "--headless")
+			windowProperties.headless = true;
+		else if (arg == "--frames" && i + 1 < argc)
+			frameLimit = std::stoul(argv[++i]);
+		else if (arg == "--profile" && i + 1 < argc)
+			profilePath = argv[++i];
+		else if (arg == "--scene" && i + 1 < argc)
+			sceneName = argv[++i];
+		else if (arg == "--cpu-culling")
+			cpuCulling = true;
+	}
+
+	auto app = Application::Create(windowProperties)
+				   ->SetFrameLimit(frameLimit)
+				   ->AddModule<Render3DModule>(sceneName, cpuCulling);
+
+	if (!profilePath.empty())
+		Profiler::BeginSession(profilePath);
 
 	app->Run();
 
+	Profiler::EndSession();
+
 	delete app;
 }
\ No newline at end of file
@@ -13,5 +13,8 @@ class Module
 	virtual void OnAttach() {}
 	virtual void OnDetach() {}
 	virtual void OnUpdate(Timestep dt) {}
+
+	// Used to label the module in profiler captures
+	virtual const char* GetName() const { return "Module"; }
 };
 } // namespace MVE
\ No newline at end of file
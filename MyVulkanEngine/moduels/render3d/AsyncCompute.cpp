@@ -0,0 +1,299 @@
+#include "AsyncCompute.h"
+
+#include "UploadManager.h"
+
+#include <algorithm>
+
+namespace MVE
+{
+
+AsyncCompute::AsyncCompute(Device& device): device(device)
+{
+	auto families  = device.FindPhysicalQueueFamilies();
+	computeFamily  = families.computeFamily;
+	graphicsFamily = families.graphicsFamily;
+
+	if (!device.properties.limits.timestampComputeAndGraphics)
+		return;
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device.PhysicalDevice(), &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> properties(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device.PhysicalDevice(), &familyCount, properties.data());
+
+	uint32_t validBits = properties[computeFamily].timestampValidBits;
+	if (validBits > 0)
+		timestampMask = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+}
+
+AsyncCompute::~AsyncCompute()
+{
+	vkDeviceWaitIdle(device.VulkanDevice());
+	for (auto& job : jobs) { Finish(*job); }
+}
+
+AsyncCompute::Ticket AsyncCompute::Submit(const char* name, const std::vector<TextureUse>& textures,
+										  const std::function<void(Job& job)>& record)
+{
+	MVE_PROFILE_FUNCTION();
+	auto vkDevice = device.VulkanDevice();
+	auto pending  = std::make_unique<PendingJob>();
+	pending->name = name;
+
+	VkCommandPoolCreateInfo poolInfo {};
+	poolInfo.sType			  = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = computeFamily;
+	poolInfo.flags			  = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	auto code = vkCreateCommandPool(vkDevice, &poolInfo, nullptr, &pending->computePool);
+	MVE_ASSERT(code == VK_SUCCESS, "Failed to create a compute command pool");
+	poolInfo.queueFamilyIndex = graphicsFamily;
+	code					  = vkCreateCommandPool(vkDevice, &poolInfo, nullptr, &pending->graphicsPool);
+	MVE_ASSERT(code == VK_SUCCESS, "Failed to create a compute command pool");
+
+	VkCommandBufferAllocateInfo allocInfo {};
+	allocInfo.sType				 = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level				 = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool		 = pending->computePool;
+	allocInfo.commandBufferCount = 1;
+	vkAllocateCommandBuffers(vkDevice, &allocInfo, &pending->job.commandBuffer);
+
+	VkCommandBuffer graphicsCommands[2];
+	allocInfo.commandPool		 = pending->graphicsPool;
+	allocInfo.commandBufferCount = 2;
+	vkAllocateCommandBuffers(vkDevice, &allocInfo, graphicsCommands);
+	pending->releaseCommands = graphicsCommands[0];
+	pending->acquireCommands = graphicsCommands[1];
+
+	VkSemaphoreCreateInfo semaphoreInfo {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	for (auto semaphore : {&pending->released, &pending->computed}) {
+		code = vkCreateSemaphore(vkDevice, &semaphoreInfo, nullptr, semaphore);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to create a compute semaphore");
+	}
+
+	VkFenceCreateInfo fenceInfo {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	code			= vkCreateFence(vkDevice, &fenceInfo, nullptr, &pending->fence);
+	MVE_ASSERT(code == VK_SUCCESS, "Failed to create a compute fence");
+
+	if (timestampMask != 0) {
+		VkQueryPoolCreateInfo queryInfo {};
+		queryInfo.sType		 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryInfo.queryType	 = VK_QUERY_TYPE_TIMESTAMP;
+		queryInfo.queryCount = 2;
+		vkCreateQueryPool(vkDevice, &queryInfo, nullptr, &pending->timestamps);
+	}
+
+	// Without a family of its own the compute queue is the graphics queue. The barriers are plain layout
+	// transitions then, the semaphores already make the writes visible.
+	bool ownFamily = computeFamily != graphicsFamily;
+	std::vector<VkImageMemoryBarrier> releases;
+	for (auto& use : textures) {
+		auto& texture = *use.texture;
+
+		VkImageMemoryBarrier barrier {};
+		barrier.sType				= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask		= VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.oldLayout			= texture.layout_;
+		barrier.newLayout			= use.layout;
+		barrier.srcQueueFamilyIndex = ownFamily ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = ownFamily ? computeFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.image				= texture.image;
+		barrier.subresourceRange	= {VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.mipMapsLevels_, 0, texture.layers_};
+		releases.push_back(barrier);
+
+		texture.layout_ = use.layout;
+	}
+
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	auto releaseCommands = pending->releaseCommands;
+	vkBeginCommandBuffer(releaseCommands, &beginInfo);
+	vkCmdPipelineBarrier(releaseCommands, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0,
+						 nullptr, 0, nullptr, releases.size(), releases.data());
+	vkEndCommandBuffer(releaseCommands);
+
+	auto commandBuffer = pending->job.commandBuffer;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	if (ownFamily) {
+		auto acquires = releases;
+		for (auto& barrier : acquires) {
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+							 0, nullptr, 0, nullptr, acquires.size(), acquires.data());
+	}
+	if (pending->timestamps) {
+		vkCmdResetQueryPool(commandBuffer, pending->timestamps, 0, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pending->timestamps, 0);
+	}
+
+	record(pending->job);
+
+	if (pending->timestamps)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pending->timestamps, 1);
+
+	// The way back, the layouts stay as they are
+	auto returns = releases;
+	for (auto& barrier : returns) {
+		barrier.oldLayout			= barrier.newLayout;
+		barrier.srcQueueFamilyIndex = computeFamily;
+		barrier.dstQueueFamilyIndex = graphicsFamily;
+		barrier.srcAccessMask		= VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask		= 0;
+	}
+	if (ownFamily)
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+							 0, 0, nullptr, 0, nullptr, returns.size(), returns.data());
+	vkEndCommandBuffer(commandBuffer);
+
+	auto acquireCommands = pending->acquireCommands;
+	vkBeginCommandBuffer(acquireCommands, &beginInfo);
+	if (ownFamily) {
+		for (auto& barrier : returns) {
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		}
+		vkCmdPipelineBarrier(acquireCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+							 0, nullptr, 0, nullptr, returns.size(), returns.data());
+	}
+	vkEndCommandBuffer(acquireCommands);
+
+	std::lock_guard lock(mutex);
+	pending->ticket = nextTicket++;
+	jobs.push_back(std::move(pending));
+	return jobs.back()->ticket;
+}
+
+bool AsyncCompute::IsComplete(Ticket ticket)
+{
+	std::lock_guard lock(mutex);
+	for (auto& job : jobs) {
+		if (job->ticket == ticket)
+			return job->state == State::Returning;
+	}
+	return true;
+}
+
+void AsyncCompute::Wait(Ticket ticket)
+{
+	MVE_PROFILE_FUNCTION();
+	std::lock_guard lock(mutex);
+	auto it = std::find_if(jobs.begin(), jobs.end(), [&](auto& job) { return job->ticket == ticket; });
+	if (it == jobs.end())
+		return;
+
+	auto& job = **it;
+	if (job.state == State::Recorded)
+		SubmitJob(job);
+	if (job.state == State::Computing) {
+		vkWaitForFences(device.VulkanDevice(), 1, &job.fence, VK_TRUE, UINT64_MAX);
+		ReturnTextures(job);
+	}
+	vkWaitForFences(device.VulkanDevice(), 1, &job.fence, VK_TRUE, UINT64_MAX);
+	Finish(job);
+	jobs.erase(it);
+}
+
+void AsyncCompute::Update()
+{
+	MVE_PROFILE_FUNCTION();
+	std::lock_guard lock(mutex);
+	for (auto it = jobs.begin(); it != jobs.end();) {
+		auto& job = **it;
+		if (job.state == State::Recorded)
+			SubmitJob(job);
+
+		bool signaled = vkGetFenceStatus(device.VulkanDevice(), job.fence) == VK_SUCCESS;
+		if (signaled && job.state == State::Computing)
+			ReturnTextures(job);
+		else if (signaled && job.state == State::Returning) {
+			Finish(job);
+			it = jobs.erase(it);
+			continue;
+		}
+		it++;
+	}
+}
+
+void AsyncCompute::SubmitJob(PendingJob& job)
+{
+	// The job may read what was uploaded while recording it
+	device.GetUploadManager().Submit();
+
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	job.cpuAnchor				   = Profiler::Now();
+
+	VkSubmitInfo submitInfo {};
+	submitInfo.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount	= 1;
+	submitInfo.pCommandBuffers		= &job.releaseCommands;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores	= &job.released;
+	auto code						= device.QueueSubmit(device.GraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+	MVE_ASSERT(code == VK_SUCCESS, "Failed to submit a compute job");
+
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores	  = &job.released;
+	submitInfo.pWaitDstStageMask  = &waitStage;
+	submitInfo.pCommandBuffers	  = &job.job.commandBuffer;
+	submitInfo.pSignalSemaphores  = &job.computed;
+	code						  = device.QueueSubmit(device.ComputeQueue(), 1, &submitInfo, job.fence);
+	MVE_ASSERT(code == VK_SUCCESS, "Failed to submit a compute job");
+
+	job.state = State::Computing;
+}
+
+void AsyncCompute::ReturnTextures(PendingJob& job)
+{
+	// The job already finished, so the graphics queue doesn't stall on the semaphore
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	VkSubmitInfo submitInfo {};
+	submitInfo.sType			  = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores	  = &job.computed;
+	submitInfo.pWaitDstStageMask  = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers	  = &job.acquireCommands;
+
+	vkResetFences(device.VulkanDevice(), 1, &job.fence);
+	auto code = device.QueueSubmit(device.GraphicsQueue(), 1, &submitInfo, job.fence);
+	MVE_ASSERT(code == VK_SUCCESS, "Failed to return the textures of a compute job");
+
+	job.state = State::Returning;
+}
+
+void AsyncCompute::Finish(PendingJob& job)
+{
+	auto vkDevice = device.VulkanDevice();
+
+	uint64_t timestamps[2];
+	if (job.timestamps && job.state != State::Recorded &&
+		vkGetQueryPoolResults(vkDevice, job.timestamps, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+							  VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+		// Masked, so the difference stays right when the counter wrapped around during the job
+		uint64_t ticks		 = (timestamps[1] - timestamps[0]) & timestampMask;
+		uint64_t nanoseconds = uint64_t(ticks * double(device.properties.limits.timestampPeriod));
+		MVE_INFO("GPU {}: {:.3f} ms", job.name, nanoseconds / 1e6f);
+
+		// Lined up with the submit, the closest CPU time to the start of the job
+		if (Profiler::IsRecording())
+			Profiler::RecordComputeEvent(job.name, job.cpuAnchor, job.cpuAnchor + nanoseconds);
+	}
+
+	for (auto& completion : job.job.completions) { completion(); }
+
+	vkDestroyQueryPool(vkDevice, job.timestamps, nullptr);
+	vkDestroyFence(vkDevice, job.fence, nullptr);
+	vkDestroySemaphore(vkDevice, job.computed, nullptr);
+	vkDestroySemaphore(vkDevice, job.released, nullptr);
+	// Destroying the pools frees the command buffers
+	vkDestroyCommandPool(vkDevice, job.graphicsPool, nullptr);
+	vkDestroyCommandPool(vkDevice, job.computePool, nullptr);
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Texture.h"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace MVE
+{
+
+/// Runs compute jobs on the compute queue, which has a family of its own on devices with async compute, next to the
+/// frames on the graphics queue. A job's textures are released by the graphics queue and acquired by the compute queue
+/// before it runs, and go back the same way after it, with a semaphore between every two submits. Jobs are recorded on
+/// any thread and moved along by Update without the CPU waiting for them, so they don't hold up rendering.
+class AsyncCompute
+{
+  public:
+	// Identifies a job
+	using Ticket = uint64_t;
+
+	// A texture a job reads or writes, in layout on the compute queue and from then on
+	struct TextureUse
+	{
+		Texture* texture;
+		VkImageLayout layout;
+	};
+
+	class Job
+	{
+	  public:
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE; // On the compute queue
+
+		// Runs in Update or Wait once the GPU is done with the job, for destroying what its commands use
+		void OnComplete(std::function<void()> function) { completions.push_back(std::move(function)); }
+
+	  private:
+		friend class AsyncCompute;
+
+		std::vector<std::function<void()>> completions;
+	};
+
+  public:
+	explicit AsyncCompute(Device& device);
+	~AsyncCompute();
+
+	AsyncCompute(const AsyncCompute&)	= delete;
+	void operator=(const AsyncCompute&) = delete;
+
+	// Records a job, record is called before Submit returns. The textures already have their layout while it records,
+	// so their ImageInfo is what the compute queue sees. The job's GPU time is logged under name, and recorded on the
+	// profiler's "GPU Compute" track. Thread safe.
+	Ticket Submit(const char* name, const std::vector<TextureUse>& textures,
+				  const std::function<void(Job& job)>& record);
+	// True once the textures went back to the graphics queue, frames submitted from then on can use them
+	bool IsComplete(Ticket ticket);
+	// Blocks until the job finished and ran its completions, submitting it first if Update didn't yet
+	void Wait(Ticket ticket);
+
+	// Submits the recorded jobs and gives the textures of finished ones back to the graphics queue, without waiting.
+	// Called once per frame before the frame is recorded, and after submitting jobs at load time to get them going.
+	void Update();
+
+  private:
+	enum class State
+	{
+		Recorded,
+		Computing, // Submitted to the compute queue
+		Returning  // Finished, the graphics queue acquires the textures
+	};
+
+	struct PendingJob
+	{
+		Ticket ticket;
+		const char* name;
+		State state = State::Recorded;
+		Job job;
+
+		// Own pools, so jobs can be recorded on any thread without a lock
+		VkCommandPool computePool		= VK_NULL_HANDLE;
+		VkCommandPool graphicsPool		= VK_NULL_HANDLE;
+		VkCommandBuffer releaseCommands = VK_NULL_HANDLE; // Graphics queue, before the job
+		VkCommandBuffer acquireCommands = VK_NULL_HANDLE; // Graphics queue, after the job
+		VkSemaphore released			= VK_NULL_HANDLE;
+		VkSemaphore computed			= VK_NULL_HANDLE;
+		VkFence fence					= VK_NULL_HANDLE; // Of the job, then of acquireCommands
+		VkQueryPool timestamps			= VK_NULL_HANDLE; // Start and end of the job, if the device has timestamps
+		uint64_t cpuAnchor				= 0; // When the job was submitted, the GPU can't start it earlier
+	};
+
+	void SubmitJob(PendingJob& job);
+	void ReturnTextures(PendingJob& job);
+	// Runs the completions and destroys the job's objects
+	void Finish(PendingJob& job);
+
+  private:
+	Device& device;
+	uint32_t computeFamily;
+	uint32_t graphicsFamily;
+	uint64_t timestampMask = 0; // The compute family's timestampValidBits, 0 without timestamps
+
+	std::mutex mutex;
+	std::deque<std::unique_ptr<PendingJob>> jobs; // In the order they were submitted
+	Ticket nextTicket = 1;
+};
+
+} // namespace MVE
\ No newline at end of file
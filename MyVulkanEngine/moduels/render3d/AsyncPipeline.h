@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Pipeline.h"
+
+#include "core/JobSystem.h"
+
+#include <functional>
+#include <memory>
+
+namespace MVE
+{
+
+/// Counts the pipeline compiles that are still running, over every AsyncPipeline
+class PipelineCompiler
+{
+  public:
+	static bool IsIdle() { return pending.IsDone(); }
+	// Runs other jobs on the calling thread until every compile started so far finished
+	static void WaitForAll() { JobSystem::Wait(pending); }
+
+  private:
+	template<typename T>
+	friend class AsyncPipeline;
+
+	inline static JobCounter pending;
+};
+
+/// A pipeline that is compiled on a worker as a background job. Compile returns right away and TryGet returns null until
+/// the pipeline exists, so the draws that need it can be skipped instead of stalling the frame on the driver's shader
+/// compiler. The factory runs on a worker: it must build its PipelineConfigInfo itself and only capture what outlives
+/// the compile, the handles by value.
+template<typename T>
+class AsyncPipeline
+{
+  public:
+	using Factory = std::function<std::unique_ptr<T>()>;
+
+	AsyncPipeline() = default;
+	~AsyncPipeline() { Wait(); }
+
+	AsyncPipeline(const AsyncPipeline&)	 = delete;
+	void operator=(const AsyncPipeline&) = delete;
+
+	// Starts compiling a new pipeline without waiting for an earlier compile. The current one is destroyed, it must
+	// not be used by a pending frame anymore.
+	void Compile(Factory factory)
+	{
+		std::erase_if(replaced, [](auto& compilation) { return compilation->counter.IsDone(); });
+		if (current && !current->counter.IsDone())
+			replaced.push_back(std::move(current));
+
+		// The job keeps its compilation alive, the counter is still touched after the factory returned
+		current = std::make_shared<Compilation>();
+		JobSystem::RunBackground(
+			[compilation = current, factory = std::move(factory)] { compilation->pipeline = factory(); },
+			&current->counter);
+		JobSystem::RunAfter(current->counter, [] {}, &PipelineCompiler::pending);
+	}
+
+	// Null while the pipeline is compiling
+	T* TryGet() const { return current && current->counter.IsDone() ? current->pipeline.get() : nullptr; }
+	// Blocks until the pipeline is compiled, for work that can't go without it
+	T& Get()
+	{
+		MVE_ASSERT(current != nullptr, "Pipeline was never compiled");
+		JobSystem::Wait(current->counter);
+		return *current->pipeline;
+	}
+
+	// Must be called before anything a factory captured, like the pipeline layout, is destroyed
+	void Wait()
+	{
+		for (auto& compilation : replaced) { JobSystem::Wait(compilation->counter); }
+		replaced.clear();
+		if (current)
+			JobSystem::Wait(current->counter);
+	}
+
+  private:
+	struct Compilation
+	{
+		std::unique_ptr<T> pipeline;
+		JobCounter counter; // Done once pipeline was written by the compile job
+	};
+
+	std::shared_ptr<Compilation> current;
+	std::vector<std::shared_ptr<Compilation>> replaced; // Still compiling, their pipelines are never used
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -3,35 +3,66 @@
 namespace MVE
 {
 Buffer::Buffer(Device& device, VkDeviceSize instanceSize, uint32_t instanceCount, VkBufferUsageFlags usageFlags,
-			   VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment):
+			   VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment, MemoryLifetime lifetime):
 	device(device),
 	instanceCount {instanceCount}, instanceSize {instanceSize}, usageFlags(usageFlags),
 	memoryPropertyFlags(memoryPropertyFlags)
 {
 	alignmentSize = GetAlignment(instanceSize, minOffsetAlignment);
 	bufferSize	  = alignmentSize * instanceCount;
-	device.CreateBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+	device.CreateBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation, lifetime);
 }
 
 Buffer::~Buffer()
 {
+	if (IsRegistered())
+		device.GetDefragmenter().Unregister(this);
 	Unmap();
 	vkDestroyBuffer(device.VulkanDevice(), buffer, nullptr);
-	vkFreeMemory(device.VulkanDevice(), memory, nullptr);
+	device.FreeMemory(allocation);
+}
+
+bool Buffer::Relocate(VkCommandBuffer commandBuffer, OldHandles& old)
+{
+	VkBufferCreateInfo bufferInfo {};
+	bufferInfo.sType	   = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size		   = bufferSize;
+	bufferInfo.usage	   = usageFlags;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer moved;
+	if (vkCreateBuffer(device.VulkanDevice(), &bufferInfo, nullptr, &moved) != VK_SUCCESS)
+		return false;
+
+	auto movedAllocation = device.GetMemoryAllocator().RelocateBuffer(moved, allocation);
+	if (movedAllocation.kind == Allocation::Kind::None) {
+		vkDestroyBuffer(device.VulkanDevice(), moved, nullptr);
+		return false;
+	}
+
+	VkBufferCopy region {0, 0, bufferSize};
+	vkCmdCopyBuffer(commandBuffer, buffer, moved, 1, &region);
+
+	old.buffer	   = buffer;
+	old.allocation = allocation;
+	buffer		   = moved;
+	allocation	   = movedAllocation;
+	return true;
 }
 
 VkResult Buffer::Map(VkDeviceSize size, VkDeviceSize offset)
 {
-	MVE_ASSERT(buffer && memory, "Can't map uninitialized buffer.");
-	return vkMapMemory(device.VulkanDevice(), memory, offset, size, 0, &mapped);
+	MVE_ASSERT(buffer && allocation.memory, "Can't map uninitialized buffer.");
+	if (allocation.mapped == nullptr)
+		return VK_ERROR_MEMORY_MAP_FAILED;
+
+	mapped = static_cast<char*>(allocation.mapped) + offset;
+	return VK_SUCCESS;
 }
 
 void Buffer::Unmap()
 {
-	if (mapped) {
-		vkUnmapMemory(device.VulkanDevice(), memory);
-		mapped = nullptr;
-	}
+	mapped = nullptr;
 }
 
 void Buffer::WriteToBuffer(void* data, VkDeviceSize size, VkDeviceSize offset)
@@ -49,11 +80,7 @@ void Buffer::WriteToBuffer(void* data, VkDeviceSize size, VkDeviceSize offset)
 
 VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset)
 {
-	VkMappedMemoryRange mappedRange = {};
-	mappedRange.sType				= VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	mappedRange.memory				= memory;
-	mappedRange.offset				= offset;
-	mappedRange.size				= size;
+	auto mappedRange = device.GetMemoryAllocator().MappedRange(allocation, offset, size);
 	return vkFlushMappedMemoryRanges(device.VulkanDevice(), 1, &mappedRange);
 }
 
@@ -68,11 +95,7 @@ VkDescriptorBufferInfo Buffer::DescriptorInfo(VkDeviceSize size, VkDeviceSize of
 
 VkResult Buffer::Invalidate(VkDeviceSize size, VkDeviceSize offset)
 {
-	VkMappedMemoryRange mappedRange = {};
-	mappedRange.sType				= VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	mappedRange.memory				= memory;
-	mappedRange.offset				= offset;
-	mappedRange.size				= size;
+	auto mappedRange = device.GetMemoryAllocator().MappedRange(allocation, offset, size);
 	return vkInvalidateMappedMemoryRanges(device.VulkanDevice(), 1, &mappedRange);
 }
 
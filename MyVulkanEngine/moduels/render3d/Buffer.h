@@ -1,19 +1,22 @@
 #pragma once
 
+#include "Defragmenter.h"
 #include "Device.h"
 
 namespace MVE
 {
-class Buffer
+class Buffer : public Relocatable
 {
   public:
 	Buffer(Device& device, VkDeviceSize instanceSize, uint32_t instanceCount, VkBufferUsageFlags usageFlags,
-		   VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment = 1);
-	~Buffer();
+		   VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment = 1,
+		   MemoryLifetime lifetime = MemoryLifetime::Persistent);
+	~Buffer() override;
 
 	Buffer(const Buffer&)			 = delete;
 	Buffer& operator=(const Buffer&) = delete;
 
+	// Host visible memory stays mapped by the allocator, this only hands out the pointer
 	VkResult Map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 	void Unmap();
 
@@ -35,15 +38,19 @@ class Buffer
 	VkBufferUsageFlags GetUsageFlags() const { return usageFlags; }
 	VkMemoryPropertyFlags GetMemoryPropertyFlags() const { return memoryPropertyFlags; }
 	VkDeviceSize GetBufferSize() const { return bufferSize; }
+	const Allocation& GetAllocation() const override { return allocation; }
+
+  protected:
+	bool Relocate(VkCommandBuffer commandBuffer, OldHandles& old) override;
 
   private:
 	static VkDeviceSize GetAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
 
   private:
 	Device& device;
-	void* mapped		  = nullptr;
-	VkBuffer buffer		  = VK_NULL_HANDLE;
-	VkDeviceMemory memory = VK_NULL_HANDLE;
+	void* mapped	= nullptr;
+	VkBuffer buffer = VK_NULL_HANDLE;
+	Allocation allocation;
 
 	VkDeviceSize bufferSize;
 	uint32_t instanceCount;
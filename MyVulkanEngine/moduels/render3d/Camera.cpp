@@ -11,6 +11,8 @@ void Camera::SetOrthographicProjection(float left, float right, float top, float
 	projMat[3][0] = -(right + left) / (right - left);
 	projMat[3][1] = -(bottom + top) / (bottom - top);
 	projMat[3][2] = -near / (far - near);
+	nearPlane	  = near;
+	farPlane	  = far;
 }
 void Camera::SetPerspectiveProjection(float fovy, float aspect, float near, float far)
 {
@@ -23,6 +25,8 @@ void Camera::SetPerspectiveProjection(float fovy, float aspect, float near, floa
 	projMat[2][2] = far / (far - near);
 	projMat[2][3] = 1.f;
 	projMat[3][2] = -(far * near) / (far - near);
+	nearPlane	  = near;
+	farPlane	  = far;
 }
 void Camera::SetViewDirection(glm::vec3 position, glm::vec3 direction, glm::vec3 up)
 {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "core/Bounds.h"
+
 namespace MVE
 {
 class Camera
@@ -19,11 +21,16 @@ class Camera
 	const glm::mat4& GetView() const { return viewMat; }
 	const glm::mat4& GetInverseView() const { return inverseViewMat; }
 	const glm::vec3 GetPosition() const { return glm::vec3(inverseViewMat[3]); }
+	Frustum GetFrustum() const { return Frustum(projMat * viewMat); }
+	float GetNear() const { return nearPlane; }
+	float GetFar() const { return farPlane; }
 
   private:
 	glm::mat4 projMat {1.0f};
 	glm::mat4 viewMat {1.0f};
 	glm::mat4 inverseViewMat {1.0f};
+	float nearPlane = 0.0f;
+	float farPlane	= 0.0f;
 };
 
 } // namespace MVE
\ No newline at end of file
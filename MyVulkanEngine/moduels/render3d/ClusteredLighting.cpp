@@ -0,0 +1,172 @@
+#include "ClusteredLighting.h"
+
+#include "SwapChain.h"
+
+#include "core/GameObject.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MVE
+{
+
+// Matches the push constants of cluster.comp
+struct ClusterPush
+{
+	glm::mat4 view;
+	glm::vec4 projection; // x and y scale of the projection, near and far plane
+	uint32_t lightCount;
+};
+
+constexpr uint32_t WORKGROUP_SIZE = 64;	   // local_size_x of cluster.comp
+constexpr float LIGHT_CUTOFF	  = 0.01f; // Intensity below which a light counts as out of range
+
+ClusteredLighting::ClusteredLighting(Device& device): device(device)
+{
+	descriptorPool = DescriptorPool::Builder(device)
+						 .SetMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
+						 .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT * 3)
+						 .Build();
+
+	setLayout = DescriptorSetLayout::Builder(device)
+					.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+					.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+					.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+					.Build();
+
+	// Every frame in flight has its own buffers, a frame's fence was waited on before they are written again
+	frames.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+	for (auto& frame : frames) {
+		frame.lightBuffer = std::make_unique<Buffer>(
+			device, sizeof(PointLight), MAX_POINT_LIGHTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		frame.lightBuffer->Map();
+		frame.countBuffer = std::make_unique<Buffer>(
+			device, sizeof(uint32_t), CLUSTER_COUNT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		frame.indexBuffer = std::make_unique<Buffer>(device, sizeof(uint32_t), CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER,
+													 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+													 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		auto lightInfo = frame.lightBuffer->DescriptorInfo();
+		auto countInfo = frame.countBuffer->DescriptorInfo();
+		auto indexInfo = frame.indexBuffer->DescriptorInfo();
+		DescriptorWriter(*setLayout, *descriptorPool)
+			.WriteBuffer(0, &lightInfo)
+			.WriteBuffer(1, &countInfo)
+			.WriteBuffer(2, &indexInfo)
+			.Build(frame.descriptorSet);
+	}
+
+	CreatePipeline();
+}
+
+ClusteredLighting::~ClusteredLighting()
+{
+	pipeline.Wait();
+	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+}
+
+void ClusteredLighting::CreatePipeline()
+{
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset	 = 0;
+	pushConstantRange.size		 = sizeof(ClusterPush);
+
+	VkDescriptorSetLayout descriptorSetLayout = setLayout->GetDescriptorSetLayout();
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+	pipelineLayoutInfo.sType				  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount		  = 1;
+	pipelineLayoutInfo.pSetLayouts			  = &descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges	  = &pushConstantRange;
+
+	auto error = vkCreatePipelineLayout(device.VulkanDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
+	MVE_ASSERT(error == VK_SUCCESS, "Failed to create the light clustering pipeline layout");
+
+	pipeline.Compile([&device = device, layout = pipelineLayout] {
+		return std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "cluster.comp.spv", layout);
+	});
+}
+
+float ClusteredLighting::Range(const PointLightComponent& light)
+{
+	if (light.range > 0.0f)
+		return light.range;
+
+	// Where the inverse square falloff of the brightest channel drops below the cutoff
+	float brightest = light.lightIntensity * std::max({light.color.r, light.color.g, light.color.b});
+	return std::sqrt(std::max(brightest, 0.0f) / LIGHT_CUTOFF);
+}
+
+void ClusteredLighting::Update(FrameInfo& frameInfo, Registry& registry, GlobalUbo& ubo, VkExtent2D extent)
+{
+	MVE_PROFILE_SCOPE("ClusteredLighting::Update");
+	auto& frame = frames[frameInfo.frameIndex];
+	auto lights = static_cast<PointLight*>(frame.lightBuffer->GetMappedMemory());
+
+	uint32_t count	 = 0;
+	uint32_t skipped = 0;
+	registry.View<TransformComponent, PointLightComponent>().Each(
+		[&](Entity entity, TransformComponent& transform, PointLightComponent& light) {
+			if (count == MAX_POINT_LIGHTS) {
+				skipped++;
+				return;
+			}
+			lights[count].position = glm::vec4(transform.GetTranslation(), Range(light));
+			lights[count].color	   = glm::vec4(light.color, light.lightIntensity);
+			count++;
+		});
+	frame.lightCount = count;
+
+	static bool warned = false;
+	if (skipped > 0 && !warned) {
+		MVE_WARN("Scene has more than {} point lights, {} lights are ignored", MAX_POINT_LIGHTS, skipped);
+		warned = true;
+	}
+
+	// Slice k starts at near * (far / near)^(k / GRID_Z), so the slice of a depth is GRID_Z * log(depth / near) /
+	// log(far / near)
+	float nearPlane	 = frameInfo.camera.GetNear();
+	float farPlane	 = frameInfo.camera.GetFar();
+	float sliceScale = GRID_Z / std::log(farPlane / nearPlane);
+	ubo.clusterScale = {float(GRID_X) / extent.width, float(GRID_Y) / extent.height, sliceScale,
+						-sliceScale * std::log(nearPlane)};
+	ubo.clusterGrid	 = {GRID_X, GRID_Y, GRID_Z, MAX_LIGHTS_PER_CLUSTER};
+}
+
+void ClusteredLighting::Cull(FrameInfo& frameInfo)
+{
+	MVE_PROFILE_SCOPE("ClusteredLighting::Cull");
+	auto& frame		   = frames[frameInfo.frameIndex];
+	auto commandBuffer = frameInfo.commandBuffer;
+	auto& projection   = frameInfo.camera.GetProjection();
+
+	auto clusterPipeline = pipeline.TryGet();
+	if (clusterPipeline) {
+		ClusterPush push {};
+		push.view		= frameInfo.camera.GetView();
+		push.projection = {projection[0][0], projection[1][1], frameInfo.camera.GetNear(), frameInfo.camera.GetFar()};
+		push.lightCount = frame.lightCount;
+
+		clusterPipeline->Bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1,
+								&frame.descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+		vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+	} else {
+		// Still compiling, every cluster is left without lights
+		vkCmdFillBuffer(commandBuffer, frame.countBuffer->GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+	}
+
+	VkMemoryBarrier barrier {};
+	barrier.sType		  = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+						 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "AsyncPipeline.h"
+#include "Buffer.h"
+#include "Descriptors.h"
+#include "FrameInfo.h"
+
+#include "core/Registry.h"
+
+namespace MVE
+{
+
+struct PointLightComponent;
+
+/// Clustered forward lighting. The view frustum is split into a grid of froxels, tiles on the screen and exponential
+/// slices in depth, and a compute pass lists the point lights whose range touches each froxel. pbr.frag only evaluates
+/// the lights of its own froxel, so the cost per pixel follows the local light density instead of the scene's light
+/// count. The grid assumes a perspective projection from Camera::SetPerspectiveProjection.
+class ClusteredLighting
+{
+  public:
+	static constexpr uint32_t GRID_X				 = 16;
+	static constexpr uint32_t GRID_Y				 = 9;
+	static constexpr uint32_t GRID_Z				 = 24;
+	static constexpr uint32_t CLUSTER_COUNT			 = GRID_X * GRID_Y * GRID_Z;
+	static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256; // Lights past this in a cluster are dropped
+	static constexpr uint32_t MAX_POINT_LIGHTS		 = 8192;
+
+  public:
+	ClusteredLighting(Device& device);
+	~ClusteredLighting();
+
+	ClusteredLighting(const ClusteredLighting&) = delete;
+	void operator=(const ClusteredLighting&)	= delete;
+
+	// Writes the frame's point lights and the grid parameters in ubo, before the global UBO is uploaded
+	void Update(FrameInfo& frameInfo, Registry& registry, GlobalUbo& ubo, VkExtent2D extent);
+	// Records the light binning. Must be outside a render pass, before the draws that read the clusters. Until the
+	// pipeline is compiled the clusters are cleared instead, and the point lights don't light anything.
+	void Cull(FrameInfo& frameInfo);
+
+	// Bound to the global descriptor set, read by pbr.frag
+	VkDescriptorBufferInfo LightInfo(int frameIndex) const { return frames[frameIndex].lightBuffer->DescriptorInfo(); }
+	VkDescriptorBufferInfo CountInfo(int frameIndex) const { return frames[frameIndex].countBuffer->DescriptorInfo(); }
+	VkDescriptorBufferInfo IndexInfo(int frameIndex) const { return frames[frameIndex].indexBuffer->DescriptorInfo(); }
+
+	// Distance at which the light is cut off, derived from its intensity when the component doesn't set one
+	static float Range(const PointLightComponent& light);
+
+  private:
+	struct FrameResources
+	{
+		std::unique_ptr<Buffer> lightBuffer; // Host visible, PointLights in world space
+		std::unique_ptr<Buffer> countBuffer; // Device local, lights per cluster
+		std::unique_ptr<Buffer> indexBuffer; // Device local, MAX_LIGHTS_PER_CLUSTER light indices per cluster
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		uint32_t lightCount			  = 0;
+	};
+
+	void CreatePipeline();
+
+  private:
+	Device& device;
+
+	std::unique_ptr<DescriptorPool> descriptorPool;
+	std::unique_ptr<DescriptorSetLayout> setLayout;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	AsyncPipeline<ComputePipeline> pipeline;
+
+	std::vector<FrameResources> frames;
+};
+
+} // namespace MVE
\ No newline at end of file
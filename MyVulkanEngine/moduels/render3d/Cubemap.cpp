@@ -1,8 +1,19 @@
 #include "Cubemap.h"
 
+#include "AsyncPipeline.h"
 #include "Camera.h"
 #include "Descriptors.h"
-#include "Pipeline.h"
+
+// The passes read what the one before wrote
+static void ComputeBarrier(VkCommandBuffer commandBuffer)
+{
+	VkMemoryBarrier barrier {};
+	barrier.sType		  = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+						 1, &barrier, 0, nullptr, 0, nullptr);
+}
 
 MVE::Cubemap::Cubemap(Device& device, const std::string& folderPath, const std::string& extension): device(device)
 {
@@ -39,40 +50,37 @@ void MVE::Cubemap::CreateFromHdri(const std::string& filepath, uint32_t resoluti
 	for (int i = 0; i < 6; i++) { builder.addLayer(FloatSolidTextureSource(glm::vec4 {1.0f}, resolution, resolution)); }
 
 	texture = builder.build();
-	texture->TransitionImageLayout(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-								   VK_IMAGE_LAYOUT_GENERAL, 6, texture->mipMaps());
 
-	Equirect2Cubemap(filepath);
-	GenerateIBL();
+	std::shared_ptr<Texture> hdri = Texture::Builder(device)
+										.format(VK_FORMAT_R32G32B32A32_SFLOAT)
+										.addressMode(VK_SAMPLER_ADDRESS_MODE_REPEAT)
+										.addLayer(FloatFileTextureSource(filepath))
+										.build();
+	CreateIrradiance(32);
+
+	std::vector<AsyncCompute::TextureUse> textures {{texture.get(), VK_IMAGE_LAYOUT_GENERAL},
+													{irradiance.get(), VK_IMAGE_LAYOUT_GENERAL},
+													{hdri.get(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}};
+	ticket = device.GetAsyncCompute().Submit("Cubemap::CreateFromHdri", textures, [&](AsyncCompute::Job& job) {
+		Equirect2Cubemap(job, *hdri);
+		ComputeBarrier(job.commandBuffer);
+		GenerateIrradiance(job);
+		ComputeBarrier(job.commandBuffer);
+		PrefilterMap(job);
+		job.OnComplete([hdri] {});
+	});
 }
 
-void MVE::Cubemap::Equirect2Cubemap(const std::string& filepath)
+void MVE::Cubemap::Equirect2Cubemap(AsyncCompute::Job& job, Texture& hdri)
 {
-	auto hdri = Texture::Builder(device)
-					.format(VK_FORMAT_R32G32B32A32_SFLOAT)
-					.addressMode(VK_SAMPLER_ADDRESS_MODE_REPEAT)
-					.addLayer(FloatFileTextureSource(filepath))
-					.build();
-
-	auto descriptorPool = DescriptorPool::Builder(device)
-							  .SetMaxSets(1)
-							  .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
-							  .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1)
-							  .Build();
-
-	auto setLayout = DescriptorSetLayout::Builder(device)
-						 .AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
-						 .AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
-						 .Build();
-
-	auto hdriInfo	 = hdri->ImageInfo();
-	auto textureInfo = texture->ImageInfo();
-
-	VkDescriptorSet set;
-	DescriptorWriter(*setLayout, *descriptorPool).WriteImage(0, &hdriInfo).WriteImage(1, &textureInfo).Build(set);
-
-	// create pipeline
-	std::unique_ptr<ComputePipeline> pipeline;
+	std::shared_ptr<DescriptorSetLayout> setLayout =
+		DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+			.Build();
+
+	// create pipeline, it compiles on a worker while the descriptors are written
+	auto pipeline = std::make_shared<AsyncPipeline<ComputePipeline>>();
 	VkPipelineLayout pipelineLayout;
 
 	std::vector<VkDescriptorSetLayout> descripotorSetLayouts {setLayout->GetDescriptorSetLayout()};
@@ -86,12 +94,25 @@ void MVE::Cubemap::Equirect2Cubemap(const std::string& filepath)
 
 	vkCreatePipelineLayout(device.VulkanDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
 
-	pipeline = std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "equirect2cube.comp.spv", pipelineLayout);
+	pipeline->Compile([&device = device, pipelineLayout] {
+		return std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "equirect2cube.comp.spv", pipelineLayout);
+	});
 
-	// render
-	auto commandBuffer = device.BeginSingleTimeCommands();
+	std::shared_ptr<DescriptorPool> descriptorPool = DescriptorPool::Builder(device)
+														 .SetMaxSets(1)
+														 .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+														 .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1)
+														 .Build();
+
+	auto hdriInfo	 = hdri.ImageInfo();
+	auto textureInfo = texture->ImageInfo();
 
-	pipeline->Bind(commandBuffer);
+	VkDescriptorSet set;
+	DescriptorWriter(*setLayout, *descriptorPool).WriteImage(0, &hdriInfo).WriteImage(1, &textureInfo).Build(set);
+
+	// render
+	auto commandBuffer = job.commandBuffer;
+	pipeline->Get().Bind(commandBuffer);
 
 	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
 
@@ -99,17 +120,26 @@ void MVE::Cubemap::Equirect2Cubemap(const std::string& filepath)
 	vkCmdDispatch(commandBuffer, texture->width() / shaderLocalSize.x, texture->height() / shaderLocalSize.y,
 				  texture->layers() / shaderLocalSize.z);
 
-	device.EndSingleTimeCommands(commandBuffer);
-	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+	// The captures live until the job finished
+	job.OnComplete([&device = device, pipelineLayout, setLayout, descriptorPool, pipeline] {
+		vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+	});
 }
 
 void MVE::Cubemap::GenerateIBL(uint32_t irradianceResolution)
 {
-	GenerateIrradiance(irradianceResolution);
-	PrefilterMap();
+	CreateIrradiance(irradianceResolution);
+
+	std::vector<AsyncCompute::TextureUse> textures {{texture.get(), VK_IMAGE_LAYOUT_GENERAL},
+													{irradiance.get(), VK_IMAGE_LAYOUT_GENERAL}};
+	ticket = device.GetAsyncCompute().Submit("Cubemap::GenerateIBL", textures, [&](AsyncCompute::Job& job) {
+		GenerateIrradiance(job);
+		ComputeBarrier(job.commandBuffer);
+		PrefilterMap(job);
+	});
 }
 
-void MVE::Cubemap::GenerateIrradiance(uint32_t resolution)
+void MVE::Cubemap::CreateIrradiance(uint32_t resolution)
 {
 	Texture::Builder builder(device);
 	builder.isCubemap(true)
@@ -120,26 +150,18 @@ void MVE::Cubemap::GenerateIrradiance(uint32_t resolution)
 
 	for (int i = 0; i < 6; i++) { builder.addLayer(FloatSolidTextureSource(glm::vec4 {1.0f}, resolution, resolution)); }
 	irradiance = builder.build();
+}
 
-	auto descriptorPool = DescriptorPool::Builder(device)
-							  .SetMaxSets(1)
-							  .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
-							  .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1)
-							  .Build();
-
-	auto setLayout = DescriptorSetLayout::Builder(device)
-						 .AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
-						 .AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
-						 .Build();
-
-	auto textureInfo	= texture->ImageInfo();
-	auto irradianceInfo = irradiance->ImageInfo();
-
-	VkDescriptorSet set;
-	DescriptorWriter(*setLayout, *descriptorPool).WriteImage(0, &textureInfo).WriteImage(1, &irradianceInfo).Build(set);
-
-	// create pipeline
-	std::unique_ptr<ComputePipeline> pipeline;
+void MVE::Cubemap::GenerateIrradiance(AsyncCompute::Job& job)
+{
+	std::shared_ptr<DescriptorSetLayout> setLayout =
+		DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+			.Build();
+
+	// create pipeline, it compiles on a worker while the descriptors are written
+	auto pipeline = std::make_shared<AsyncPipeline<ComputePipeline>>();
 	VkPipelineLayout pipelineLayout;
 
 	std::vector<VkDescriptorSetLayout> descripotorSetLayouts {setLayout->GetDescriptorSetLayout()};
@@ -153,13 +175,26 @@ void MVE::Cubemap::GenerateIrradiance(uint32_t resolution)
 
 	vkCreatePipelineLayout(device.VulkanDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
 
-	pipeline =
-		std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "irradianceGenerator.comp.spv", pipelineLayout);
+	pipeline->Compile([&device = device, pipelineLayout] {
+		return std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "irradianceGenerator.comp.spv",
+												 pipelineLayout);
+	});
 
-	// render
-	auto commandBuffer = device.BeginSingleTimeCommands();
+	std::shared_ptr<DescriptorPool> descriptorPool = DescriptorPool::Builder(device)
+														 .SetMaxSets(1)
+														 .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+														 .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1)
+														 .Build();
+
+	auto textureInfo	= texture->ImageInfo();
+	auto irradianceInfo = irradiance->ImageInfo();
 
-	pipeline->Bind(commandBuffer);
+	VkDescriptorSet set;
+	DescriptorWriter(*setLayout, *descriptorPool).WriteImage(0, &textureInfo).WriteImage(1, &irradianceInfo).Build(set);
+
+	// render
+	auto commandBuffer = job.commandBuffer;
+	pipeline->Get().Bind(commandBuffer);
 
 	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
 
@@ -167,23 +202,69 @@ void MVE::Cubemap::GenerateIrradiance(uint32_t resolution)
 	vkCmdDispatch(commandBuffer, texture->width() / shaderLocalSize.x, texture->height() / shaderLocalSize.y,
 				  texture->layers() / shaderLocalSize.z);
 
-	device.EndSingleTimeCommands(commandBuffer);
-	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+	job.OnComplete([&device = device, pipelineLayout, setLayout, descriptorPool, pipeline] {
+		vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+	});
 }
 
-void MVE::Cubemap::PrefilterMap()
+void MVE::Cubemap::PrefilterMap(AsyncCompute::Job& job)
 {
-	uint32_t levels		= texture->mipMaps();
-	auto descriptorPool = DescriptorPool::Builder(device)
-							  .SetMaxSets(1)
-							  .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
-							  .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levels - 1)
-							  .Build();
-
-	auto setLayout = DescriptorSetLayout::Builder(device)
-						 .AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
-						 .AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, levels - 1)
-						 .Build();
+	uint32_t levels = texture->mipMaps();
+
+	std::shared_ptr<DescriptorSetLayout> setLayout =
+		DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, levels - 1)
+			.Build();
+
+	struct
+	{
+		int level;
+		float roughness;
+	} pushConstants;
+
+	// create pipeline, it compiles on a worker while the mip views are created
+	auto pipeline = std::make_shared<AsyncPipeline<ComputePipeline>>();
+	VkPipelineLayout pipelineLayout;
+
+	std::vector<VkDescriptorSetLayout> descripotorSetLayouts {setLayout->GetDescriptorSetLayout()};
+
+	VkPushConstantRange pushRange {};
+	pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushRange.offset	 = 0;
+	pushRange.size		 = sizeof(pushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+	pipelineLayoutInfo.sType				  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount		  = descripotorSetLayouts.size();
+	pipelineLayoutInfo.pSetLayouts			  = descripotorSetLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges	  = &pushRange;
+
+	vkCreatePipelineLayout(device.VulkanDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
+
+	pipeline->Compile([&device = device, pipelineLayout, levels] {
+		const uint32_t specializationData[] = {levels - 1};
+		VkSpecializationMapEntry specializationMap {};
+		specializationMap.constantID = 0;
+		specializationMap.offset	 = 0;
+		specializationMap.size		 = sizeof(uint32_t);
+
+		VkSpecializationInfo specializationInfo {};
+		specializationInfo.mapEntryCount = 1;
+		specializationInfo.pData		 = specializationData;
+		specializationInfo.pMapEntries	 = &specializationMap;
+		specializationInfo.dataSize		 = sizeof(specializationData);
+
+		return std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "prefilterSkybox.comp.spv", pipelineLayout,
+												 &specializationInfo);
+	});
+
+	std::shared_ptr<DescriptorPool> descriptorPool = DescriptorPool::Builder(device)
+														 .SetMaxSets(1)
+														 .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+														 .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levels - 1)
+														 .Build();
 
 	auto textureInfo = texture->ImageInfo();
 	std::vector<VkDescriptorImageInfo> mipMapsImageInfos;
@@ -220,50 +301,9 @@ void MVE::Cubemap::PrefilterMap()
 		.WriteImage(1, mipMapsImageInfos.data(), levels - 1)
 		.Build(set);
 
-	struct
-	{
-		int level;
-		float roughness;
-	} pushConstants;
-
-	// create pipeline
-	std::unique_ptr<ComputePipeline> pipeline;
-	VkPipelineLayout pipelineLayout;
-
-	std::vector<VkDescriptorSetLayout> descripotorSetLayouts {setLayout->GetDescriptorSetLayout()};
-
-	VkPushConstantRange pushRange {};
-	pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-	pushRange.offset	 = 0;
-	pushRange.size		 = sizeof(pushConstants);
-
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
-	pipelineLayoutInfo.sType				  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount		  = descripotorSetLayouts.size();
-	pipelineLayoutInfo.pSetLayouts			  = descripotorSetLayouts.data();
-	pipelineLayoutInfo.pushConstantRangeCount = 1;
-	pipelineLayoutInfo.pPushConstantRanges	  = &pushRange;
-
-	const uint32_t specializationData[] = {levels - 1};
-	VkSpecializationMapEntry specializationMap {};
-	specializationMap.constantID = 0;
-	specializationMap.offset	 = 0;
-	specializationMap.size		 = sizeof(uint32_t);
-
-	VkSpecializationInfo specializationInfo {};
-	specializationInfo.mapEntryCount = 1;
-	specializationInfo.pData		 = specializationData;
-	specializationInfo.pMapEntries	 = &specializationMap;
-	specializationInfo.dataSize		 = sizeof(specializationData);
-
-	vkCreatePipelineLayout(device.VulkanDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
-
-	pipeline = std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "prefilterSkybox.comp.spv", pipelineLayout,
-												 &specializationInfo);
-
 	// render
-	auto commandBuffer = device.BeginSingleTimeCommands();
-	pipeline->Bind(commandBuffer);
+	auto commandBuffer = job.commandBuffer;
+	pipeline->Get().Bind(commandBuffer);
 
 	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
 
@@ -284,8 +324,8 @@ void MVE::Cubemap::PrefilterMap()
 		height = std::max<uint32_t>(height / 2, shaderLocalSize.y);
 	}
 
-	device.EndSingleTimeCommands(commandBuffer);
-	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
-
-	for (auto& info : mipMapsImageInfos) { vkDestroyImageView(device.VulkanDevice(), info.imageView, nullptr); }
+	job.OnComplete([&device = device, pipelineLayout, setLayout, descriptorPool, pipeline, mipMapsImageInfos] {
+		vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+		for (auto& info : mipMapsImageInfos) { vkDestroyImageView(device.VulkanDevice(), info.imageView, nullptr); }
+	});
 }
\ No newline at end of file
@@ -1,34 +1,45 @@
 #pragma once
 
+#include "AsyncCompute.h"
 #include "Texture.h"
 
 namespace MVE
 {
+/// An environment and its image based lighting maps. The maps are generated by compute passes on the AsyncCompute
+/// queue, they may only be used once IsReady returns true.
 class Cubemap
 {
   public:
 	Cubemap(Device& device): device(device) {}
 	Cubemap(Device& device, const std::string& folderPath, const std::string& extension);
 
-	~Cubemap() {}
+	~Cubemap() { Wait(); }
 
+	// Only starts the passes, so they can be called on a loading thread
 	void CreateFromHdri(const std::string& filepath, uint32_t resolution = 512);
 	void GenerateIBL(uint32_t irradianceResolution = 32);
 
+	bool IsReady() const { return device.GetAsyncCompute().IsComplete(ticket); }
+	// Blocks until the passes ran, for load time
+	void Wait() { device.GetAsyncCompute().Wait(ticket); }
+
 	VkDescriptorImageInfo ImageInfo() const { return texture->ImageInfo(); };
 	VkDescriptorImageInfo IrradianceImageInfo() const { return irradiance->ImageInfo(); };
 
   private:
 	void CreateTexture(const std::string& folderPath, const std::string& extension = "png");
-	void Equirect2Cubemap(const std::string& filepath);
+	void CreateIrradiance(uint32_t resolution);
 
-	void GenerateIrradiance(uint32_t resolution);
-	void PrefilterMap();
+	// Record the passes into the job
+	void Equirect2Cubemap(AsyncCompute::Job& job, Texture& hdri);
+	void GenerateIrradiance(AsyncCompute::Job& job);
+	void PrefilterMap(AsyncCompute::Job& job);
 
   private:
 	Device& device;
 	std::shared_ptr<Texture> texture;
 	std::shared_ptr<Texture> irradiance;
+	AsyncCompute::Ticket ticket = 0;
 };
 
 } // namespace MVE
\ No newline at end of file
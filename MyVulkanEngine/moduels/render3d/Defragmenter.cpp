@@ -0,0 +1,154 @@
+#include "Defragmenter.h"
+
+#include "SwapChain.h"
+#include "UploadManager.h"
+
+#include <algorithm>
+
+namespace MVE
+{
+
+constexpr uint32_t SEARCH_INTERVAL = 60; // Frames between searches for a block to empty
+
+Defragmenter::Defragmenter(Device& device): device(device)
+{
+}
+
+Defragmenter::~Defragmenter()
+{
+	MVE_ASSERT(resources.empty(), "{} relocatable resources outlived the Defragmenter", resources.size());
+	for (auto& old : retired) { old.framesLeft = 1; }
+	ReleaseRetired();
+}
+
+void Defragmenter::Register(Relocatable* resource)
+{
+	std::lock_guard lock(mutex);
+	resources.insert(resource);
+	resource->registered = true;
+}
+
+void Defragmenter::Unregister(Relocatable* resource)
+{
+	std::lock_guard lock(mutex);
+	resources.erase(resource);
+	resource->registered = false;
+}
+
+void Defragmenter::Update()
+{
+	MVE_PROFILE_FUNCTION();
+	ReleaseRetired();
+
+	std::lock_guard lock(mutex);
+	if (!hasSource) {
+		if (framesToWait > 0) {
+			framesToWait--;
+			return;
+		}
+		framesToWait = SEARCH_INTERVAL;
+		if (!FindSourceBlock())
+			return;
+	}
+
+	// The ones moved on earlier frames aren't in the block anymore
+	std::vector<Relocatable*> moving;
+	for (auto resource : resources) {
+		auto& allocation = resource->GetAllocation();
+		if (allocation.kind == Allocation::Kind::Block && allocation.pool == sourcePool &&
+			allocation.block == sourceBlock)
+			moving.push_back(resource);
+	}
+	if (moving.empty()) {
+		// The block is given back when the last of the old allocations is freed
+		hasSource = false;
+		return;
+	}
+
+	device.GetUploadManager().Record([&](VkCommandBuffer commandBuffer) {
+		// Whatever wrote to the resources before has to land before they are copied
+		VkMemoryBarrier barrier {};
+		barrier.sType		  = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+							 &barrier, 0, nullptr, 0, nullptr);
+
+		VkDeviceSize movedBytes = 0;
+		for (auto resource : moving) {
+			VkDeviceSize size = resource->GetAllocation().size;
+			if (movedBytes > 0 && movedBytes + size > bytesPerFrame)
+				break;
+
+			RetiredHandles old {{}, SwapChain::MAX_FRAMES_IN_FLIGHT + 1};
+			if (!resource->Relocate(commandBuffer, old.handles)) {
+				// The other blocks filled up since the block was picked
+				hasSource = false;
+				break;
+			}
+			resource->generation = Relocatable::NextGeneration();
+			retired.push_back(old);
+			movedBytes += size;
+			stats.movedResources++;
+		}
+		stats.movedBytes += movedBytes;
+
+		// Uploads recorded after this write to the new memory
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+							 &barrier, 0, nullptr, 0, nullptr);
+	});
+}
+
+Defragmenter::Stats Defragmenter::GetStats() const
+{
+	std::lock_guard lock(mutex);
+	return stats;
+}
+
+bool Defragmenter::FindSourceBlock()
+{
+	std::map<std::pair<uint32_t, uint32_t>, VkDeviceSize> movableBytes; // Pool and block -> bytes
+	for (auto resource : resources) {
+		auto& allocation = resource->GetAllocation();
+		if (allocation.kind == Allocation::Kind::Block)
+			movableBytes[{allocation.pool, allocation.block}] += allocation.size;
+	}
+
+	std::vector<std::pair<VkDeviceSize, std::pair<uint32_t, uint32_t>>> candidates;
+	for (auto& [block, bytes] : movableBytes) { candidates.push_back({bytes, block}); }
+	std::sort(candidates.begin(), candidates.end());
+
+	auto& allocator = device.GetMemoryAllocator();
+	for (auto& [bytes, block] : candidates) {
+		if (allocator.CanEmptyBlock(block.first, block.second, bytes)) {
+			hasSource	= true;
+			sourcePool	= block.first;
+			sourceBlock = block.second;
+			return true;
+		}
+	}
+	return false;
+}
+
+void Defragmenter::ReleaseRetired()
+{
+	auto vkDevice = device.VulkanDevice();
+	for (size_t i = 0; i < retired.size();) {
+		if (--retired[i].framesLeft > 0) {
+			i++;
+			continue;
+		}
+		auto& handles = retired[i].handles;
+		vkDestroyImageView(vkDevice, handles.imageView, nullptr);
+		vkDestroyImage(vkDevice, handles.image, nullptr);
+		vkDestroyBuffer(vkDevice, handles.buffer, nullptr);
+		device.FreeMemory(handles.allocation);
+
+		retired[i] = retired.back();
+		retired.pop_back();
+	}
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Device.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace MVE
+{
+
+/// A buffer or texture whose memory the Defragmenter may move. Its handles change when it moves, so whatever keeps
+/// them, like a descriptor set, has to fetch them again once its generation changed.
+class Relocatable
+{
+  public:
+	virtual ~Relocatable() = default;
+
+	virtual const Allocation& GetAllocation() const = 0;
+	bool IsRegistered() const { return registered; }
+	// Changes whenever the handles do. No two resources ever share a generation, so it also tells a resource apart
+	// from one that was created at the same address after it was destroyed.
+	uint64_t Generation() const { return generation; }
+
+  protected:
+	friend class Defragmenter;
+
+	// What a move replaced, destroyed once the frames in flight are done with it
+	struct OldHandles
+	{
+		VkBuffer buffer		  = VK_NULL_HANDLE;
+		VkImage image		  = VK_NULL_HANDLE;
+		VkImageView imageView = VK_NULL_HANDLE;
+		Allocation allocation;
+	};
+
+	// Creates the resource again in memory of another block and records the copy of its content. Returns false,
+	// changing nothing, when the other blocks have no room.
+	virtual bool Relocate(VkCommandBuffer commandBuffer, OldHandles& old) = 0;
+
+  private:
+	static uint64_t NextGeneration() { return ++generationCounter; }
+
+  private:
+	static inline std::atomic<uint64_t> generationCounter = 0;
+
+	bool registered		= false;
+	uint64_t generation = NextGeneration();
+};
+
+/// Moves relocatable resources out of sparsely used device local blocks, so the MemoryAllocator can give the blocks
+/// back once they are empty. The work is spread over frames, each one moves resources until bytesPerFrame is used up.
+/// The copies go into the UploadManager's batch, in order with the uploads, so data uploaded to a resource before and
+/// after its move both end up in the new memory. The batch is submitted ahead of the frame, which already draws from
+/// the new memory, and nothing waits for the copies.
+class Defragmenter
+{
+  public:
+	struct Stats
+	{
+		VkDeviceSize movedBytes = 0;
+		uint32_t movedResources = 0;
+	};
+
+  public:
+	explicit Defragmenter(Device& device);
+	~Defragmenter();
+
+	Defragmenter(const Defragmenter&)	= delete;
+	void operator=(const Defragmenter&) = delete;
+
+	// The resource's usage must allow it to be the source and the destination of transfers
+	void Register(Relocatable* resource);
+	// Called by the resource's destructor before its handles are destroyed
+	void Unregister(Relocatable* resource);
+
+	// Called once per frame, before the frame is recorded
+	void Update();
+
+	// A single resource bigger than this is still moved, on a frame of its own
+	void SetBytesPerFrame(VkDeviceSize bytes) { bytesPerFrame = bytes; }
+	Stats GetStats() const;
+
+  private:
+	struct RetiredHandles
+	{
+		Relocatable::OldHandles handles;
+		uint32_t framesLeft;
+	};
+
+	// Picks the block with the fewest bytes in it that can be emptied
+	bool FindSourceBlock();
+	void ReleaseRetired();
+
+  private:
+	Device& device;
+	VkDeviceSize bytesPerFrame = VkDeviceSize(8) << 20;
+
+	mutable std::mutex mutex; // Resources are created and destroyed on loading threads too
+	std::unordered_set<Relocatable*> resources;
+	std::vector<RetiredHandles> retired;
+
+	bool hasSource		  = false;
+	uint32_t sourcePool	  = 0;
+	uint32_t sourceBlock  = 0;
+	uint32_t framesToWait = 0; // Until the next search for a source block, which goes over every resource
+	Stats stats;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -1,8 +1,18 @@
 #include "Device.h"
 
+#include "AsyncCompute.h"
+#include "Defragmenter.h"
+#include "MeshPool.h"
+#include "Model.h"
+#include "UploadManager.h"
+
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
 namespace MVE
 {
 // local callback functions
@@ -44,16 +54,35 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
 // class member functions
 Device::Device(Window& window): window {window}
 {
+	// Headless devices render into offscreen images, so they don't need a surface or a swap chain.
+	if (IsHeadless())
+		deviceExtensions.clear();
+
 	CreateInstance();
 	SetupDebugMessenger();
 	CreateSurface();
 	PickPhysicalDevice();
 	CreateLogicalDevice();
 	CreateCommandPool();
+	CreatePipelineCache();
+
+	memoryAllocator = std::make_unique<MemoryAllocator>(device_, physicalDevice);
+	defragmenter	= std::make_unique<Defragmenter>(*this);
+	uploadManager	= std::make_unique<UploadManager>(*this);
+	asyncCompute	= std::make_unique<AsyncCompute>(*this);
+	meshPool		= std::make_unique<MeshPool>(*this, sizeof(Model::Vertex));
 }
 
 Device::~Device()
 {
+	// Its buffers have to go before the device, and every allocation before the allocator
+	asyncCompute.reset();
+	uploadManager.reset();
+	meshPool.reset();
+	defragmenter.reset();
+	memoryAllocator.reset();
+	SavePipelineCache();
+	vkDestroyPipelineCache(device_, pipelineCache, nullptr);
 	vkDestroyCommandPool(device_, commandPool, nullptr);
 	vkDestroyDevice(device_, nullptr);
 
@@ -137,7 +166,8 @@ void Device::CreateLogicalDevice()
 	QueueFamilyIndices indices = FindQueueFamilies(physicalDevice);
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+	std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, indices.transferFamily,
+											  indices.computeFamily};
 
 	float queuePriority = 1.0f;
 	for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -149,8 +179,15 @@ void Device::CreateLogicalDevice()
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
-	VkPhysicalDeviceFeatures deviceFeatures = {};
-	deviceFeatures.samplerAnisotropy		= VK_TRUE;
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+	// Optional features are enabled when the device has them, users check Device::features
+	VkPhysicalDeviceFeatures deviceFeatures	 = {};
+	deviceFeatures.samplerAnisotropy		 = VK_TRUE;
+	deviceFeatures.multiDrawIndirect		 = supportedFeatures.multiDrawIndirect;
+	deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+	features								 = deviceFeatures;
 
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType			  = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -176,8 +213,29 @@ void Device::CreateLogicalDevice()
 	}
 
 	vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
-	vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &computeQueue_);
+	vkGetDeviceQueue(device_, indices.computeFamily, 0, &computeQueue_);
 	vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+	vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+	for (VkQueue queue : {graphicsQueue_, computeQueue_, presentQueue_, transferQueue_}) {
+		if (!queueMutexes.contains(queue))
+			queueMutexes[queue] = std::make_unique<std::mutex>();
+	}
+	if (indices.transferFamily != indices.graphicsFamily)
+		MVE_INFO("Uploading on the transfer queue family {}", indices.transferFamily);
+	if (indices.computeFamily != indices.graphicsFamily)
+		MVE_INFO("Async compute on the queue family {}", indices.computeFamily);
+}
+
+VkResult Device::QueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* submits, VkFence fence)
+{
+	std::lock_guard lock(*queueMutexes.at(queue));
+	return vkQueueSubmit(queue, submitCount, submits, fence);
+}
+
+VkResult Device::QueuePresent(const VkPresentInfoKHR& presentInfo)
+{
+	std::lock_guard lock(*queueMutexes.at(presentQueue_));
+	return vkQueuePresentKHR(presentQueue_, &presentInfo);
 }
 
 void Device::CreateCommandPool()
@@ -194,8 +252,137 @@ void Device::CreateCommandPool()
 	}
 }
 
+// Written in front of the driver's cache data. The driver checks its own header too, but a cache from another GPU or
+// driver is rejected here before it's handed over, and the checksum catches files that were cut off while saving.
+struct PipelineCacheFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vendorId;
+	uint32_t deviceId;
+	uint32_t driverVersion;
+	uint8_t pipelineCacheUuid[VK_UUID_SIZE];
+	uint64_t dataSize;
+	uint64_t checksum;
+};
+
+constexpr uint32_t PIPELINE_CACHE_MAGIC	  = 0x4350564D; // "MVPC"
+constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+static uint64_t PipelineCacheChecksum(const std::vector<char>& data)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : data) { hash = (hash ^ uint8_t(c)) * 1099511628211ull; }
+	return hash;
+}
+
+std::vector<char> Device::LoadPipelineCacheData()
+{
+	std::ifstream file(PIPELINE_CACHE_PATH, std::ios::binary);
+	if (!file.is_open())
+		return {};
+
+	PipelineCacheFileHeader header {};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		MVE_WARN("Pipeline cache file is too small, ignoring it");
+		return {};
+	}
+
+	if (header.magic != PIPELINE_CACHE_MAGIC || header.version != PIPELINE_CACHE_VERSION) {
+		MVE_WARN("Pipeline cache file has an unknown format, ignoring it");
+		return {};
+	}
+	if (header.vendorId != properties.vendorID || header.deviceId != properties.deviceID ||
+		header.driverVersion != properties.driverVersion ||
+		std::memcmp(header.pipelineCacheUuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+		MVE_INFO("Pipeline cache was written by another device or driver, starting with an empty one");
+		return {};
+	}
+
+	// A corrupted size must not decide how much is allocated
+	auto dataStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	auto remaining = file.tellg() - dataStart;
+	file.seekg(dataStart);
+	if (remaining < 0 || uint64_t(remaining) != header.dataSize) {
+		MVE_WARN("Pipeline cache file is corrupted, ignoring it");
+		return {};
+	}
+
+	std::vector<char> data(header.dataSize);
+	if (!file.read(data.data(), data.size()) || PipelineCacheChecksum(data) != header.checksum) {
+		MVE_WARN("Pipeline cache file is corrupted, ignoring it");
+		return {};
+	}
+	return data;
+}
+
+void Device::CreatePipelineCache()
+{
+	auto data = LoadPipelineCacheData();
+
+	VkPipelineCacheCreateInfo cacheInfo {};
+	cacheInfo.sType			  = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = data.size();
+	cacheInfo.pInitialData	  = data.empty() ? nullptr : data.data();
+
+	if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+		// The data passed the checks but the driver still refused it, an empty cache always works
+		MVE_WARN("Failed to create the pipeline cache from {} bytes of data, starting with an empty one", data.size());
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData	  = nullptr;
+		auto error				  = vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache);
+		MVE_ASSERT(error == VK_SUCCESS, "Failed to create pipeline cache");
+	} else if (!data.empty()) {
+		MVE_INFO("Loaded {} bytes of pipeline cache", data.size());
+	}
+}
+
+void Device::SavePipelineCache()
+{
+	MVE_PROFILE_FUNCTION();
+
+	size_t size = 0;
+	if (vkGetPipelineCacheData(device_, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+		return;
+	std::vector<char> data(size);
+	if (vkGetPipelineCacheData(device_, pipelineCache, &size, data.data()) != VK_SUCCESS)
+		return;
+	data.resize(size);
+
+	PipelineCacheFileHeader header {};
+	header.magic		 = PIPELINE_CACHE_MAGIC;
+	header.version		 = PIPELINE_CACHE_VERSION;
+	header.vendorId		 = properties.vendorID;
+	header.deviceId		 = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	std::memcpy(header.pipelineCacheUuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.dataSize = data.size();
+	header.checksum = PipelineCacheChecksum(data);
+
+	// Written next to the old file and renamed over it, so a crash while saving never leaves half a cache behind
+	std::string tempPath = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+			!file.write(data.data(), data.size())) {
+			MVE_WARN("Failed to write the pipeline cache to {}", tempPath);
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+	if (error)
+		MVE_WARN("Failed to save the pipeline cache: {}", error.message());
+}
+
 void Device::CreateSurface()
 {
+	if (IsHeadless())
+		return;
+
 	auto code = glfwCreateWindowSurface(instance, window.GetNativeWindow(), nullptr, &surface_);
 	MVE_ASSERT(code == VK_SUCCESS, "Failed to create window surface!");
 }
@@ -206,8 +393,8 @@ bool Device::IsDeviceSuitable(VkPhysicalDevice device)
 
 	bool extensionsSupported = CheckDeviceExtensionSupport(device);
 
-	bool swapChainAdequate = false;
-	if (extensionsSupported) {
+	bool swapChainAdequate = IsHeadless();
+	if (extensionsSupported && !IsHeadless()) {
 		SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(device);
 		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
@@ -270,11 +457,15 @@ bool Device::CheckValidationLayerSupport()
 
 std::vector<const char*> Device::GetRequiredExtensions()
 {
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	std::vector<const char*> extensions;
 
-	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	if (!IsHeadless()) {
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions;
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+		extensions.insert(extensions.end(), glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
 
 	if (enableValidationLayers) {
 		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -340,7 +531,10 @@ QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice device)
 			indices.graphicsFamilyHasValue = true;
 		}
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+		if (IsHeadless())
+			presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == i;
+		else
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
 		if (queueFamily.queueCount > 0 && presentSupport) {
 			indices.presentFamily		  = i;
 			indices.presentFamilyHasValue = true;
@@ -352,6 +546,27 @@ QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice device)
 		i++;
 	}
 
+	// Uploads copy whole mip levels, which every minImageTransferGranularity allows
+	indices.transferFamily = indices.graphicsFamily;
+	for (uint32_t family = 0; family < queueFamilyCount; family++) {
+		auto flags = queueFamilies[family].queueFlags;
+		if (queueFamilies[family].queueCount > 0 && (flags & VK_QUEUE_TRANSFER_BIT) &&
+			!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			indices.transferFamily = family;
+			break;
+		}
+	}
+
+	indices.computeFamily = indices.graphicsFamily;
+	for (uint32_t family = 0; family < queueFamilyCount; family++) {
+		auto flags = queueFamilies[family].queueFlags;
+		if (queueFamilies[family].queueCount > 0 && (flags & VK_QUEUE_COMPUTE_BIT) &&
+			!(flags & VK_QUEUE_GRAPHICS_BIT)) {
+			indices.computeFamily = family;
+			break;
+		}
+	}
+
 	return indices;
 }
 
@@ -394,21 +609,19 @@ VkFormat Device::FindSupportedFormat(const std::vector<VkFormat>& candidates, Vk
 	MVE_ERROR("Failed to find supported format!");
 }
 
-uint32_t Device::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+VkFormat Device::FindDepthFormat()
 {
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-			return i;
-		}
-	}
+	return FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+							   VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+}
 
-	MVE_ERROR("Failed to find suitable memory type!");
+uint32_t Device::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+	return memoryAllocator->FindMemoryType(typeFilter, properties);
 }
 
 void Device::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-						  VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+						  VkBuffer& buffer, Allocation& allocation, MemoryLifetime lifetime)
 {
 	VkBufferCreateInfo bufferInfo {};
 	bufferInfo.sType	   = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -420,111 +633,17 @@ void Device::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
 		MVE_ERROR("Failed to create vertex buffer!");
 	}
 
-	VkMemoryRequirements memRequirements;
-	vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo {};
-	allocInfo.sType			  = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize  = memRequirements.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-	if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-		MVE_ERROR("Failed to allocate vertex buffer memory!");
-	}
-
-	vkBindBufferMemory(device_, buffer, bufferMemory, 0);
-}
-
-VkCommandBuffer Device::BeginSingleTimeCommands()
-{
-	VkCommandBufferAllocateInfo allocInfo {};
-	allocInfo.sType				 = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.level				 = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool		 = commandPool;
-	allocInfo.commandBufferCount = 1;
-
-	VkCommandBuffer commandBuffer;
-	vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
-
-	VkCommandBufferBeginInfo beginInfo {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-	vkBeginCommandBuffer(commandBuffer, &beginInfo);
-	return commandBuffer;
-}
-
-void Device::EndSingleTimeCommands(VkCommandBuffer commandBuffer)
-{
-	vkEndCommandBuffer(commandBuffer);
-
-	VkSubmitInfo submitInfo {};
-	submitInfo.sType			  = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers	  = &commandBuffer;
-
-	vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(graphicsQueue_);
-
-	vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
-}
-
-void Device::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
-{
-	VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-
-	VkBufferCopy copyRegion {};
-	copyRegion.srcOffset = 0; // Optional
-	copyRegion.dstOffset = 0; // Optional
-	copyRegion.size		 = size;
-	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-	EndSingleTimeCommands(commandBuffer);
-}
-
-void Device::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount)
-{
-	VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-
-	VkBufferImageCopy region {};
-	region.bufferOffset		 = 0;
-	region.bufferRowLength	 = 0;
-	region.bufferImageHeight = 0;
-
-	region.imageSubresource.aspectMask	   = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel	   = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount	   = layerCount;
-
-	region.imageOffset = {0, 0, 0};
-	region.imageExtent = {width, height, 1};
-
-	vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-	EndSingleTimeCommands(commandBuffer);
+	allocation = memoryAllocator->AllocateForBuffer(buffer, properties, lifetime);
 }
 
 void Device::CreateImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image,
-								 VkDeviceMemory& imageMemory)
+								 Allocation& allocation)
 {
 	if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
 		MVE_ERROR("Failed to create image!");
 	}
 
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(device_, image, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo {};
-	allocInfo.sType			  = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize  = memRequirements.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-	if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-		MVE_ERROR("Failed to allocate image memory!");
-	}
-
-	if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
-		MVE_ERROR("Failed to bind image memory!");
-	}
+	allocation = memoryAllocator->AllocateForImage(image, imageInfo, properties);
 }
 
 }; // namespace MVE
\ No newline at end of file
@@ -1,12 +1,21 @@
 #pragma once
 
+#include "MemoryAllocator.h"
+
 #include "core/Window.h"
 
 #include <vulkan/vulkan.h>
 
+#include <mutex>
+
 namespace MVE
 {
 
+class MeshPool;
+class Defragmenter;
+class UploadManager;
+class AsyncCompute;
+
 struct SwapChainSupportDetails
 {
 	VkSurfaceCapabilitiesKHR capabilities;
@@ -18,6 +27,8 @@ struct QueueFamilyIndices
 {
 	uint32_t graphicsFamily;
 	uint32_t presentFamily;
+	uint32_t transferFamily; // A transfer only family when there is one, graphicsFamily otherwise
+	uint32_t computeFamily;	 // A compute family without graphics when there is one, graphicsFamily otherwise
 	bool graphicsFamilyHasValue = false;
 	bool presentFamilyHasValue	= false;
 	bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
@@ -47,25 +58,46 @@ class Device
 	VkSurfaceKHR Surface() { return surface_; }
 	VkQueue GraphicsQueue() { return graphicsQueue_; }
 	VkQueue PresentQueue() { return presentQueue_; }
+	// The graphics queue when the device has no transfer only queue family
+	VkQueue TransferQueue() { return transferQueue_; }
+	// The graphics queue when the device has no compute family without graphics
+	VkQueue ComputeQueue() { return computeQueue_; }
+	// Every submit and present goes through these. Loading threads submit uploads too, and the queues above may be the
+	// same VkQueue, so each queue has a lock.
+	VkResult QueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* submits, VkFence fence);
+	VkResult QueuePresent(const VkPresentInfoKHR& presentInfo);
+	bool IsHeadless() const { return window.IsHeadless(); }
+	// Vertices and indices of every static mesh
+	MeshPool& GetMeshPool() { return *meshPool; }
+	Defragmenter& GetDefragmenter() { return *defragmenter; }
+	UploadManager& GetUploadManager() { return *uploadManager; }
+	AsyncCompute& GetAsyncCompute() { return *asyncCompute; }
+	// Passed to every pipeline creation. Loaded from PIPELINE_CACHE_PATH and saved there again when the device is
+	// destroyed, or earlier with SavePipelineCache.
+	VkPipelineCache GetPipelineCache() const { return pipelineCache; }
+	void SavePipelineCache();
 
 	SwapChainSupportDetails GetSwapChainSupport() { return QuerySwapChainSupport(physicalDevice); }
 	uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 	QueueFamilyIndices FindPhysicalQueueFamilies() { return FindQueueFamilies(physicalDevice); }
 	VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling,
 								 VkFormatFeatureFlags features);
+	VkFormat FindDepthFormat();
 
 	// Buffer Helper Functions
 	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer,
-					  VkDeviceMemory& bufferMemory);
-	VkCommandBuffer BeginSingleTimeCommands();
-	void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
-	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-	void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+					  Allocation& allocation, MemoryLifetime lifetime = MemoryLifetime::Persistent);
 
 	void CreateImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image,
-							 VkDeviceMemory& imageMemory);
+							 Allocation& allocation);
+
+	// Memory of CreateBuffer and CreateImageWithInfo, freed once the resource was destroyed
+	void FreeMemory(Allocation& allocation) { memoryAllocator->Free(allocation); }
+	MemoryAllocator& GetMemoryAllocator() { return *memoryAllocator; }
+	MemoryStats GetMemoryStats() const { return memoryAllocator->GetStats(); }
 
 	VkPhysicalDeviceProperties properties;
+	VkPhysicalDeviceFeatures features {}; // The ones enabled on the logical device
 
   private:
 	void CreateInstance();
@@ -74,6 +106,9 @@ class Device
 	void PickPhysicalDevice();
 	void CreateLogicalDevice();
 	void CreateCommandPool();
+	void CreatePipelineCache();
+	// Empty when there is no cache file or it doesn't belong to this device and driver
+	std::vector<char> LoadPipelineCacheData();
 
 	// helper functions
 	bool IsDeviceSuitable(VkPhysicalDevice device);
@@ -90,14 +125,23 @@ class Device
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 	Window& window;
 	VkCommandPool commandPool;
+	VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 
 	VkDevice device_;
-	VkSurfaceKHR surface_;
+	VkSurfaceKHR surface_ = VK_NULL_HANDLE;
 	VkQueue graphicsQueue_;
 	VkQueue computeQueue_;
 	VkQueue presentQueue_;
+	VkQueue transferQueue_;
+	std::unordered_map<VkQueue, std::unique_ptr<std::mutex>> queueMutexes; // Filled before the first submit
+
+	std::unique_ptr<MemoryAllocator> memoryAllocator;
+	std::unique_ptr<Defragmenter> defragmenter;
+	std::unique_ptr<UploadManager> uploadManager;
+	std::unique_ptr<AsyncCompute> asyncCompute;
+	std::unique_ptr<MeshPool> meshPool;
 
 	const std::vector<const char*> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-	const std::vector<const char*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+	std::vector<const char*> deviceExtensions		= {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 };
 } // namespace MVE
\ No newline at end of file
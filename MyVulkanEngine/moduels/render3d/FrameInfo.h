@@ -1,18 +1,19 @@
 #pragma once
 
-#include <vulkan/Vulkan.h>
+#include <vulkan/vulkan.h>
 
 #include "Camera.h"
 
 namespace MVE
 {
 
-#define MAX_LIGHTS 10
+#define MAX_DIRECTIONAL_LIGHTS 10
 
+// Point lights live in a storage buffer of ClusteredLighting, not in the UBO
 struct PointLight
 {
-	glm::vec4 position {};
-	glm::vec4 color {};
+	glm::vec4 position {}; // w is the range
+	glm::vec4 color {};	   // w is the intensity
 };
 
 struct DirectionalLight
@@ -27,12 +28,19 @@ struct GlobalUbo
 	glm::mat4 projection {1.0f};
 	glm::mat4 inverseView {1.0f};
 	glm::vec4 ambientLightColor {0.6f, 0.6f, 1.0f, 0.02f};
-	PointLight pointLights[MAX_LIGHTS];
-	DirectionalLight directionalLights[MAX_LIGHTS];
-	int numPointLights;
+	DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
+	glm::vec4 clusterScale {}; // Pixels to tiles in xy, log view depth to slice as z * log(depth) + w
+	glm::uvec4 clusterGrid {}; // Tiles in x and y, slices in z and lights per cluster in w
 	int numDirectionalLights;
 };
 
+struct RenderStats
+{
+	uint32_t drawCalls	   = 0;
+	uint64_t triangles	   = 0;
+	uint32_t culledObjects = 0; // Outside the view frustum, not drawn
+};
+
 struct FrameInfo
 {
 	int frameIndex;
@@ -40,5 +48,6 @@ struct FrameInfo
 	VkCommandBuffer commandBuffer;
 	Camera& camera;
 	VkDescriptorSet globalDescriptorSet;
+	RenderStats& stats;
 };
 } // namespace MVE
\ No newline at end of file
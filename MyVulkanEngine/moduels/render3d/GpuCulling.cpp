@@ -0,0 +1,466 @@
+#include "GpuCulling.h"
+
+#include "SwapChain.h"
+
+#include "core/GameObject.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+
+namespace MVE
+{
+
+// Matches Object in cull.comp
+struct GpuObject
+{
+	glm::mat4 modelMatrix {1.0f};
+	glm::mat3x4 normalMatrix {1.0f};
+	glm::vec4 boxMin {}; // Model space
+	glm::vec4 boxMax {};
+	uint32_t batch = UINT32_MAX;
+	uint32_t padding[3] {};
+};
+
+// Matches Batch in cull.comp
+struct GpuBatch
+{
+	uint32_t command	   = 0; // Index of the batch's indirect command
+	uint32_t firstInstance = 0; // Where the shader writes the batch's instances
+};
+
+// Commands are written by Model::WriteIndirectCommand, VkDrawIndirectCommands for models without indices. The shader
+// only touches the instance count, the second field of both.
+static_assert(offsetof(VkDrawIndexedIndirectCommand, instanceCount) == sizeof(uint32_t));
+static_assert(offsetof(VkDrawIndirectCommand, instanceCount) == sizeof(uint32_t));
+
+struct CullPush
+{
+	glm::vec4 planes[6];
+	uint32_t objectCount;
+};
+
+constexpr uint32_t NO_BATCH		  = UINT32_MAX;
+constexpr uint32_t WORKGROUP_SIZE = 64; // local_size_x of cull.comp
+constexpr size_t MIN_CAPACITY	  = 256;
+
+GpuCulling::GpuCulling(Device& device, const MaterialSystem& materialSystem):
+	device(device), materialSystem(materialSystem)
+{
+	descriptorPool = DescriptorPool::Builder(device)
+						 .SetMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
+						 .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT * 4)
+						 .Build();
+
+	setLayout = DescriptorSetLayout::Builder(device)
+					.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+					.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+					.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+					.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+					.Build();
+
+	frames.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+	for (auto& frame : frames) {
+		bool allocated =
+			descriptorPool->AllocateDescriptorSet(setLayout->GetDescriptorSetLayout(), frame.descriptorSet);
+		MVE_ASSERT(allocated, "Failed to allocate the GPU culling descriptor set");
+	}
+
+	CreatePipeline();
+}
+
+GpuCulling::~GpuCulling()
+{
+	pipeline.Wait();
+	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+}
+
+void GpuCulling::CreatePipeline()
+{
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset	 = 0;
+	pushConstantRange.size		 = sizeof(CullPush);
+
+	VkDescriptorSetLayout descriptorSetLayout = setLayout->GetDescriptorSetLayout();
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+	pipelineLayoutInfo.sType				  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount		  = 1;
+	pipelineLayoutInfo.pSetLayouts			  = &descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges	  = &pushConstantRange;
+
+	auto error = vkCreatePipelineLayout(device.VulkanDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
+	MVE_ASSERT(error == VK_SUCCESS, "Failed to create the GPU culling pipeline layout");
+
+	pipeline.Compile([&device = device, layout = pipelineLayout] {
+		return std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "cull.comp.spv", layout);
+	});
+}
+
+VkDeviceSize GpuCulling::IndirectOffset(uint32_t draw) const
+{
+	return draw * sizeof(VkDrawIndexedIndirectCommand);
+}
+
+void GpuCulling::Cull(FrameInfo& frameInfo, Registry& registry)
+{
+	MVE_PROFILE_SCOPE("GpuCulling::Cull");
+	auto& frame		   = frames[frameInfo.frameIndex];
+	auto commandBuffer = frameInfo.commandBuffer;
+
+	ReadBackStats(frame, frameInfo.stats);
+
+	for (size_t i = 0; i < retiredBuffers.size();) {
+		if (--retiredBuffers[i].framesLeft > 0) {
+			i++;
+			continue;
+		}
+		retiredBuffers[i] = std::move(retiredBuffers.back());
+		retiredBuffers.pop_back();
+	}
+
+	Sync(registry);
+	Upload(commandBuffer, frame);
+	WriteBatches(frame);
+
+	Reserve(frame.instanceBuffer, sizeof(InstanceData), liveObjects,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	UpdateDescriptorSet(frame);
+
+	auto cullPipeline = pipeline.TryGet();
+	if (objects.empty() || !cullPipeline)
+		return;
+
+	Frustum frustum = frameInfo.camera.GetFrustum();
+	auto& planes	= frustum.Planes();
+
+	CullPush push {};
+	std::copy(planes.begin(), planes.end(), push.planes);
+	push.objectCount = objects.size();
+
+	cullPipeline->Bind(commandBuffer);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.descriptorSet,
+							0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+	vkCmdDispatch(commandBuffer, (push.objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+	// The draws read the commands and instances, and the stats read the instance counts back a few frames later
+	VkMemoryBarrier barrier {};
+	barrier.sType		  = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask =
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+						 VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+							 VK_PIPELINE_STAGE_HOST_BIT,
+						 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCulling::ReadBackStats(FrameResources& frame, RenderStats& stats)
+{
+	if (frame.indirectBuffer == nullptr)
+		return;
+
+	// The renderer waited for this frame's fence, the counts are from MAX_FRAMES_IN_FLIGHT frames ago
+	auto commands		  = static_cast<const VkDrawIndexedIndirectCommand*>(frame.indirectBuffer->GetMappedMemory());
+	uint32_t visibleCount = 0;
+	for (size_t i = 0; i < frame.drawTriangles.size(); i++) {
+		uint32_t instanceCount = commands[i].instanceCount;
+		visibleCount += instanceCount;
+		stats.triangles += uint64_t(frame.drawTriangles[i]) * instanceCount;
+	}
+	stats.culledObjects += frame.objectCount - visibleCount;
+}
+
+void GpuCulling::Sync(Registry& registry)
+{
+	auto& transforms	= registry.Pool<TransformComponent>();
+	auto& meshRenderers = registry.Pool<MeshRendererComponent>();
+	auto& materials		= registry.Pool<MaterialComponent>();
+	auto& changes		= TransformSystem::GetChanges(registry);
+
+	// Adding or removing one of the components, or destroying an entity, changes the pools' versions
+	std::array<uint32_t, 3> versions {transforms.StructureVersion(), meshRenderers.StructureVersion(),
+									  materials.StructureVersion()};
+	bool missedUpdate = changes.update - transformUpdate > 1;
+	transformUpdate	  = changes.update;
+
+	if (synced && versions == poolVersions && !missedUpdate) {
+		// Only the objects that moved
+		for (Entity entity : changes.entities) {
+			auto meshRenderer = meshRenderers.TryGet(entity);
+			if (meshRenderer == nullptr || meshRenderer->model == nullptr)
+				continue;
+
+			auto material = materials.TryGet(entity);
+			SyncObject(entity, transforms.Get(entity), meshRenderer->model.get(),
+					   materialSystem.Resolve(material ? material->id : NULL_HANDLE));
+		}
+	} else {
+		SyncAll(registry);
+		poolVersions = versions;
+		synced		 = true;
+	}
+
+	if (batchesChanged) {
+		// Neighbours with the same material, page and command type can be drawn with one multi-draw. There is no depth
+		// in the key, the batches aren't drawn front to back.
+		auto drawKey = [&](uint32_t index) {
+			auto& batch = batches[index];
+			return std::make_tuple(batch.material, batch.model->GetMesh().page, batch.model->IsIndexed(), batch.model);
+		};
+		drawOrder.clear();
+		for (uint32_t i = 0; i < batches.size(); i++) {
+			if (batches[i].objectCount > 0)
+				drawOrder.push_back(i);
+		}
+		std::sort(drawOrder.begin(), drawOrder.end(), [&](uint32_t a, uint32_t b) { return drawKey(a) < drawKey(b); });
+		batchesChanged = false;
+	}
+}
+
+void GpuCulling::SyncAll(Registry& registry)
+{
+	frameCounter++;
+
+	size_t syncedCount = 0;
+	auto& materials	   = registry.Pool<MaterialComponent>();
+	registry.View<TransformComponent, MeshRendererComponent>().Each(
+		[&](Entity entity, TransformComponent& transform, MeshRendererComponent& meshRenderer) {
+			if (meshRenderer.model == nullptr)
+				return;
+
+			auto material = materials.TryGet(entity);
+			SyncObject(entity, transform, meshRenderer.model.get(),
+					   materialSystem.Resolve(material ? material->id : NULL_HANDLE));
+			syncedCount++;
+		});
+
+	// Every synced entity has a live object, so extra ones belong to entities that are gone
+	if (liveObjects != syncedCount)
+		Prune();
+}
+
+void GpuCulling::SyncObject(Entity entity, const TransformComponent& transform, Model* model, MaterialId material)
+{
+	uint32_t index = Handle::Index(entity);
+	if (index >= objects.size()) {
+		// Slots in between belong to entities that aren't renderable, they have to be uploaded as free slots
+		size_t first = objects.size();
+		objects.resize(index + 1);
+		for (size_t i = first; i < index; i++) { MarkDirty(i, nullptr); }
+	}
+
+	auto& object	= objects[index];
+	object.lastSeen = frameCounter;
+
+	bool sameBatch = object.entity == entity && object.model == model && object.material == material;
+	if (sameBatch && object.version == transform.Version())
+		return;
+
+	if (!sameBatch) {
+		Release(object);
+		object.entity	= entity;
+		object.model	= model;
+		object.material = material;
+		object.batch	= AcquireBatch(model, material);
+		liveObjects++;
+	}
+	object.version = transform.Version();
+	MarkDirty(index, &transform);
+}
+
+void GpuCulling::Prune()
+{
+	for (uint32_t i = 0; i < objects.size(); i++) {
+		auto& object = objects[i];
+		if (object.batch == NO_BATCH || object.lastSeen == frameCounter)
+			continue;
+
+		Release(object);
+		object.entity = NULL_ENTITY;
+		MarkDirty(i, nullptr);
+	}
+}
+
+void GpuCulling::Release(Object& object)
+{
+	if (object.batch == NO_BATCH)
+		return;
+
+	auto& batch = batches[object.batch];
+	if (--batch.objectCount == 0) {
+		batchIndices.erase(std::make_pair(batch.model, batch.material));
+		freeBatches.push_back(object.batch);
+		batchesChanged = true;
+	}
+	object.batch = NO_BATCH;
+	liveObjects--;
+}
+
+void GpuCulling::MarkDirty(uint32_t index, const TransformComponent* transform)
+{
+	auto& object	 = objects[index];
+	object.transform = transform;
+	if (!object.dirty)
+		dirtyObjects.push_back(index);
+	object.dirty = true;
+}
+
+uint32_t GpuCulling::AcquireBatch(Model* model, MaterialId material)
+{
+	auto [it, inserted] = batchIndices.try_emplace(std::make_pair(model, material), uint32_t(batches.size()));
+	if (inserted) {
+		if (!freeBatches.empty()) {
+			it->second = freeBatches.back();
+			freeBatches.pop_back();
+		} else {
+			batches.emplace_back();
+		}
+		batches[it->second] = {model, material, 0};
+		batchesChanged		= true;
+	}
+
+	batches[it->second].objectCount++;
+	return it->second;
+}
+
+void GpuCulling::Upload(VkCommandBuffer commandBuffer, FrameResources& frame)
+{
+	if (dirtyObjects.empty())
+		return;
+
+	// Earlier frames may still be culling with the object buffer or copying into it
+	VkMemoryBarrier barrier {};
+	barrier.sType		  = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+						 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	if (objectBuffer == nullptr || objectBuffer->GetInstanceCount() < objects.size()) {
+		// Frames in flight still read the old buffer, so it is copied on the GPU and retired instead of rewritten
+		size_t capacity = std::max(objects.size() + objects.size() / 2, MIN_CAPACITY);
+		auto grown		= std::make_unique<Buffer>(device, sizeof(GpuObject), capacity,
+											   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+												   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+											   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (objectBuffer != nullptr) {
+			VkBufferCopy region {0, 0, objectBuffer->GetBufferSize()};
+			vkCmdCopyBuffer(commandBuffer, objectBuffer->GetBuffer(), grown->GetBuffer(), 1, &region);
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+								 &barrier, 0, nullptr, 0, nullptr);
+
+			// One extra frame, the copy above reads it in the frame that's being recorded right now
+			retiredBuffers.push_back({std::move(objectBuffer), SwapChain::MAX_FRAMES_IN_FLIGHT + 1});
+		}
+		objectBuffer = std::move(grown);
+	}
+
+	Reserve(frame.stagingBuffer, sizeof(GpuObject), dirtyObjects.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	auto staged = static_cast<GpuObject*>(frame.stagingBuffer->GetMappedMemory());
+
+	// Sorted so neighbouring slots are copied with one region
+	std::sort(dirtyObjects.begin(), dirtyObjects.end());
+
+	std::vector<VkBufferCopy> regions;
+	for (uint32_t i = 0; i < dirtyObjects.size(); i++) {
+		auto& object = objects[dirtyObjects[i]];
+		GpuObject data {};
+		if (object.transform != nullptr) {
+			auto& box		  = object.model->GetBoundingBox();
+			data.modelMatrix  = object.transform->WorldMatrix();
+			data.normalMatrix = glm::mat3x4(object.transform->NormalMatrix());
+			data.boxMin		  = glm::vec4(box.min, 1.0f);
+			data.boxMax		  = glm::vec4(box.max, 1.0f);
+			data.batch		  = object.batch;
+		}
+		staged[i]		 = data;
+		object.transform = nullptr;
+		object.dirty	 = false;
+
+		VkDeviceSize srcOffset = i * sizeof(GpuObject);
+		VkDeviceSize dstOffset = dirtyObjects[i] * sizeof(GpuObject);
+		if (i > 0 && dirtyObjects[i] == dirtyObjects[i - 1] + 1)
+			regions.back().size += sizeof(GpuObject);
+		else
+			regions.push_back({srcOffset, dstOffset, sizeof(GpuObject)});
+	}
+	dirtyObjects.clear();
+
+	vkCmdCopyBuffer(commandBuffer, frame.stagingBuffer->GetBuffer(), objectBuffer->GetBuffer(), regions.size(),
+					regions.data());
+
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+						 &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCulling::WriteBatches(FrameResources& frame)
+{
+	Reserve(frame.batchBuffer, sizeof(GpuBatch), batches.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	Reserve(frame.indirectBuffer, sizeof(VkDrawIndexedIndirectCommand), drawOrder.size(),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	auto gpuBatches = static_cast<GpuBatch*>(frame.batchBuffer->GetMappedMemory());
+	auto commands	= static_cast<VkDrawIndexedIndirectCommand*>(frame.indirectBuffer->GetMappedMemory());
+
+	// Each batch gets a range of instances as big as its object count, the shader fills it from the front. Empty
+	// batches aren't in the draw order and no object points at them.
+	frame.drawTriangles.resize(drawOrder.size());
+	uint32_t firstInstance = 0;
+	for (uint32_t draw = 0; draw < drawOrder.size(); draw++) {
+		auto& batch					= batches[drawOrder[draw]];
+		gpuBatches[drawOrder[draw]] = {draw, firstInstance};
+
+		commands[draw] = {};
+		batch.model->WriteIndirectCommand(&commands[draw], firstInstance);
+
+		frame.drawTriangles[draw] = batch.model->TriangleCount();
+		firstInstance += batch.objectCount;
+	}
+	frame.objectCount = liveObjects;
+}
+
+void GpuCulling::UpdateDescriptorSet(FrameResources& frame)
+{
+	std::array<VkBuffer, 4> buffers {objectBuffer ? objectBuffer->GetBuffer() : VK_NULL_HANDLE,
+									 frame.batchBuffer->GetBuffer(), frame.instanceBuffer->GetBuffer(),
+									 frame.indirectBuffer->GetBuffer()};
+	if (buffers == frame.boundBuffers || objectBuffer == nullptr)
+		return;
+
+	// The set was last used by this frame's previous submission, which already finished
+	auto objectInfo	  = objectBuffer->DescriptorInfo();
+	auto batchInfo	  = frame.batchBuffer->DescriptorInfo();
+	auto instanceInfo = frame.instanceBuffer->DescriptorInfo();
+	auto indirectInfo = frame.indirectBuffer->DescriptorInfo();
+	DescriptorWriter(*setLayout, *descriptorPool)
+		.WriteBuffer(0, &objectInfo)
+		.WriteBuffer(1, &batchInfo)
+		.WriteBuffer(2, &instanceInfo)
+		.WriteBuffer(3, &indirectInfo)
+		.Overwrite(frame.descriptorSet);
+	frame.boundBuffers = buffers;
+}
+
+void GpuCulling::Reserve(std::unique_ptr<Buffer>& buffer, VkDeviceSize elementSize, size_t count,
+						 VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+{
+	if (buffer != nullptr && buffer->GetInstanceCount() >= count)
+		return;
+
+	// Only the frame's own buffers come through here and their last frame finished, so unlike the shared object buffer
+	// the old one is destroyed right away instead of retired
+	size_t capacity = std::max(count + count / 2, MIN_CAPACITY);
+	buffer			= std::make_unique<Buffer>(device, elementSize, capacity, usage, properties);
+	if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		buffer->Map();
+}
+
+} // namespace MVE
\ No newline at end of file
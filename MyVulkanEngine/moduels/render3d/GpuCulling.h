@@ -0,0 +1,150 @@
+#pragma once
+
+#include "AsyncPipeline.h"
+#include "Buffer.h"
+#include "Descriptors.h"
+#include "FrameInfo.h"
+#include "MaterialSystem.h"
+
+#include "core/Registry.h"
+
+namespace MVE
+{
+
+class TransformComponent;
+
+// Per-instance vertex attributes, read by pbr.vert from locations 6 to 12
+struct InstanceData
+{
+	glm::mat4 modelMatrix {1.0f};
+	glm::mat3x4 normalMatrix {1.0f}; // Columns padded to vec4, attributes are easier to fetch when 16 byte aligned
+};
+
+/// GPU-driven culling for the PBR pass. Every renderable object lives in a device local storage buffer that is only
+/// written when the object changes, and a compute pass tests each one against the frustum, appends the visible ones to
+/// their batch's instances and bumps the batch's indirect instance count. Objects sharing a model and a material form
+/// a batch, so the CPU records one indirect command per batch no matter how many objects there are. The commands are
+/// laid out in draw order, so batches that share a material and a mesh pool page can be drawn with one multi-draw.
+/// Syncing with the registry only visits the entities TransformSystem moved, every renderable is only looked at again
+/// when one may have been added or removed.
+class GpuCulling
+{
+  public:
+	struct Batch
+	{
+		Model* model		 = nullptr;
+		MaterialId material	 = NULL_HANDLE;
+		uint32_t objectCount = 0; // Empty batches are kept for reuse and not drawn
+	};
+
+  public:
+	GpuCulling(Device& device, const MaterialSystem& materialSystem);
+	~GpuCulling();
+
+	GpuCulling(const GpuCulling&)	  = delete;
+	void operator=(const GpuCulling&) = delete;
+
+	// Each batch starts at its own instance, which indirect draws only allow with drawIndirectFirstInstance
+	static bool IsSupported(Device& device) { return device.features.drawIndirectFirstInstance; }
+
+	// Syncs the objects with the registry and records their upload and the culling dispatch. Has to be recorded
+	// outside of a render pass, after TransformSystem::Update. Until the pipeline is compiled nothing is dispatched,
+	// every command keeps an instance count of 0 and nothing is drawn.
+	void Cull(FrameInfo& frameInfo, Registry& registry);
+
+	// The batches that have objects, sorted by material and mesh pool page. Indices into Batches(). A batch has
+	// objects at any distance, so unlike the CPU path's RenderQueue there is no front to back order.
+	const std::vector<uint32_t>& DrawOrder() const { return drawOrder; }
+	const std::vector<Batch>& Batches() const { return batches; }
+	// The indirect command of DrawOrder()[draw], valid for the frame Cull was last called for. The commands have the
+	// stride of VkDrawIndexedIndirectCommand.
+	VkBuffer IndirectBuffer(int frameIndex) const { return frames[frameIndex].indirectBuffer->GetBuffer(); }
+	VkDeviceSize IndirectOffset(uint32_t draw) const;
+	// InstanceData of the visible objects, bound as the instance rate vertex buffer
+	VkBuffer InstanceBuffer(int frameIndex) const { return frames[frameIndex].instanceBuffer->GetBuffer(); }
+
+  private:
+	struct Object
+	{
+		Entity entity		= NULL_ENTITY;
+		uint32_t version	= 0;
+		Model* model		= nullptr;
+		MaterialId material = NULL_HANDLE;
+		uint32_t batch		= UINT32_MAX; // UINT32_MAX for free slots
+		uint32_t lastSeen	= 0;
+
+		// Set while the object waits for its upload, a null transform uploads a free slot
+		const TransformComponent* transform = nullptr;
+		bool dirty							= false;
+	};
+
+	struct FrameResources
+	{
+		std::unique_ptr<Buffer> stagingBuffer;	// Host visible, objects changed this frame
+		std::unique_ptr<Buffer> batchBuffer;	// Host visible, where each batch's command and instances are
+		std::unique_ptr<Buffer> indirectBuffer; // Host visible, the commands in draw order
+		std::unique_ptr<Buffer> instanceBuffer; // Device local, written by the cull shader
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		std::array<VkBuffer, 4> boundBuffers {}; // What descriptorSet points to, rewritten when a buffer was replaced
+
+		// Read back once the frame's fence was waited on, for the stats
+		std::vector<uint32_t> drawTriangles;
+		uint32_t objectCount = 0;
+	};
+
+	struct RetiredBuffer
+	{
+		std::unique_ptr<Buffer> buffer;
+		uint32_t framesLeft;
+	};
+
+	void CreatePipeline();
+	// Reports the visible objects and triangles of the frame that last used these resources
+	void ReadBackStats(FrameResources& frame, RenderStats& stats);
+	// Only visits the entities TransformSystem changed, unless a renderable may have been added or removed
+	void Sync(Registry& registry);
+	void SyncAll(Registry& registry);
+	void SyncObject(Entity entity, const TransformComponent& transform, Model* model, MaterialId material);
+	void Prune();
+	void Release(Object& object);
+	void MarkDirty(uint32_t index, const TransformComponent* transform);
+	uint32_t AcquireBatch(Model* model, MaterialId material);
+	// Copies the changed objects into the object buffer, growing it first if needed
+	void Upload(VkCommandBuffer commandBuffer, FrameResources& frame);
+	void WriteBatches(FrameResources& frame);
+	void UpdateDescriptorSet(FrameResources& frame);
+	// Replaces a per frame buffer with a bigger one when it can't hold count elements. Host visible buffers are mapped.
+	void Reserve(std::unique_ptr<Buffer>& buffer, VkDeviceSize elementSize, size_t count, VkBufferUsageFlags usage,
+				 VkMemoryPropertyFlags properties);
+
+  private:
+	Device& device;
+	const MaterialSystem& materialSystem;
+
+	std::unique_ptr<DescriptorPool> descriptorPool;
+	std::unique_ptr<DescriptorSetLayout> setLayout;
+	VkPipelineLayout pipelineLayout;
+	AsyncPipeline<ComputePipeline> pipeline;
+
+	std::vector<Object> objects; // Indexed by the entity's slot index
+	std::vector<uint32_t> dirtyObjects;
+	std::unique_ptr<Buffer> objectBuffer; // Device local, shared by all frames
+	size_t liveObjects	  = 0;
+	uint32_t frameCounter = 0; // Counts the calls of SyncAll
+
+	// What the last Sync saw
+	bool synced				 = false;
+	uint32_t transformUpdate = 0;
+	std::array<uint32_t, 3> poolVersions {}; // Of the transform, mesh renderer and material pools
+
+	std::vector<Batch> batches;
+	std::map<std::pair<Model*, MaterialId>, uint32_t> batchIndices;
+	std::vector<uint32_t> freeBatches;
+	std::vector<uint32_t> drawOrder;
+	bool batchesChanged = false;
+
+	std::vector<FrameResources> frames;
+	std::vector<RetiredBuffer> retiredBuffers;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+
+namespace MVE
+{
+
+constexpr uint32_t QUERY_COUNT = GpuProfiler::MAX_SCOPES * 2;
+
+GpuProfiler::GpuProfiler(Device& device): device(device)
+{
+	supported		= device.properties.limits.timestampComputeAndGraphics;
+	timestampPeriod = device.properties.limits.timestampPeriod;
+	if (!supported) {
+		MVE_WARN("Device doesn't support timestamp queries, GPU profiling is disabled");
+		return;
+	}
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device.PhysicalDevice(), &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device.PhysicalDevice(), &familyCount, families.data());
+
+	uint32_t validBits = families[device.FindPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+	if (validBits == 0) {
+		supported = false;
+		MVE_WARN("Graphics queue doesn't support timestamps, GPU profiling is disabled");
+		return;
+	}
+	timestampMask = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+
+	VkQueryPoolCreateInfo createInfo {};
+	createInfo.sType	  = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+	createInfo.queryCount = QUERY_COUNT;
+
+	for (auto& set : frames) {
+		auto code = vkCreateQueryPool(device.VulkanDevice(), &createInfo, nullptr, &set.pool);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to create timestamp query pool");
+	}
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	for (auto& set : frames) { vkDestroyQueryPool(device.VulkanDevice(), set.pool, nullptr); }
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, int frameIndex)
+{
+	if (!supported)
+		return;
+
+	auto& set = frames[frameIndex];
+
+	// The renderer already waited for this slot's fence, so its queries from MAX_FRAMES_IN_FLIGHT frames ago are done
+	if (set.pending)
+		Resolve(set, lastResults);
+
+	Reset(set, commandBuffer);
+	set.frameNumber = frameCounter++;
+	current			= &set;
+
+	BeginScope(commandBuffer, "GPU Frame");
+}
+
+void GpuProfiler::EndFrame(VkCommandBuffer commandBuffer)
+{
+	if (!supported || current == nullptr)
+		return;
+
+	EndScope(commandBuffer, 0);
+
+	// GPU work can't start before the frame is submitted, so that's the closest CPU time to line the GPU track up with
+	current->cpuAnchor = Profiler::Now();
+	current->pending   = true;
+	current			   = nullptr;
+}
+
+std::vector<GpuFrameResults> GpuProfiler::ResolvePending()
+{
+	std::vector<QuerySet*> pending;
+	for (auto& set : frames) {
+		if (set.pending)
+			pending.push_back(&set);
+	}
+	std::sort(pending.begin(), pending.end(), [](auto a, auto b) { return a->frameNumber < b->frameNumber; });
+
+	std::vector<GpuFrameResults> results;
+	for (auto set : pending) {
+		if (Resolve(*set, lastResults))
+			results.push_back(lastResults);
+	}
+	return results;
+}
+
+uint32_t GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const char* name)
+{
+	if (!supported || current == nullptr)
+		return MAX_SCOPES;
+
+	uint32_t scope = current->names.size();
+	if (scope == MAX_SCOPES) {
+		static bool warned = false;
+		if (!warned)
+			MVE_WARN("GPU profiler ran out of scopes, only the first {} are recorded", MAX_SCOPES);
+		warned = true;
+		return MAX_SCOPES;
+	}
+
+	current->names.push_back(name);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, current->pool, scope * 2);
+	return scope;
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+	if (!supported || current == nullptr || scope >= MAX_SCOPES)
+		return;
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, current->pool, scope * 2 + 1);
+}
+
+void GpuProfiler::Reset(QuerySet& set, VkCommandBuffer commandBuffer)
+{
+	vkCmdResetQueryPool(commandBuffer, set.pool, 0, QUERY_COUNT);
+	set.names.clear();
+	set.pending = false;
+}
+
+bool GpuProfiler::Resolve(QuerySet& set, GpuFrameResults& results)
+{
+	set.pending = false;
+	if (set.names.empty())
+		return false;
+
+	uint32_t queryCount = set.names.size() * 2;
+	// Every query's value is followed by its availability, a scope that was begun but never ended leaves its end
+	// query unavailable without failing the others
+	std::array<uint64_t, QUERY_COUNT * 2> queryResults;
+
+	VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+
+	auto code = vkGetQueryPoolResults(device.VulkanDevice(), set.pool, 0, queryCount, sizeof(queryResults),
+									  queryResults.data(), sizeof(uint64_t) * 2, flags);
+	if (code != VK_SUCCESS && code != VK_NOT_READY)
+		return false;
+
+	auto available		= [&](uint32_t query) { return queryResults[query * 2 + 1] != 0; };
+	auto timestampOf	= [&](uint32_t query) { return queryResults[query * 2] & timestampMask; };
+	auto toMilliseconds = [&](uint64_t ticks) { return float(ticks * timestampPeriod / 1e6); };
+
+	// Frames are anchored by their first timestamp
+	if (!available(0))
+		return false;
+	uint64_t anchorTimestamp = timestampOf(0);
+
+	auto toCpuTime = [&](uint64_t timestamp) {
+		return set.cpuAnchor + int64_t((int64_t(timestamp) - int64_t(anchorTimestamp)) * timestampPeriod);
+	};
+
+	results.frameNumber = set.frameNumber;
+	results.scopes.clear();
+	for (uint32_t i = 0; i < set.names.size(); i++) {
+		// Not written by the GPU, reported as 0 ms and left out of the trace
+		if (!available(i * 2) || !available(i * 2 + 1)) {
+			results.scopes.push_back({set.names[i], 0.0f});
+			continue;
+		}
+		uint64_t begin = timestampOf(i * 2);
+		uint64_t end   = timestampOf(i * 2 + 1);
+		// Masking the difference keeps it correct when the counter wrapped around between the two timestamps
+		end = begin + ((end - begin) & timestampMask);
+		results.scopes.push_back({set.names[i], toMilliseconds(end - begin)});
+
+		if (Profiler::IsRecording())
+			Profiler::RecordGpuEvent(set.names[i], toCpuTime(begin), toCpuTime(end));
+	}
+	results.frameMilliseconds = results.scopes[0].milliseconds;
+
+	return true;
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Device.h"
+#include "RenderTarget.h"
+
+#include <vulkan/vulkan.h>
+
+namespace MVE
+{
+
+struct GpuScopeResult
+{
+	const char* name;
+	float milliseconds;
+};
+
+struct GpuFrameResults
+{
+	uint64_t frameNumber	= 0;
+	float frameMilliseconds = 0.0f;
+	std::vector<GpuScopeResult> scopes;
+};
+
+/// Measures GPU time with timestamp queries. Every frame in flight has its own query pool, and a pool is only read
+/// back once its frame slot comes around again, after the renderer already waited on that slot's fence, so reading
+/// results never stalls.
+class GpuProfiler
+{
+  public:
+	static constexpr uint32_t MAX_SCOPES = 64;
+
+	GpuProfiler(Device& device);
+	~GpuProfiler();
+
+	GpuProfiler(const GpuProfiler&)	   = delete;
+	void operator=(const GpuProfiler&) = delete;
+
+	// Called by the renderer at the start and end of recording a frame's command buffer
+	void BeginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+	void EndFrame(VkCommandBuffer commandBuffer);
+
+	uint32_t BeginScope(VkCommandBuffer commandBuffer, const char* name);
+	void EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+	// Timings of the most recently completed frame, MAX_FRAMES_IN_FLIGHT frames behind the one being recorded
+	const GpuFrameResults& GetFrameResults() const { return lastResults; }
+	// Resolves the frames still in flight, oldest first. Only once the device is idle, their queries must be done.
+	std::vector<GpuFrameResults> ResolvePending();
+	bool IsSupported() const { return supported; }
+
+  private:
+	struct QuerySet
+	{
+		VkQueryPool pool = VK_NULL_HANDLE;
+		std::vector<const char*> names;
+		uint64_t frameNumber = 0;
+		uint64_t cpuAnchor	 = 0;
+		bool pending		 = false;
+	};
+
+	void Reset(QuerySet& set, VkCommandBuffer commandBuffer);
+	bool Resolve(QuerySet& set, GpuFrameResults& results);
+
+  private:
+	Device& device;
+	bool supported;
+	float timestampPeriod;
+	uint64_t timestampMask; // Only the graphics family's timestampValidBits low bits of a timestamp are meaningful
+
+	std::array<QuerySet, RenderTarget::MAX_FRAMES_IN_FLIGHT> frames;
+	QuerySet* current = nullptr;
+
+	uint64_t frameCounter = 0;
+	GpuFrameResults lastResults;
+};
+
+class GpuProfileScope
+{
+  public:
+	GpuProfileScope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name):
+		profiler(profiler), commandBuffer(commandBuffer)
+	{
+		if (profiler)
+			scope = profiler->BeginScope(commandBuffer, name);
+	}
+	~GpuProfileScope()
+	{
+		if (profiler)
+			profiler->EndScope(commandBuffer, scope);
+	}
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	void operator=(const GpuProfileScope&)	= delete;
+
+  private:
+	GpuProfiler* profiler;
+	VkCommandBuffer commandBuffer;
+	uint32_t scope;
+};
+
+} // namespace MVE
+
+// clang-format off
+#ifdef MVE_ENABLE_PROFILING
+	#define MVE_GPU_PROFILE_SCOPE(profiler, commandBuffer, name) \
+		::MVE::GpuProfileScope MVE_PROFILE_CONCAT(gpuProfileScope, __LINE__)(profiler, commandBuffer, name)
+#else
+	#define MVE_GPU_PROFILE_SCOPE(profiler, commandBuffer, name)
+#endif
+// clang-format on
\ No newline at end of file
@@ -2,19 +2,14 @@
 #include "FrameInfo.h"
 #include "SwapChain.h"
 
-constexpr int MAX_MATERIAL_COUNT = 100;
+// A new descriptor pool is added whenever the current one is full
+constexpr int MATERIALS_PER_POOL = 100;
 
 namespace MVE
 {
 MaterialSystem::MaterialSystem(Device& device): device(device)
 {
-	descriptorPool =
-		DescriptorPool::Builder(device)
-			.SetMaxSets(MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT)
-			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT)
-			.AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-						 MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT * 3)
-			.Build();
+	descriptorPools.push_back(CreateDescriptorPool());
 
 	setLayout = DescriptorSetLayout::Builder(device)
 					.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
@@ -23,14 +18,19 @@ MaterialSystem::MaterialSystem(Device& device): device(device)
 					.AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 					.Build();
 
-	defaultTextureAlbedo = Texture::Builder(device).addLayer(SolidTextureSource(glm::vec4 {1.0f})).build();
+	defaultTextureAlbedo = Texture::Builder(device)
+							   .addLayer(SolidTextureSource(glm::vec4 {1.0f}))
+							   .relocatable(true)
+							   .build();
 	defaultTextureArm	 = Texture::Builder(device)
 							.addLayer(SolidTextureSource(glm::vec4 {1.0f}))
 							.format(VK_FORMAT_R8G8B8A8_UNORM)
+							.relocatable(true)
 							.build();
 	defaultTextureNormal = Texture::Builder(device)
 							   .addLayer(SolidTextureSource(glm::vec4 {0.5f, 0.5f, 1.0f, 0.0f}))
 							   .format(VK_FORMAT_R8G8B8A8_UNORM)
+							   .relocatable(true)
 							   .build();
 
 	// Default material
@@ -39,70 +39,125 @@ MaterialSystem::MaterialSystem(Device& device): device(device)
 
 MaterialId MaterialSystem::CreateMaterial()
 {
-	static MaterialId nextId = 0;
-
-	MaterialId id = nextId++;
 	Material mat {};
+	if (!freeMaterials.empty()) {
+		mat = std::move(freeMaterials.back());
+		freeMaterials.pop_back();
+		mat.params = {};
+	} else {
+		mat.buffer.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		mat.descriptorSet.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		mat.writtenGenerations.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+			mat.buffer[i] = std::make_unique<Buffer>(device, sizeof(Params), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+													 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+													 device.properties.limits.minUniformBufferOffsetAlignment);
+			mat.buffer[i]->Map();
+		}
+	}
 	mat.textures.albedo = defaultTextureAlbedo;
 	mat.textures.arm	= defaultTextureArm;
 	mat.textures.normal = defaultTextureNormal;
-	materials.insert({id, std::move(mat)});
 
-	materials[id].buffer.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-	materials[id].descriptorSet.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-	for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
-		materials[id].buffer[i] = std::make_unique<Buffer>(
-			device, sizeof(Params), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-			device.properties.limits.minUniformBufferOffsetAlignment);
+	for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) { WriteDescriptorSet(mat, i); }
 
-		materials[id].buffer[i]->Map();
-
-		auto bufferInfo		 = materials[id].buffer[i]->DescriptorInfo();
-		auto albedoImageInfo = materials[id].textures.albedo->ImageInfo();
-		auto armImageInfo	 = materials[id].textures.arm->ImageInfo();
-		auto normalImageInfo = materials[id].textures.normal->ImageInfo();
+	return materials.Emplace(std::move(mat));
+}
 
-		DescriptorWriter(*setLayout, *descriptorPool)
-			.WriteBuffer(0, &bufferInfo)
-			.WriteImage(1, &albedoImageInfo)
-			.WriteImage(2, &armImageInfo)
-			.WriteImage(3, &normalImageInfo)
-			.Build(materials[id].descriptorSet[i]);
-	}
+void MaterialSystem::DestroyMaterial(MaterialId id)
+{
+	if (id == defaultMaterialId || !materials.Contains(id))
+		return;
 
-	return id;
+	// One extra frame, the material may have been bound in the frame that's being recorded right now
+	retiredMaterials.push_back({std::move(materials.Get(id)), SwapChain::MAX_FRAMES_IN_FLIGHT + 1});
+	materials.Remove(id);
 }
 
 void MaterialSystem::FlushMaterial(MaterialId id, int frameIndex)
 {
-	auto& mat = materials[id];
-	mat.buffer[frameIndex]->WriteToBuffer(&mat.params);
-
-	auto bufferInfo		 = materials[id].buffer[frameIndex]->DescriptorInfo();
-	auto albedoImageInfo = materials[id].textures.albedo->ImageInfo();
-	auto armImageInfo	 = materials[id].textures.arm->ImageInfo();
-	auto normalImageInfo = materials[id].textures.normal->ImageInfo();
-
-	DescriptorWriter(*setLayout, *descriptorPool)
-		.WriteBuffer(0, &bufferInfo)
-		.WriteImage(1, &albedoImageInfo)
-		.WriteImage(2, &armImageInfo)
-		.WriteImage(3, &normalImageInfo)
-		.Overwrite(materials[id].descriptorSet[frameIndex]);
-
-	mat.buffer[frameIndex]->Flush();
+	Flush(materials.Get(id), frameIndex);
 }
 
 void MaterialSystem::FlushAll(int frameIndex)
 {
-	for (auto& [id, mat] : materials) { FlushMaterial(id, frameIndex); }
+	MVE_PROFILE_SCOPE("MaterialSystem::FlushAll");
+	for (auto& mat : materials.Values()) { Flush(mat, frameIndex); }
+
+	for (size_t i = 0; i < retiredMaterials.size();) {
+		if (--retiredMaterials[i].framesLeft > 0) {
+			i++;
+			continue;
+		}
+		retiredMaterials[i].material.textures = {};
+		freeMaterials.push_back(std::move(retiredMaterials[i].material));
+		retiredMaterials[i] = std::move(retiredMaterials.back());
+		retiredMaterials.pop_back();
+	}
 }
 
 void MaterialSystem::Bind(MaterialId id, VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, int set,
 						  int frameIndex) const
 {
+	auto mat = materials.TryGet(id);
+	if (mat == nullptr)
+		mat = &materials.Get(defaultMaterialId);
+
 	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, 1,
-							&(materials.at(id).descriptorSet[frameIndex]), 0, nullptr);
+							&mat->descriptorSet[frameIndex], 0, nullptr);
+}
+
+void MaterialSystem::Flush(Material& mat, int frameIndex)
+{
+	mat.buffer[frameIndex]->WriteToBuffer(&mat.params);
+	// Only when the Defragmenter moved one of the textures or another texture was assigned since the set was written
+	if (TextureGenerations(mat) != mat.writtenGenerations[frameIndex])
+		WriteDescriptorSet(mat, frameIndex);
+	mat.buffer[frameIndex]->Flush();
+}
+
+std::array<uint64_t, 3> MaterialSystem::TextureGenerations(const Material& mat)
+{
+	return {mat.textures.albedo->Generation(), mat.textures.arm->Generation(), mat.textures.normal->Generation()};
+}
+
+std::unique_ptr<DescriptorPool> MaterialSystem::CreateDescriptorPool()
+{
+	return DescriptorPool::Builder(device)
+		.SetMaxSets(MATERIALS_PER_POOL * SwapChain::MAX_FRAMES_IN_FLIGHT)
+		.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MATERIALS_PER_POOL * SwapChain::MAX_FRAMES_IN_FLIGHT)
+		.AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MATERIALS_PER_POOL * SwapChain::MAX_FRAMES_IN_FLIGHT * 3)
+		.Build();
+}
+
+void MaterialSystem::WriteDescriptorSet(Material& mat, int frameIndex)
+{
+	auto bufferInfo		 = mat.buffer[frameIndex]->DescriptorInfo();
+	auto albedoImageInfo = mat.textures.albedo->ImageInfo();
+	auto armImageInfo	 = mat.textures.arm->ImageInfo();
+	auto normalImageInfo = mat.textures.normal->ImageInfo();
+
+	auto writer = [&](DescriptorPool& pool) {
+		return DescriptorWriter(*setLayout, pool)
+			.WriteBuffer(0, &bufferInfo)
+			.WriteImage(1, &albedoImageInfo)
+			.WriteImage(2, &armImageInfo)
+			.WriteImage(3, &normalImageInfo);
+	};
+
+	mat.writtenGenerations[frameIndex] = TextureGenerations(mat);
+
+	auto& set = mat.descriptorSet[frameIndex];
+	if (set != VK_NULL_HANDLE) {
+		writer(*descriptorPools.back()).Overwrite(set);
+		return;
+	}
+
+	if (!writer(*descriptorPools.back()).Build(set)) {
+		descriptorPools.push_back(CreateDescriptorPool());
+		bool success = writer(*descriptorPools.back()).Build(set);
+		MVE_ASSERT(success, "Failed to allocate material descriptor set");
+	}
 }
 
-} // namespace MVE
+} // namespace MVE
\ No newline at end of file
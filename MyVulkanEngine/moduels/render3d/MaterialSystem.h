@@ -4,8 +4,11 @@
 #include "Descriptors.h"
 #include "Texture.h"
 
+#include "core/SlotMap.h"
+
 namespace MVE
 {
+// Generational handle, a destroyed material's id never validates again
 using MaterialId = uint32_t;
 
 class MaterialSystem
@@ -32,34 +35,61 @@ class MaterialSystem
 		Textures textures {};
 		std::vector<VkDescriptorSet> descriptorSet {};
 		std::vector<std::unique_ptr<Buffer>> buffer {};
+		// Generations of the textures each frame's set was written with, the set is rewritten once they differ
+		std::vector<std::array<uint64_t, 3>> writtenGenerations {};
 	};
-	using MaterialsMap = std::unordered_map<MaterialId, Material>;
 
   public:
 	MaterialSystem(Device& device);
 	~MaterialSystem() {}
 
 	MaterialId CreateMaterial();
+	// Frames in flight may still use the material, so its buffers and descriptor sets are only recycled a few frames
+	// later. The default material can't be destroyed.
+	void DestroyMaterial(MaterialId id);
+	bool IsValid(MaterialId id) const { return materials.Contains(id); }
 
-	Material& Get(MaterialId id) { return materials.at(id); }
+	// Changed params and textures are picked up by the next flush
+	Material& Get(MaterialId id) { return materials.Get(id); }
 	void FlushMaterial(MaterialId id, int frameIndex);
+	// Called once per frame, also recycles destroyed materials that are no longer in use
 	void FlushAll(int frameIndex);
+	// Invalid ids bind the default material
 	void Bind(MaterialId id, VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, int set,
 			  int frameIndex) const;
 
 	DescriptorSetLayout* GetLayout() { return setLayout.get(); }
+	size_t MaterialCount() const { return materials.Size(); }
+	MaterialId DefaultMaterial() const { return defaultMaterialId; }
+	// The material Bind uses for id. Draws are keyed by it, so objects without a MaterialComponent batch with the ones
+	// that use the default material.
+	MaterialId Resolve(MaterialId id) const { return materials.Contains(id) ? id : defaultMaterialId; }
+
+  private:
+	struct RetiredMaterial
+	{
+		Material material;
+		uint32_t framesLeft;
+	};
+
+	std::unique_ptr<DescriptorPool> CreateDescriptorPool();
+	void Flush(Material& mat, int frameIndex);
+	static std::array<uint64_t, 3> TextureGenerations(const Material& mat);
+	void WriteDescriptorSet(Material& mat, int frameIndex);
 
   private:
 	Device& device;
-	MaterialsMap materials;
+	SlotMap<Material> materials;
+	std::vector<RetiredMaterial> retiredMaterials;
+	std::vector<Material> freeMaterials; // Retired long enough ago, their buffers and sets can be reused
 
-	std::unique_ptr<DescriptorPool> descriptorPool;
+	std::vector<std::unique_ptr<DescriptorPool>> descriptorPools;
 	std::unique_ptr<DescriptorSetLayout> setLayout;
 
 	std::shared_ptr<Texture> defaultTextureAlbedo;
 	std::shared_ptr<Texture> defaultTextureArm;
 	std::shared_ptr<Texture> defaultTextureNormal;
 
-	MaterialId defaultMaterialId = 0;
+	MaterialId defaultMaterialId = NULL_HANDLE;
 };
 } // namespace MVE
\ No newline at end of file
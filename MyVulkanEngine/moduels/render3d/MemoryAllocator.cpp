@@ -0,0 +1,401 @@
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+
+namespace MVE
+{
+
+constexpr VkDeviceSize BLOCK_SIZE			= VkDeviceSize(64) << 20; // Smaller on heaps below 512 MB
+constexpr VkDeviceSize DEDICATED_IMAGE_SIZE = VkDeviceSize(16) << 20; // Images from this size on get their own memory
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice): device(device)
+{
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+
+	pools.resize(memoryProperties.memoryTypeCount * 2);
+	heapStats.resize(memoryProperties.memoryHeapCount);
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+		heapStats[i].heapSize = memoryProperties.memoryHeaps[i].size;
+	}
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	if (stats.resourceCount > 0)
+		MVE_WARN("MemoryAllocator: {} allocations of {} bytes were never freed", stats.resourceCount, stats.usedBytes);
+
+	for (uint32_t i = 0; i < pools.size(); i++) {
+		uint32_t memoryType = i / 2;
+		for (auto& block : pools[i].blocks) {
+			if (block)
+				FreeMemory(memoryType, block->memory, block->size);
+		}
+		if (pools[i].linear.memory)
+			FreeMemory(memoryType, pools[i].linear.memory, pools[i].linear.size);
+	}
+}
+
+Allocation MemoryAllocator::AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties,
+											  MemoryLifetime lifetime)
+{
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(device, buffer, &requirements);
+
+	Allocation allocation = Allocate(requirements, properties, false, lifetime, false);
+	auto error			  = vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+	MVE_ASSERT(error == VK_SUCCESS, "Failed to bind buffer memory");
+	return allocation;
+}
+
+Allocation MemoryAllocator::AllocateForImage(VkImage image, const VkImageCreateInfo& imageInfo,
+											 VkMemoryPropertyFlags properties)
+{
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device, image, &requirements);
+
+	bool optimal		  = imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL;
+	bool large			  = requirements.size >= DEDICATED_IMAGE_SIZE;
+	Allocation allocation = Allocate(requirements, properties, optimal, MemoryLifetime::Persistent, large);
+	auto error			  = vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+	MVE_ASSERT(error == VK_SUCCESS, "Failed to bind image memory");
+	return allocation;
+}
+
+Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+									 bool optimalImage, MemoryLifetime lifetime, bool preferDedicated)
+{
+	std::lock_guard lock(mutex);
+
+	uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+	auto typeFlags		= memoryProperties.memoryTypes[memoryType].propertyFlags;
+
+	// Flushes and invalidates work on whole atoms, so non coherent allocations must not share one
+	VkDeviceSize size	   = requirements.size;
+	VkDeviceSize alignment = requirements.alignment;
+	if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+		alignment = std::max(alignment, nonCoherentAtomSize);
+		size	  = AlignUp(size, nonCoherentAtomSize);
+	}
+
+	Allocation allocation {};
+	allocation.pool = PoolIndex(memoryType, optimalImage);
+	allocation.size = size;
+
+	bool allocated = false;
+	if (!preferDedicated && size <= BlockSize(memoryType) / 2) {
+		if (lifetime == MemoryLifetime::Transient)
+			allocated = AllocateLinear(allocation.pool, size, alignment, allocation);
+		if (!allocated)
+			allocated = AllocateFromBlocks(allocation.pool, size, alignment, allocation);
+	}
+	if (!allocated) {
+		allocation.kind	  = Allocation::Kind::Dedicated;
+		allocation.memory = AllocateMemory(memoryType, size, &allocation.mapped);
+		MVE_ASSERT(allocation.memory != VK_NULL_HANDLE, "Out of device memory, failed to allocate {} bytes", size);
+	}
+
+	AddResource(memoryType, size);
+	return allocation;
+}
+
+Allocation MemoryAllocator::RelocateBuffer(VkBuffer buffer, const Allocation& current)
+{
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(device, buffer, &requirements);
+
+	Allocation allocation = Relocate(requirements, current);
+	if (allocation.kind != Allocation::Kind::None) {
+		auto error = vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+		MVE_ASSERT(error == VK_SUCCESS, "Failed to bind buffer memory");
+	}
+	return allocation;
+}
+
+Allocation MemoryAllocator::RelocateImage(VkImage image, const Allocation& current)
+{
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device, image, &requirements);
+
+	Allocation allocation = Relocate(requirements, current);
+	if (allocation.kind != Allocation::Kind::None) {
+		auto error = vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+		MVE_ASSERT(error == VK_SUCCESS, "Failed to bind image memory");
+	}
+	return allocation;
+}
+
+Allocation MemoryAllocator::Relocate(const VkMemoryRequirements& requirements, const Allocation& current)
+{
+	std::lock_guard lock(mutex);
+	MVE_ASSERT(current.kind == Allocation::Kind::Block, "Only allocations from blocks can be relocated");
+
+	// The new resource was created like the old one, so it fits the same memory type
+	uint32_t memoryType = current.pool / 2;
+	MVE_ASSERT(requirements.memoryTypeBits & (1u << memoryType), "Relocated resource can't use memory type {}",
+			   memoryType);
+
+	Allocation allocation {};
+	allocation.pool = current.pool;
+	allocation.size = requirements.size;
+	if (!AllocateFromBlocks(current.pool, requirements.size, requirements.alignment, allocation, current.block))
+		return {};
+
+	AddResource(memoryType, requirements.size);
+	return allocation;
+}
+
+bool MemoryAllocator::CanEmptyBlock(uint32_t poolIndex, uint32_t blockIndex, VkDeviceSize movableBytes) const
+{
+	std::lock_guard lock(mutex);
+
+	// Moving host visible memory would leave the mapped pointers of its buffers dangling
+	uint32_t memoryType = poolIndex / 2;
+	if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		return false;
+
+	auto& blocks = pools[poolIndex].blocks;
+	if (blockIndex >= blocks.size() || !blocks[blockIndex] || blocks[blockIndex]->allocator.UsedSize() != movableBytes)
+		return false;
+
+	VkDeviceSize freeElsewhere = 0;
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		if (i != blockIndex && blocks[i])
+			freeElsewhere += blocks[i]->allocator.FreeSize();
+	}
+	// Some slack, the free space is split into ranges and alignment wastes a bit of it
+	return freeElsewhere >= movableBytes + movableBytes / 4;
+}
+
+bool MemoryAllocator::AllocateFromBlocks(uint32_t poolIndex, VkDeviceSize size, VkDeviceSize alignment,
+										 Allocation& allocation, uint32_t skipBlock)
+{
+	auto& blocks = pools[poolIndex].blocks;
+
+	auto tryBlock = [&](uint32_t index) {
+		auto& block = *blocks[index];
+		if (block.allocator.FreeSize() < size)
+			return false;
+
+		auto range = block.allocator.Allocate(size, alignment);
+		if (range.offset == TlsfAllocator::INVALID_OFFSET)
+			return false;
+
+		block.allocationCount++;
+		allocation.kind	  = Allocation::Kind::Block;
+		allocation.memory = block.memory;
+		allocation.offset = range.offset;
+		allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + range.offset : nullptr;
+		allocation.block  = index;
+		allocation.node	  = range.node;
+		return true;
+	};
+
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		if (i != skipBlock && blocks[i] && tryBlock(i))
+			return true;
+	}
+	if (skipBlock != NO_BLOCK)
+		return false;
+
+	// Every block is full, the new one goes into the first free slot
+	uint32_t memoryType = poolIndex / 2;
+	auto block			= std::make_unique<Block>();
+	block->size			= BlockSize(memoryType);
+	block->memory		= AllocateMemory(memoryType, block->size, &block->mapped);
+	if (block->memory == VK_NULL_HANDLE)
+		return false;
+	block->allocator = TlsfAllocator(block->size);
+
+	auto slot = std::find(blocks.begin(), blocks.end(), nullptr);
+	if (slot == blocks.end())
+		slot = blocks.insert(blocks.end(), nullptr);
+	*slot = std::move(block);
+	return tryBlock(slot - blocks.begin());
+}
+
+bool MemoryAllocator::AllocateLinear(uint32_t poolIndex, VkDeviceSize size, VkDeviceSize alignment,
+									 Allocation& allocation)
+{
+	auto& linear = pools[poolIndex].linear;
+	if (linear.memory == VK_NULL_HANDLE) {
+		linear.size	  = BlockSize(poolIndex / 2);
+		linear.memory = AllocateMemory(poolIndex / 2, linear.size, &linear.mapped);
+		if (linear.memory == VK_NULL_HANDLE)
+			return false;
+	}
+
+	// Full until everything in it was freed, the persistent blocks take over meanwhile
+	VkDeviceSize offset = AlignUp(linear.top, alignment);
+	if (offset + size > linear.size)
+		return false;
+
+	linear.top = offset + size;
+	linear.allocationCount++;
+	allocation.kind	  = Allocation::Kind::Linear;
+	allocation.memory = linear.memory;
+	allocation.offset = offset;
+	allocation.mapped = linear.mapped ? static_cast<char*>(linear.mapped) + offset : nullptr;
+	return true;
+}
+
+void MemoryAllocator::Free(Allocation& allocation)
+{
+	if (allocation.kind == Allocation::Kind::None)
+		return;
+
+	std::lock_guard lock(mutex);
+	uint32_t memoryType = allocation.pool / 2;
+	auto& pool			= pools[allocation.pool];
+
+	switch (allocation.kind) {
+	case Allocation::Kind::Block: {
+		auto& block = pool.blocks[allocation.block];
+		block->allocator.Free(allocation.node);
+		block->allocationCount--;
+
+		// Empty blocks are given back, except the last one of the pool so allocating and freeing doesn't thrash
+		bool otherBlocks = std::any_of(pool.blocks.begin(), pool.blocks.end(),
+									   [&](auto& other) { return other && other != block; });
+		if (block->allocationCount == 0 && otherBlocks) {
+			FreeMemory(memoryType, block->memory, block->size);
+			block.reset();
+		}
+		break;
+	}
+	case Allocation::Kind::Linear:
+		if (--pool.linear.allocationCount == 0)
+			pool.linear.top = 0;
+		break;
+	case Allocation::Kind::Dedicated:
+		FreeMemory(memoryType, allocation.memory, allocation.size);
+		break;
+	default:
+		break;
+	}
+
+	auto& heap = heapStats[HeapIndex(memoryType)];
+	heap.usedBytes -= allocation.size;
+	heap.resourceCount--;
+	stats.usedBytes -= allocation.size;
+	stats.resourceCount--;
+	allocation = {};
+}
+
+VkMappedMemoryRange MemoryAllocator::MappedRange(const Allocation& allocation, VkDeviceSize offset,
+												 VkDeviceSize size) const
+{
+	VkDeviceSize begin = allocation.offset + offset;
+	VkDeviceSize end   = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+	VkMappedMemoryRange range {};
+	range.sType	 = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = allocation.memory;
+	range.offset = begin / nonCoherentAtomSize * nonCoherentAtomSize;
+	range.size	 = AlignUp(end, nonCoherentAtomSize) - range.offset;
+
+	// Past the end of the memory only when it isn't a whole number of atoms
+	std::lock_guard lock(mutex);
+	if (range.offset + range.size > MemorySize(allocation))
+		range.size = VK_WHOLE_SIZE;
+	return range;
+}
+
+uint32_t MemoryAllocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			return i;
+		}
+	}
+
+	MVE_ASSERT(false, "Failed to find suitable memory type!");
+	return 0;
+}
+
+MemoryStats MemoryAllocator::GetStats() const
+{
+	std::lock_guard lock(mutex);
+	return stats;
+}
+
+std::vector<HeapStats> MemoryAllocator::GetHeapStats() const
+{
+	std::lock_guard lock(mutex);
+	return heapStats;
+}
+
+VkDeviceMemory MemoryAllocator::AllocateMemory(uint32_t memoryType, VkDeviceSize size, void** mapped)
+{
+	VkMemoryAllocateInfo allocInfo {};
+	allocInfo.sType			  = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize  = size;
+	allocInfo.memoryTypeIndex = memoryType;
+
+	VkDeviceMemory memory;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	*mapped = nullptr;
+	if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		auto error = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+		MVE_ASSERT(error == VK_SUCCESS, "Failed to map {} bytes of memory type {}", size, memoryType);
+	}
+
+	auto& heap = heapStats[HeapIndex(memoryType)];
+	heap.allocatedBytes += size;
+	heap.allocationCount++;
+	stats.allocatedBytes += size;
+	stats.allocationCount++;
+	stats.peakAllocatedBytes = std::max(stats.peakAllocatedBytes, stats.allocatedBytes);
+	return memory;
+}
+
+void MemoryAllocator::AddResource(uint32_t memoryType, VkDeviceSize size)
+{
+	auto& heap = heapStats[HeapIndex(memoryType)];
+	heap.usedBytes += size;
+	heap.resourceCount++;
+	stats.usedBytes += size;
+	stats.resourceCount++;
+}
+
+void MemoryAllocator::FreeMemory(uint32_t memoryType, VkDeviceMemory memory, VkDeviceSize size)
+{
+	// Freeing implicitly unmaps
+	vkFreeMemory(device, memory, nullptr);
+
+	auto& heap = heapStats[HeapIndex(memoryType)];
+	heap.allocatedBytes -= size;
+	heap.allocationCount--;
+	stats.allocatedBytes -= size;
+	stats.allocationCount--;
+}
+
+VkDeviceSize MemoryAllocator::BlockSize(uint32_t memoryType) const
+{
+	// Small heaps, like the 256 MB of device local memory that's host visible, would be used up by a few blocks
+	return std::min(BLOCK_SIZE, memoryProperties.memoryHeaps[HeapIndex(memoryType)].size / 8);
+}
+
+VkDeviceSize MemoryAllocator::MemorySize(const Allocation& allocation) const
+{
+	switch (allocation.kind) {
+	case Allocation::Kind::Block:
+		return pools[allocation.pool].blocks[allocation.block]->size;
+	case Allocation::Kind::Linear:
+		return pools[allocation.pool].linear.size;
+	default:
+		return allocation.size;
+	}
+}
+
+} // namespace MVE
\ No newline at end of file
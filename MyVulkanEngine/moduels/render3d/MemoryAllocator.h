@@ -0,0 +1,155 @@
+#pragma once
+
+#include "core/TlsfAllocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <mutex>
+
+namespace MVE
+{
+
+// How long the resource lives, decides which strategy its memory comes from
+enum class MemoryLifetime
+{
+	Persistent, // Sub-allocated from blocks with a TLSF allocator
+	Transient,	// Bump allocated from a linear block that is reset once everything in it was freed, for staging
+};
+
+/// A range of device memory bound to one buffer or image
+struct Allocation
+{
+	enum class Kind : uint8_t
+	{
+		None,
+		Block,
+		Linear,
+		Dedicated,
+	};
+
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset	  = 0;
+	VkDeviceSize size	  = 0;
+	void* mapped		  = nullptr; // Start of the allocation when the memory is host visible
+
+	Kind kind	   = Kind::None;
+	uint32_t pool  = 0; // Memory type and resource class, see MemoryAllocator::PoolIndex
+	uint32_t block = 0; // Index of the block in the pool
+	uint32_t node  = TlsfAllocator::INVALID_NODE;
+};
+
+struct MemoryStats
+{
+	VkDeviceSize allocatedBytes		= 0; // Device memory allocated from the driver
+	VkDeviceSize peakAllocatedBytes = 0;
+	uint32_t allocationCount		= 0; // VkDeviceMemory objects, limited by maxMemoryAllocationCount
+	VkDeviceSize usedBytes			= 0; // Bound to resources
+	uint32_t resourceCount			= 0;
+};
+
+struct HeapStats
+{
+	VkDeviceSize heapSize		= 0;
+	VkDeviceSize allocatedBytes = 0;
+	VkDeviceSize usedBytes		= 0;
+	uint32_t allocationCount	= 0;
+	uint32_t resourceCount		= 0;
+};
+
+/// Sub-allocates buffers and images from big VkDeviceMemory blocks, so the number of driver allocations stays far
+/// below maxMemoryAllocationCount and small resources don't each pay the allocation granularity. Every memory type has
+/// separate pools for buffers and for optimal tiling images, which keeps them out of each other's
+/// bufferImageGranularity pages. Resources bigger than half a block get a dedicated allocation. Host visible blocks are
+/// mapped once for their whole life, and Allocation::mapped points into that mapping. Thread safe.
+class MemoryAllocator
+{
+  public:
+	MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+	~MemoryAllocator();
+
+	MemoryAllocator(const MemoryAllocator&) = delete;
+	void operator=(const MemoryAllocator&)	= delete;
+
+	Allocation AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties,
+								 MemoryLifetime lifetime = MemoryLifetime::Persistent);
+	Allocation AllocateForImage(VkImage image, const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties);
+	// Resets allocation. The resource bound to it must already be destroyed.
+	void Free(Allocation& allocation);
+
+	// Range of the allocation's memory for vkFlushMappedMemoryRanges and vkInvalidateMappedMemoryRanges, widened to
+	// nonCoherentAtomSize. size VK_WHOLE_SIZE means up to the end of the allocation.
+	VkMappedMemoryRange MappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+	// For the Defragmenter. True when the block holds nothing but movableBytes of resources that can be moved, its
+	// memory isn't host visible and the other blocks of the pool have room for them.
+	bool CanEmptyBlock(uint32_t pool, uint32_t block, VkDeviceSize movableBytes) const;
+	// Memory for a copy of the resource in current, from the other blocks of current's pool. No block is added for it,
+	// the allocation is of kind None when they are full.
+	Allocation RelocateBuffer(VkBuffer buffer, const Allocation& current);
+	Allocation RelocateImage(VkImage image, const Allocation& current);
+
+	uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+	MemoryStats GetStats() const;
+	// One entry per memory heap of the physical device
+	std::vector<HeapStats> GetHeapStats() const;
+
+  private:
+	static constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+	struct Block
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size	  = 0;
+		void* mapped		  = nullptr;
+		TlsfAllocator allocator;
+		uint32_t allocationCount = 0;
+	};
+
+	// Transient memory, bumped from the front and rewound once it holds nothing anymore
+	struct LinearBlock
+	{
+		VkDeviceMemory memory	 = VK_NULL_HANDLE;
+		VkDeviceSize size		 = 0;
+		void* mapped			 = nullptr;
+		VkDeviceSize top		 = 0;
+		uint32_t allocationCount = 0;
+	};
+
+	struct Pool
+	{
+		std::vector<std::unique_ptr<Block>> blocks; // Freed blocks leave a null slot, so indices stay valid
+		LinearBlock linear;
+	};
+
+	// Buffers and optimal tiling images of the same memory type go to different pools
+	static uint32_t PoolIndex(uint32_t memoryType, bool optimalImage) { return memoryType * 2 + optimalImage; }
+
+	Allocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool optimalImage,
+						MemoryLifetime lifetime, bool preferDedicated);
+	Allocation Relocate(const VkMemoryRequirements& requirements, const Allocation& current);
+	// skipBlock isn't allocated from, and no block is added when one is skipped
+	bool AllocateFromBlocks(uint32_t poolIndex, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation,
+							uint32_t skipBlock = NO_BLOCK);
+	bool AllocateLinear(uint32_t poolIndex, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation);
+	// Returns VK_NULL_HANDLE when the heap is out of memory
+	VkDeviceMemory AllocateMemory(uint32_t memoryType, VkDeviceSize size, void** mapped);
+	void AddResource(uint32_t memoryType, VkDeviceSize size);
+	void FreeMemory(uint32_t memoryType, VkDeviceMemory memory, VkDeviceSize size);
+	VkDeviceSize BlockSize(uint32_t memoryType) const;
+	// Size of the VkDeviceMemory the allocation is in
+	VkDeviceSize MemorySize(const Allocation& allocation) const;
+	uint32_t HeapIndex(uint32_t memoryType) const { return memoryProperties.memoryTypes[memoryType].heapIndex; }
+
+  private:
+	VkDevice device;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	VkDeviceSize nonCoherentAtomSize;
+
+	mutable std::mutex mutex;
+	std::vector<Pool> pools;
+	std::vector<HeapStats> heapStats;
+	MemoryStats stats;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "MeshPool.h"
+
+#include "SwapChain.h"
+#include "UploadManager.h"
+
+#include <algorithm>
+
+namespace MVE
+{
+
+// Default page size, about 17 MB of vertices and 4 MB of indices. Bigger meshes get a page of their own size.
+constexpr uint32_t PAGE_VERTICES = 1 << 18;
+constexpr uint32_t PAGE_INDICES	 = 1 << 20;
+
+MeshPool::MeshPool(Device& device, VkDeviceSize vertexSize): device(device), vertexSize(vertexSize)
+{
+}
+
+MeshPool::Mesh MeshPool::Allocate(const void* vertices, uint32_t vertexCount, const uint32_t* indices,
+								  uint32_t indexCount)
+{
+	MVE_PROFILE_FUNCTION();
+	MVE_ASSERT(vertexCount > 0, "Mesh without vertices");
+
+	Mesh mesh {};
+	mesh.vertexCount = vertexCount;
+	mesh.indexCount	 = indexCount;
+
+	// First page that has room for both, so a mesh never spans two pages
+	auto tryPage = [&](uint32_t pageIndex) {
+		auto& page			 = pages[pageIndex];
+		uint64_t firstVertex = page.vertices.Allocate(vertexCount);
+		if (firstVertex == RangeAllocator::INVALID_OFFSET)
+			return false;
+
+		uint64_t firstIndex = 0;
+		if (indexCount > 0) {
+			firstIndex = page.indices.Allocate(indexCount);
+			if (firstIndex == RangeAllocator::INVALID_OFFSET) {
+				page.vertices.Free(firstVertex, vertexCount);
+				return false;
+			}
+		}
+
+		mesh.page		 = pageIndex;
+		mesh.firstVertex = firstVertex;
+		mesh.firstIndex	 = firstIndex;
+		return true;
+	};
+
+	bool allocated = false;
+	for (uint32_t i = 0; i < pages.size() && !allocated; i++) { allocated = tryPage(i); }
+	if (!allocated) {
+		AddPage(std::max(vertexCount, PAGE_VERTICES), std::max(indexCount, PAGE_INDICES));
+		allocated = tryPage(pages.size() - 1);
+	}
+	MVE_ASSERT(allocated, "Failed to allocate a mesh of {} vertices and {} indices", vertexCount, indexCount);
+
+	auto& page	   = pages[mesh.page];
+	auto& uploader = device.GetUploadManager();
+	uploader.UploadToBuffer(page.vertexBuffer->GetBuffer(), mesh.firstVertex * vertexSize, vertices,
+							vertexCount * vertexSize);
+	if (indexCount > 0) {
+		uploader.UploadToBuffer(page.indexBuffer->GetBuffer(), mesh.firstIndex * sizeof(uint32_t), indices,
+								indexCount * sizeof(uint32_t));
+	}
+	return mesh;
+}
+
+void MeshPool::Free(const Mesh& mesh)
+{
+	if (mesh.page == NO_PAGE)
+		return;
+
+	// One extra frame, the mesh may have been drawn in the frame that's being recorded right now
+	retiredMeshes.push_back({mesh, SwapChain::MAX_FRAMES_IN_FLIGHT + 1});
+}
+
+void MeshPool::ReleaseRetired()
+{
+	for (size_t i = 0; i < retiredMeshes.size();) {
+		if (--retiredMeshes[i].framesLeft > 0) {
+			i++;
+			continue;
+		}
+		Release(retiredMeshes[i].mesh);
+		retiredMeshes[i] = retiredMeshes.back();
+		retiredMeshes.pop_back();
+	}
+}
+
+void MeshPool::Release(const Mesh& mesh)
+{
+	auto& page = pages[mesh.page];
+	page.vertices.Free(mesh.firstVertex, mesh.vertexCount);
+	if (mesh.indexCount > 0)
+		page.indices.Free(mesh.firstIndex, mesh.indexCount);
+}
+
+void MeshPool::Bind(VkCommandBuffer commandBuffer, uint32_t page) const
+{
+	VkBuffer buffers[]	   = {pages[page].vertexBuffer->GetBuffer()};
+	VkDeviceSize offsets[] = {0};
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, pages[page].indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+}
+
+void MeshPool::DrawIndirect(VkCommandBuffer commandBuffer, bool indexed, VkBuffer buffer, VkDeviceSize offset,
+							uint32_t drawCount) const
+{
+	constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	// Without multiDrawIndirect every command needs a call of its own
+	uint32_t callCount = device.features.multiDrawIndirect ? 1 : drawCount;
+	uint32_t perCall   = drawCount / callCount;
+	for (uint32_t i = 0; i < callCount; i++) {
+		VkDeviceSize callOffset = offset + VkDeviceSize(i) * perCall * stride;
+		if (indexed)
+			vkCmdDrawIndexedIndirect(commandBuffer, buffer, callOffset, perCall, stride);
+		else
+			vkCmdDrawIndirect(commandBuffer, buffer, callOffset, perCall, stride);
+	}
+}
+
+MeshPool::Stats MeshPool::GetStats() const
+{
+	Stats stats {};
+	stats.pageCount = pages.size();
+	for (auto& page : pages) {
+		stats.usedBytes += page.vertices.UsedSize() * vertexSize + page.indices.UsedSize() * sizeof(uint32_t);
+		stats.reservedBytes += page.vertexBuffer->GetBufferSize() + page.indexBuffer->GetBufferSize();
+	}
+	return stats;
+}
+
+void MeshPool::AddPage(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+	MVE_INFO("MeshPool: adding page {} with room for {} vertices and {} indices", pages.size(), vertexCapacity,
+			 indexCapacity);
+
+	// Pages may be moved by the Defragmenter, Bind always uses the current buffers and the mesh ranges are relative
+	// to them, so nothing else has to be patched
+	constexpr VkBufferUsageFlags transfer = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	Page page {};
+	page.vertexBuffer = std::make_unique<Buffer>(device, vertexSize, vertexCapacity,
+												 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | transfer,
+												 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	page.indexBuffer  = std::make_unique<Buffer>(device, sizeof(uint32_t), indexCapacity,
+												 VK_BUFFER_USAGE_INDEX_BUFFER_BIT | transfer,
+												 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	page.vertices	  = RangeAllocator(vertexCapacity);
+	page.indices	  = RangeAllocator(indexCapacity);
+	device.GetDefragmenter().Register(page.vertexBuffer.get());
+	device.GetDefragmenter().Register(page.indexBuffer.get());
+	pages.push_back(std::move(page));
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Device.h"
+
+#include "core/RangeAllocator.h"
+
+namespace MVE
+{
+
+/// Sub-allocates the vertices and indices of static meshes from a few large device local buffers, grouped in pages.
+/// Meshes in the same page are drawn without rebinding anything, so their indirect draws can be merged into one
+/// multi-draw. A page is only added when a mesh doesn't fit into any of the existing ones.
+class MeshPool
+{
+  public:
+	static constexpr uint32_t NO_PAGE = UINT32_MAX;
+
+	struct Mesh
+	{
+		uint32_t page		 = NO_PAGE;
+		uint32_t firstVertex = 0; // The vertex offset of indexed draws
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex	 = 0;
+		uint32_t indexCount	 = 0; // 0 for meshes drawn without indices
+	};
+
+	struct Stats
+	{
+		uint32_t pageCount		   = 0;
+		VkDeviceSize usedBytes	   = 0;
+		VkDeviceSize reservedBytes = 0; // Size of all pages
+	};
+
+  public:
+	MeshPool(Device& device, VkDeviceSize vertexSize);
+	~MeshPool() = default;
+
+	MeshPool(const MeshPool&)		= delete;
+	void operator=(const MeshPool&) = delete;
+
+	// Uploads the mesh, the copy runs before the next frame that is submitted
+	Mesh Allocate(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+	// Frames in flight may still draw the mesh, so its ranges are only reused a few frames later
+	void Free(const Mesh& mesh);
+	// Called once per frame, makes the ranges of meshes freed long enough ago available again
+	void ReleaseRetired();
+
+	// Binds the page's vertex buffer to binding 0 and its index buffer
+	void Bind(VkCommandBuffer commandBuffer, uint32_t page) const;
+	// drawCount consecutive commands of the bound page, VkDrawIndexedIndirectCommands when indexed is true and
+	// VkDrawIndirectCommands otherwise, both with the stride of VkDrawIndexedIndirectCommand
+	void DrawIndirect(VkCommandBuffer commandBuffer, bool indexed, VkBuffer buffer, VkDeviceSize offset,
+					  uint32_t drawCount) const;
+
+	Stats GetStats() const;
+
+  private:
+	struct Page
+	{
+		std::unique_ptr<Buffer> vertexBuffer;
+		std::unique_ptr<Buffer> indexBuffer;
+		RangeAllocator vertices; // In vertices, not bytes
+		RangeAllocator indices;
+	};
+
+	struct RetiredMesh
+	{
+		Mesh mesh;
+		uint32_t framesLeft;
+	};
+
+	void AddPage(uint32_t vertexCapacity, uint32_t indexCapacity);
+	void Release(const Mesh& mesh);
+
+  private:
+	Device& device;
+	VkDeviceSize vertexSize;
+	std::vector<Page> pages;
+	std::vector<RetiredMesh> retiredMeshes;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -4,32 +4,38 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include <cstring>
+
 namespace MVE
 {
 
-Model::Model(Device& device, const Builder& builder): device(device)
+Model::Model(Device& device, const Builder& builder):
+	device(device), boundingBox(builder.boundingBox), boundingSphere(builder.boundingSphere)
 {
-	CreateVertexBuffers(builder.vertices);
-	CreateIndexBuffers(builder.indices);
+	MVE_ASSERT(builder.vertices.size() >= 3, "Vertex Count must be at least 3");
+	MVE_ASSERT(builder.indices.empty() || builder.indices.size() >= 3, "Index Count must be at least 3, or empty");
+
+	mesh = device.GetMeshPool().Allocate(builder.vertices.data(), builder.vertices.size(), builder.indices.data(),
+										 builder.indices.size());
 }
 
-void Model::Bind(VkCommandBuffer commandBuffer)
+Model::~Model()
 {
-	VkBuffer buffers[]	   = {vertexBuffer->GetBuffer()};
-	VkDeviceSize offsets[] = {0};
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+	device.GetMeshPool().Free(mesh);
+}
 
-	if (hasIndexBuffer) {
-		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
-	}
+void Model::Bind(VkCommandBuffer commandBuffer)
+{
+	device.GetMeshPool().Bind(commandBuffer, mesh.page);
 }
 
-void Model::Draw(VkCommandBuffer commandBuffer)
+void Model::Draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance)
 {
-	if (hasIndexBuffer) {
-		vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+	if (IsIndexed()) {
+		vkCmdDrawIndexed(commandBuffer, mesh.indexCount, instanceCount, mesh.firstIndex, int32_t(mesh.firstVertex),
+						 firstInstance);
 	} else {
-		vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+		vkCmdDraw(commandBuffer, mesh.vertexCount, instanceCount, mesh.firstVertex, firstInstance);
 	}
 }
 
@@ -41,48 +47,16 @@ std::unique_ptr<Model> Model::CreateModelFromFile(Device& device, const std::str
 	return std::make_unique<Model>(device, builder);
 }
 
-void Model::CreateVertexBuffers(const std::vector<Vertex>& vertices)
+void Model::WriteIndirectCommand(void* command, uint32_t firstInstance) const
 {
-	vertexCount = vertices.size();
-	MVE_ASSERT(vertexCount >= 3, "Vertex Count must be at least 3");
-	uint32_t vertexSize		= sizeof(vertices[0]);
-	VkDeviceSize bufferSize = vertexCount * vertexSize;
-
-	Buffer stagingBuffer(device, vertexSize, vertexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	stagingBuffer.Map();
-	stagingBuffer.WriteToBuffer((void*)vertices.data());
-
-	vertexBuffer = std::make_unique<Buffer>(device, vertexSize, vertexCount,
-											VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-											VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	device.CopyBuffer(stagingBuffer.GetBuffer(), vertexBuffer->GetBuffer(), bufferSize);
-}
-
-void Model::CreateIndexBuffers(const std::vector<uint32_t>& indices)
-{
-	indexCount	   = indices.size();
-	hasIndexBuffer = indexCount > 0;
-	if (!hasIndexBuffer)
-		return;
-
-	MVE_ASSERT(indexCount >= 3, "Index Count must be at least 3, or empty");
-	uint32_t indexSize		= sizeof(indices[0]);
-	VkDeviceSize bufferSize = indexSize * indexCount;
-
-	Buffer stagingBuffer(device, indexSize, indexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-						 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	stagingBuffer.Map();
-	stagingBuffer.WriteToBuffer((void*)indices.data());
-
-	indexBuffer = std::make_unique<Buffer>(device, indexSize, indexCount,
-										   VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-										   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	device.CopyBuffer(stagingBuffer.GetBuffer(), indexBuffer->GetBuffer(), bufferSize);
+	if (IsIndexed()) {
+		VkDrawIndexedIndirectCommand indexed {mesh.indexCount, 0, mesh.firstIndex, int32_t(mesh.firstVertex),
+											  firstInstance};
+		std::memcpy(command, &indexed, sizeof(indexed));
+	} else {
+		VkDrawIndirectCommand direct {mesh.vertexCount, 0, mesh.firstVertex, firstInstance};
+		std::memcpy(command, &direct, sizeof(direct));
+	}
 }
 
 std::vector<VkVertexInputBindingDescription> Model::Vertex::getBindingDescriptions()
@@ -146,6 +120,27 @@ void Model::Builder::LoadModel(const std::string& filepath)
 			indices.push_back(mesh->mFaces[j].mIndices[2]);
 		}
 	}
+
+	ComputeBounds();
+}
+
+void Model::Builder::ComputeBounds()
+{
+	boundingBox = {};
+	for (auto& vertex : vertices) { boundingBox.Grow(vertex.position); }
+	if (boundingBox.IsEmpty()) {
+		boundingSphere = {};
+		return;
+	}
+
+	// Centered on the box, but only as large as the farthest vertex, which is tighter than the box's half diagonal
+	glm::vec3 center = boundingBox.Center();
+	float radius2	 = 0.0f;
+	for (auto& vertex : vertices) {
+		glm::vec3 offset = vertex.position - center;
+		radius2			 = glm::max(radius2, glm::dot(offset, offset));
+	}
+	boundingSphere = {center, glm::sqrt(radius2)};
 }
 
 } // namespace MVE
\ No newline at end of file
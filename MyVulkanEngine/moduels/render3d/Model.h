@@ -2,6 +2,11 @@
 
 #include "Buffer.h"
 #include "Device.h"
+#include "MeshPool.h"
+
+#include "core/Bounds.h"
+
+#include <atomic>
 
 namespace MVE
 {
@@ -24,35 +29,49 @@ class Model
 	{
 		std::vector<Vertex> vertices {};
 		std::vector<uint32_t> indices {};
+		Aabb boundingBox {};
+		BoundingSphere boundingSphere {};
 
 		void LoadModel(const std::string& filepath);
+		// Fits the bounds to the vertices, LoadModel already calls it
+		void ComputeBounds();
 	};
 
   public:
 	Model(Device& device, const Builder& builder);
-	~Model() = default;
+	~Model();
 
 	Model(const Model&)			 = delete;
 	void operator=(const Model&) = delete;
 
+	// Binds the mesh pool page, models in the same page don't have to be bound again
 	void Bind(VkCommandBuffer commandBuffer);
-	void Draw(VkCommandBuffer commandBuffer);
+	void Draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+	// Indexed models write a VkDrawIndexedIndirectCommand and the others a VkDrawIndirectCommand, both with
+	// instanceCount left at 0. Drawn with MeshPool::DrawIndirect.
+	void WriteIndirectCommand(void* command, uint32_t firstInstance) const;
+
+	const MeshPool::Mesh& GetMesh() const { return mesh; }
+	bool IsIndexed() const { return mesh.indexCount > 0; }
+	uint32_t TriangleCount() const { return (IsIndexed() ? mesh.indexCount : mesh.vertexCount) / 3; }
+	// Small number unique to the model, for sort keys
+	uint32_t GetId() const { return id; }
+	// In model space
+	const Aabb& GetBoundingBox() const { return boundingBox; }
+	const BoundingSphere& GetBoundingSphere() const { return boundingSphere; }
 
   public:
 	static std::unique_ptr<Model> CreateModelFromFile(Device& device, const std::string& filepath);
 
   private:
-	void CreateVertexBuffers(const std::vector<Vertex>& vertices);
-	void CreateIndexBuffers(const std::vector<uint32_t>& indices);
+	inline static std::atomic<uint32_t> nextId = 0;
 
-  private:
 	Device& device;
+	uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
 
-	std::unique_ptr<Buffer> vertexBuffer;
-	uint32_t vertexCount;
+	MeshPool::Mesh mesh;
 
-	bool hasIndexBuffer = false;
-	std::unique_ptr<Buffer> indexBuffer;
-	uint32_t indexCount;
+	Aabb boundingBox;
+	BoundingSphere boundingSphere;
 };
-} // namespace MVE
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "OffscreenTarget.h"
+
+namespace MVE
+{
+
+OffscreenTarget::OffscreenTarget(Device& deviceRef, VkExtent2D extent): device {deviceRef}, extent {extent}
+{
+	depthFormat = device.FindDepthFormat();
+
+	CreateImages();
+	CreateRenderPass();
+	CreateFramebuffers();
+	CreateSyncObjects();
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+	for (auto framebuffer : framebuffers) { vkDestroyFramebuffer(device.VulkanDevice(), framebuffer, nullptr); }
+
+	for (int i = 0; i < colorImages.size(); i++) {
+		vkDestroyImageView(device.VulkanDevice(), colorImageViews[i], nullptr);
+		vkDestroyImage(device.VulkanDevice(), colorImages[i], nullptr);
+		device.FreeMemory(colorImageMemorys[i]);
+
+		vkDestroyImageView(device.VulkanDevice(), depthImageViews[i], nullptr);
+		vkDestroyImage(device.VulkanDevice(), depthImages[i], nullptr);
+		device.FreeMemory(depthImageMemorys[i]);
+	}
+
+	vkDestroyRenderPass(device.VulkanDevice(), renderPass, nullptr);
+
+	for (auto fence : inFlightFences) { vkDestroyFence(device.VulkanDevice(), fence, nullptr); }
+}
+
+VkResult OffscreenTarget::AcquireNextImage(uint32_t* imageIndex)
+{
+	MVE_PROFILE_SCOPE("OffscreenTarget::AcquireNextImage");
+	vkWaitForFences(device.VulkanDevice(), 1, &inFlightFences[currentFrame], VK_TRUE,
+					std::numeric_limits<uint64_t>::max());
+
+	*imageIndex = currentFrame;
+	return VK_SUCCESS;
+}
+
+VkResult OffscreenTarget::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex)
+{
+	MVE_PROFILE_SCOPE("OffscreenTarget::SubmitCommandBuffers");
+	VkSubmitInfo submitInfo		  = {};
+	submitInfo.sType			  = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers	  = buffers;
+
+	vkResetFences(device.VulkanDevice(), 1, &inFlightFences[currentFrame]);
+	auto result = device.QueueSubmit(device.GraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]);
+	if (result != VK_SUCCESS) {
+		MVE_ERROR("Failed to submit draw command buffer!");
+	}
+
+	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+
+	return result;
+}
+
+void OffscreenTarget::CreateImages()
+{
+	colorImages.resize(MAX_FRAMES_IN_FLIGHT);
+	colorImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+	colorImageViews.resize(MAX_FRAMES_IN_FLIGHT);
+	depthImages.resize(MAX_FRAMES_IN_FLIGHT);
+	depthImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+	depthImageViews.resize(MAX_FRAMES_IN_FLIGHT);
+
+	VkImageCreateInfo imageInfo {};
+	imageInfo.sType			= VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType		= VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width	= extent.width;
+	imageInfo.extent.height = extent.height;
+	imageInfo.extent.depth	= 1;
+	imageInfo.mipLevels		= 1;
+	imageInfo.arrayLayers	= 1;
+	imageInfo.tiling		= VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.samples		= VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.flags			= 0;
+
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		imageInfo.format = colorFormat;
+		imageInfo.usage	 = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImages[i],
+								   colorImageMemorys[i]);
+		colorImageViews[i] = CreateImageView(colorImages[i], colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		imageInfo.format = depthFormat;
+		imageInfo.usage	 = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImages[i],
+								   depthImageMemorys[i]);
+		depthImageViews[i] = CreateImageView(depthImages[i], depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+	}
+}
+
+VkImageView OffscreenTarget::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect)
+{
+	VkImageViewCreateInfo viewInfo {};
+	viewInfo.sType							 = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image							 = image;
+	viewInfo.viewType						 = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format							 = format;
+	viewInfo.subresourceRange.aspectMask	 = aspect;
+	viewInfo.subresourceRange.baseMipLevel	 = 0;
+	viewInfo.subresourceRange.levelCount	 = 1;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount	 = 1;
+
+	VkImageView imageView;
+	if (vkCreateImageView(device.VulkanDevice(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+		MVE_ERROR("Failed to create offscreen image view!");
+	}
+	return imageView;
+}
+
+void OffscreenTarget::CreateRenderPass()
+{
+	VkAttachmentDescription depthAttachment {};
+	depthAttachment.format		   = depthFormat;
+	depthAttachment.samples		   = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp		   = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp		   = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.finalLayout	   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentRef {};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout	  = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	// Left in transfer src layout so a frame can be copied out for inspection.
+	VkAttachmentDescription colorAttachment = {};
+	colorAttachment.format					= colorFormat;
+	colorAttachment.samples					= VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp					= VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp					= VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilStoreOp			= VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.stencilLoadOp			= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.initialLayout			= VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout				= VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+	VkAttachmentReference colorAttachmentRef = {};
+	colorAttachmentRef.attachment			 = 0;
+	colorAttachmentRef.layout				 = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass	= {};
+	subpass.pipelineBindPoint		= VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount	= 1;
+	subpass.pColorAttachments		= &colorAttachmentRef;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+	VkSubpassDependency dependency = {};
+	dependency.srcSubpass		   = VK_SUBPASS_EXTERNAL;
+	dependency.srcAccessMask	   = 0;
+	dependency.srcStageMask =
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependency.dstSubpass = 0;
+	dependency.dstStageMask =
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+	VkRenderPassCreateInfo renderPassInfo			   = {};
+	renderPassInfo.sType							   = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount					   = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments						   = attachments.data();
+	renderPassInfo.subpassCount						   = 1;
+	renderPassInfo.pSubpasses						   = &subpass;
+	renderPassInfo.dependencyCount					   = 1;
+	renderPassInfo.pDependencies					   = &dependency;
+
+	if (vkCreateRenderPass(device.VulkanDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+		MVE_ERROR("Failed to create offscreen render pass!");
+	}
+}
+
+void OffscreenTarget::CreateFramebuffers()
+{
+	framebuffers.resize(ImageCount());
+	for (size_t i = 0; i < ImageCount(); i++) {
+		std::array<VkImageView, 2> attachments = {colorImageViews[i], depthImageViews[i]};
+
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType					= VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass				= renderPass;
+		framebufferInfo.attachmentCount			= static_cast<uint32_t>(attachments.size());
+		framebufferInfo.pAttachments			= attachments.data();
+		framebufferInfo.width					= extent.width;
+		framebufferInfo.height					= extent.height;
+		framebufferInfo.layers					= 1;
+
+		if (vkCreateFramebuffer(device.VulkanDevice(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+			MVE_ERROR("Failed to create offscreen framebuffer!");
+		}
+	}
+}
+
+void OffscreenTarget::CreateSyncObjects()
+{
+	inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType				= VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags				= VK_FENCE_CREATE_SIGNALED_BIT;
+
+	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		if (vkCreateFence(device.VulkanDevice(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+			MVE_ERROR("Failed to create synchronization objects for a frame!");
+		}
+	}
+}
+
+} // namespace MVE
\ No newline at end of file
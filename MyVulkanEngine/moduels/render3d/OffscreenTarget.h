@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Device.h"
+#include "RenderTarget.h"
+
+#include <vulkan/vulkan.h>
+
+namespace MVE
+{
+
+/// Color and depth images the renderer draws into when there is no window to present to.
+/// One image set per frame in flight, so frames still overlap the same way they do with a swap chain.
+class OffscreenTarget : public RenderTarget
+{
+  public:
+	OffscreenTarget(Device& deviceRef, VkExtent2D extent);
+	~OffscreenTarget();
+
+	VkFramebuffer GetFrameBuffer(int index) override { return framebuffers[index]; }
+	VkRenderPass GetRenderPass() override { return renderPass; }
+	VkImage GetColorImage(int index) { return colorImages[index]; }
+	size_t ImageCount() override { return colorImages.size(); }
+	VkFormat GetImageFormat() override { return colorFormat; }
+	VkFormat GetDepthFormat() override { return depthFormat; }
+	VkExtent2D GetExtent() override { return extent; }
+
+	VkResult AcquireNextImage(uint32_t* imageIndex) override;
+	VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) override;
+
+  private:
+	void CreateImages();
+	void CreateRenderPass();
+	void CreateFramebuffers();
+	void CreateSyncObjects();
+
+	VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect);
+
+  private:
+	Device& device;
+	VkExtent2D extent;
+
+	VkFormat colorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+	VkFormat depthFormat;
+	VkRenderPass renderPass;
+
+	std::vector<VkImage> colorImages;
+	std::vector<Allocation> colorImageMemorys;
+	std::vector<VkImageView> colorImageViews;
+	std::vector<VkImage> depthImages;
+	std::vector<Allocation> depthImageMemorys;
+	std::vector<VkImageView> depthImageViews;
+	std::vector<VkFramebuffer> framebuffers;
+
+	std::vector<VkFence> inFlightFences;
+	size_t currentFrame = 0;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -103,7 +103,7 @@ void Pipeline::CreateShaderModule(const std::vector<char>& code, VkShaderModule*
 	createInfo.pNext	= VK_NULL_HANDLE;
 
 	auto error = vkCreateShaderModule(device.VulkanDevice(), &createInfo, nullptr, shaderModule);
-	assert(error == VK_SUCCESS, "Failed to create shader module");
+	MVE_ASSERT(error == VK_SUCCESS, "Failed to create shader module");
 }
 
 void Pipeline::EnableAlphaBlending(PipelineConfigInfo& configInfo)
@@ -210,9 +210,9 @@ void GraphicsPipeline::CreateGraphicsPipeline(const std::string& vertFilepath, c
 	pipelineInfo.basePipelineIndex	= -1;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-	auto error =
-		vkCreateGraphicsPipelines(device.VulkanDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline);
-	assert(error == VK_SUCCESS, "Failed to create graphics pipeline");
+	auto error = vkCreateGraphicsPipelines(device.VulkanDevice(), device.GetPipelineCache(), 1, &pipelineInfo, nullptr,
+										   &graphicsPipeline);
+	MVE_ASSERT(error == VK_SUCCESS, "Failed to create graphics pipeline");
 }
 
 ComputePipeline::ComputePipeline(Device& device, const std::string& computeFilepath, VkPipelineLayout pipelineLayout,
@@ -258,9 +258,9 @@ void ComputePipeline::CreateComputePipeline(const std::string& computeFilepath,
 	pipelineInfo.pNext	= nullptr;
 	pipelineInfo.flags	= 0;
 
-	auto error =
-		vkCreateComputePipelines(device.VulkanDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline);
-	assert(error == VK_SUCCESS, "Failed to create graphics pipeline");
+	auto error = vkCreateComputePipelines(device.VulkanDevice(), device.GetPipelineCache(), 1, &pipelineInfo, nullptr,
+										  &computePipeline);
+	MVE_ASSERT(error == VK_SUCCESS, "Failed to create graphics pipeline");
 }
 
 } // namespace MVE
\ No newline at end of file
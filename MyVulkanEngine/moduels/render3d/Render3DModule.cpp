@@ -5,15 +5,42 @@ namespace MVE
 
 void Render3DModule::OnAttach()
 {
-	GenerateBrdfLut();
+	MVE_PROFILE_SCOPE("Render3DModule::OnAttach");
+
+	materialSystem	  = std::make_unique<MaterialSystem>(device);
+	clusteredLighting = std::make_unique<ClusteredLighting>(device);
+
+	globalSetLayout = DescriptorSetLayout::Builder(device)
+						  .AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+						  .AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
+						  .AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
+						  .AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
+						  .AddBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+						  .AddBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+						  .AddBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+						  .Build();
 
-	materialSystem = std::make_unique<MaterialSystem>(device);
+	// The systems only start compiling their pipelines, the workers build them while the scene loads below
+	pbrRenderSystem	 = std::make_unique<PbrRenderSystem>(device, renderer.GetSwapChainRenderPass(),
+														 globalSetLayout->GetDescriptorSetLayout(), *materialSystem,
+														 cpuCulling);
+	pointLightSystem = std::make_unique<PointLightSystem>(device, renderer.GetSwapChainRenderPass(),
+														  globalSetLayout->GetDescriptorSetLayout());
+	skyboxSystem	 = std::make_unique<SkyboxSystem>(device, renderer.GetSwapChainRenderPass(),
+												  globalSetLayout->GetDescriptorSetLayout());
+
+	GenerateBrdfLut();
 	LoadGameObjects();
 
+	// The compute passes ran while the scene loaded
+	skyboxCubemap->Wait();
+	device.GetAsyncCompute().Wait(brdfLutTicket);
+
 	globalPool = DescriptorPool::Builder(device)
 					 .SetMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
 					 .AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
 					 .AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SwapChain::MAX_FRAMES_IN_FLIGHT * 3)
+					 .AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT * 3)
 					 .Build();
 
 	globalUboBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
@@ -24,37 +51,44 @@ void Render3DModule::OnAttach()
 		globalUboBuffers[i]->Map();
 	}
 
-	globalSetLayout = DescriptorSetLayout::Builder(device)
-						  .AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-						  .AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
-						  .AddBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
-						  .AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
-						  .Build();
-
 	auto skyboxImageInfo	 = skyboxCubemap->ImageInfo();
 	auto irradianceImageInfo = skyboxCubemap->IrradianceImageInfo();
 	auto brdfLutImageInfo	 = brdfLut->ImageInfo();
 	globalDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
 	for (int i = 0; i < globalDescriptorSets.size(); i++) {
 		auto bufferInfo = globalUboBuffers[i]->DescriptorInfo();
+		auto lightInfo	= clusteredLighting->LightInfo(i);
+		auto countInfo	= clusteredLighting->CountInfo(i);
+		auto indexInfo	= clusteredLighting->IndexInfo(i);
 		DescriptorWriter(*globalSetLayout, *globalPool)
 			.WriteBuffer(0, &bufferInfo)
 			.WriteImage(1, &skyboxImageInfo)
 			.WriteImage(2, &irradianceImageInfo)
 			.WriteImage(3, &brdfLutImageInfo)
+			.WriteBuffer(4, &lightInfo)
+			.WriteBuffer(5, &countInfo)
+			.WriteBuffer(6, &indexInfo)
 			.Build(globalDescriptorSets[i]);
+		setSkyboxes[i] = skyboxCubemap.get();
 	}
-
-	pbrRenderSystem	 = std::make_unique<PbrRenderSystem>(device, renderer.GetSwapChainRenderPass(),
-														 globalSetLayout->GetDescriptorSetLayout(), *materialSystem);
-	pointLightSystem = std::make_unique<PointLightSystem>(device, renderer.GetSwapChainRenderPass(),
-														  globalSetLayout->GetDescriptorSetLayout());
-	skyboxSystem	 = std::make_unique<SkyboxSystem>(device, renderer.GetSwapChainRenderPass(),
-												  globalSetLayout->GetDescriptorSetLayout());
 }
 
 void Render3DModule::OnDetach()
 {
+	JobSystem::Wait(environmentLoading);
+}
+
+void Render3DModule::SetEnvironment(const std::string& hdriPath)
+{
+	// One environment loads at a time, one that isn't ready yet is dropped
+	JobSystem::Wait(environmentLoading);
+	if (pendingSkybox)
+		retiredSkyboxes.push_back({std::move(pendingSkybox), SwapChain::MAX_FRAMES_IN_FLIGHT + 1});
+
+	auto cubemap  = std::make_shared<Cubemap>(device);
+	pendingSkybox = cubemap;
+	// A background job, the main thread never takes over the load while it waits inside a frame
+	JobSystem::RunBackground([cubemap, hdriPath] { cubemap->CreateFromHdri(hdriPath, 512); }, &environmentLoading);
 }
 
 void Render3DModule::OnUpdate(Timestep dt)
@@ -100,26 +134,69 @@ void Render3DModule::OnUpdate(Timestep dt)
 		}
 	}
 
+	// Saved as soon as the startup pipelines exist, instances are often killed instead of shut down
+	if (!pipelineCacheSaved && PipelineCompiler::IsIdle()) {
+		device.SavePipelineCache();
+		pipelineCacheSaved = true;
+	}
+
 	auto commandBuffer = renderer.BeginFrame();
 	if (commandBuffer) {
 		int frameIndex = renderer.GetFrameIndex();
-		FrameInfo frameInfo {frameIndex, dt, commandBuffer, camera, globalDescriptorSets[frameIndex]};
+		frameStats	   = {};
+		FrameInfo frameInfo {frameIndex, dt, commandBuffer, camera, globalDescriptorSets[frameIndex], frameStats};
+		device.GetMeshPool().ReleaseRetired();
+		device.GetDefragmenter().Update();
+		device.GetAsyncCompute().Update();
+		UpdateEnvironment(frameIndex);
+
+		TransformSystem::Update(registry);
+		// The GPU culling doesn't read the renderables tree
+		spatialIndex.Update(registry, !pbrRenderSystem->CullsOnGpu());
 
 		GlobalUbo ubo {};
 		ubo.view		= camera.GetView();
 		ubo.projection	= camera.GetProjection();
 		ubo.inverseView = camera.GetInverseView();
-		pointLightSystem->Update(frameInfo, gameObjects, ubo);
+		pointLightSystem->Update(frameInfo, registry, ubo);
+		clusteredLighting->Update(frameInfo, registry, ubo, renderer.GetExtent());
 
 		globalUboBuffers[frameIndex]->WriteToBuffer(&ubo);
 		globalUboBuffers[frameIndex]->Flush();
 
-		renderer.BeginSwapChainRenderPass(commandBuffer);
+		auto gpuProfiler = &renderer.GetGpuProfiler();
+		{
+			MVE_GPU_PROFILE_SCOPE(gpuProfiler, commandBuffer, "PbrRenderSystem::Prepare");
+			pbrRenderSystem->PrepareGameObjects(frameInfo, registry);
+		}
+		{
+			MVE_GPU_PROFILE_SCOPE(gpuProfiler, commandBuffer, "ClusteredLighting");
+			clusteredLighting->Cull(frameInfo);
+		}
+
+		// The pass is recorded into secondary command buffers, the primary one can't have timestamps inside it
+		MVE_GPU_PROFILE_SCOPE(gpuProfiler, commandBuffer, "MainPass");
+		renderer.BeginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-		pbrRenderSystem->RenderGameObjects(frameInfo, gameObjects, *materialSystem);
-		skyboxSystem->Render(frameInfo, *skyboxCubemap);
-		pointLightSystem->Render(frameInfo, gameObjects);
+		secondaryCommandBuffers.clear();
+		pbrRenderSystem->RenderGameObjects(frameInfo, registry, spatialIndex, *materialSystem, renderer,
+										   secondaryCommandBuffers);
 
+		// Only a few draws, recorded on the main thread after the PBR ones
+		FrameInfo passFrameInfo		= frameInfo;
+		passFrameInfo.commandBuffer = renderer.BeginSecondaryCommandBuffer();
+		{
+			MVE_GPU_PROFILE_SCOPE(gpuProfiler, passFrameInfo.commandBuffer, "SkyboxSystem");
+			skyboxSystem->Render(passFrameInfo, *skyboxCubemap);
+		}
+		{
+			MVE_GPU_PROFILE_SCOPE(gpuProfiler, passFrameInfo.commandBuffer, "PointLightSystem");
+			pointLightSystem->Render(passFrameInfo, registry, spatialIndex);
+		}
+		renderer.EndSecondaryCommandBuffer(passFrameInfo.commandBuffer);
+		secondaryCommandBuffers.push_back(passFrameInfo.commandBuffer);
+
+		vkCmdExecuteCommands(commandBuffer, secondaryCommandBuffers.size(), secondaryCommandBuffers.data());
 		renderer.EndSwapChainRenderPass(commandBuffer);
 	}
 	renderer.EndFrame();
@@ -127,167 +204,53 @@ void Render3DModule::OnUpdate(Timestep dt)
 
 void Render3DModule::LoadGameObjects()
 {
-	auto vaseSceneSetup = [&]() {
-		std::shared_ptr model = Model::CreateModelFromFile(device, RES_DIR "models/smooth_vase.obj");
-
-		// Materials
-		auto redMatId			= materialSystem->CreateMaterial();
-		auto& redMat			= materialSystem->Get(redMatId);
-		redMat.params.albedo	= glm::vec4(0.9f, 0.2f, 0.2f, 1.0f);
-		redMat.params.roughness = 0.85f;
-		redMat.params.metallic	= 0.0f;
-
-		auto goldMatId			 = materialSystem->CreateMaterial();
-		auto& goldMat			 = materialSystem->Get(goldMatId);
-		goldMat.params.albedo	 = glm::vec4(0.944f, 0.776f, 0.373f, 1.0f);
-		goldMat.params.roughness = 0.3f;
-		goldMat.params.metallic	 = 1.0f;
-
-		auto floorMatId			 = materialSystem->CreateMaterial();
-		auto& floorMat			 = materialSystem->Get(floorMatId);
-		floorMat.params.uvScale	 = glm::vec2 {5.0f};
-		floorMat.textures.albedo = Texture::Builder(device)
-									   .addLayer(FileTextureSource(RES_DIR "textures/floor/slate_floor_diff_2k.jpg"))
-									   .build();
-		floorMat.textures.arm = Texture::Builder(device)
-									.addLayer(FileTextureSource(RES_DIR "textures/floor/slate_floor_arm_2k.jpg"))
-									.format(VK_FORMAT_R8G8B8A8_UNORM)
-									.build();
-		floorMat.textures.normal = Texture::Builder(device)
-									   .addLayer(FileTextureSource(RES_DIR "textures/floor/slate_floor_nor_gl_2k.jpg"))
-									   .format(VK_FORMAT_R8G8B8A8_UNORM)
-									   .build();
-
-		// Objects
-		auto object					 = GameObject::Create();
-		object.model				 = model;
-		object.transform.translation = {0.5f, 0.0f, 0.0f};
-		object.transform.scale		 = glm::vec3 {3.0f};
-		object.materialId			 = redMatId;
-
-		gameObjects.emplace(object.getId(), std::move(object));
-
-		object						 = GameObject::Create();
-		object.model				 = model;
-		object.transform.translation = {-0.5f, 0.0f, 0.0f};
-		object.transform.scale		 = glm::vec3 {1.0f, 0.3f, 0.5f} * 3.0f;
-		object.materialId			 = goldMatId;
-
-		gameObjects.emplace(object.getId(), std::move(object));
-
-		std::shared_ptr floor = Model::CreateModelFromFile(device, RES_DIR "models/quad.obj");
-
-		object						 = GameObject::Create();
-		object.model				 = floor;
-		object.transform.translation = {0.0f, 0.0f, 0.0f};
-		object.transform.scale		 = glm::vec3 {5.0f};
-		object.materialId			 = floorMatId;
-		gameObjects.emplace(object.getId(), std::move(object));
-
-		// Lights
-
-		object						 = GameObject::CreatePointLight(0.5f, 0.1f, {0.5f, 0.1f, 0.1f});
-		object.transform.translation = {-1.0f, -1.0f, -1.0f};
-		gameObjects.emplace(object.getId(), std::move(object));
-
-		object						 = GameObject::CreatePointLight(1.0f, 0.2f, {0.1f, 0.1f, 0.5f});
-		object.transform.translation = {1.0f, -1.0f, -1.0f};
-		gameObjects.emplace(object.getId(), std::move(object));
-
-		object						 = GameObject::CreatePointLight(0.7f, 0.15f, {1.0f, 1.0f, 1.0f});
-		object.transform.translation = {0.0f, -0.5f, 0.0f};
-		gameObjects.emplace(object.getId(), std::move(object));
-
-		object					  = GameObject::CreateDirectionalLight(1.5f, {1.0f, 1.0f, 1.0f});
-		object.transform.rotation = glm::quat({0.7f, 0.0f, -1.5f});
-		gameObjects.emplace(object.getId(), std::move(object));
-	};
-
-	auto sphereSceneSetup = [&]() {
-		std::shared_ptr sphere = Model::CreateModelFromFile(device, RES_DIR "models/sphere.obj");
-		int n				   = 6;
-		for (int i = 0; i < n; i++) {
-			for (int j = 0; j < n; j++) {
-				auto matId			 = materialSystem->CreateMaterial();
-				auto& mat			 = materialSystem->Get(matId);
-				mat.params.albedo	 = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
-				mat.params.roughness = float(i) / (n - 1);
-				mat.params.metallic	 = float(j) / (n - 1);
-
-				auto object					 = GameObject::Create();
-				object.model				 = sphere;
-				object.transform.translation = glm::vec3 {i - (n - 1) / 2.0f, j - (n - 1) / 2.0f, 0.0f};
-				object.transform.scale		 = glm::vec3 {0.15f};
-				object.materialId			 = matId;
-				gameObjects.emplace(object.getId(), std::move(object));
-			}
-		}
-
-		// Lights
-		auto light				 = GameObject::CreateDirectionalLight(1.5f, {1.0f, 1.0f, 1.0f});
-		light.transform.rotation = glm::quat({0.7f, 0.0f, -1.0f});
-		gameObjects.emplace(light.getId(), std::move(light));
-	};
-
-	auto cerberusSceneSetup = [&]() {
-		std::shared_ptr model = Model::CreateModelFromFile(device, RES_DIR "models/Cerberus/Cerberus_LP.FBX");
-
-		auto materialId		= materialSystem->CreateMaterial();
-		auto& mat			= materialSystem->Get(materialId);
-		mat.textures.albedo = Texture::Builder(device)
-								  .addLayer(FileTextureSource(RES_DIR "models/Cerberus/Textures/Cerberus_A.tga"))
-								  .build();
-		mat.textures.arm = Texture::Builder(device)
-							   .addLayer(FileTextureSource(RES_DIR "models/Cerberus/Textures/Cerberus_ORM.tga"))
-							   .format(VK_FORMAT_R8G8B8A8_UNORM)
-							   .build();
-		mat.textures.normal = Texture::Builder(device)
-								  .addLayer(FileTextureSource(RES_DIR "models/Cerberus/Textures/Cerberus_N.tga"))
-								  .format(VK_FORMAT_R8G8B8A8_UNORM)
-								  .build();
-
-		auto object					 = GameObject::Create();
-		object.model				 = model;
-		object.transform.translation = {0.0f, 0.0f, 0.0f};
-		object.transform.scale		 = glm::vec3 {0.01f};
-		object.transform.rotation	 = glm::quat(glm::radians(glm::vec3 {-90.0f, 90.0f, 0.0f}));
-		object.materialId			 = materialId;
-		gameObjects.emplace(object.getId(), std::move(object));
-	};
-
 	skyboxCubemap = std::make_shared<Cubemap>(device);
 	// skyboxCubemap->CreateFromHdri(RES_DIR "hdri/bush_restaurant_2k.hdr", 512);
 	skyboxCubemap->CreateFromHdri(RES_DIR "hdri/clarens_midday_2k.hdr", 512);
+	device.GetAsyncCompute().Update();
 
-	// vaseSceneSetup();
-	// sphereSceneSetup();
-	cerberusSceneSetup();
+	SceneContext context {device, *materialSystem, registry};
+	Scenes::Load(sceneName, context);
 }
 
-void Render3DModule::GenerateBrdfLut(uint32_t resolution)
+void Render3DModule::UpdateEnvironment(int frameIndex)
 {
-	brdfLut = Texture::Builder(device)
-				  .format(VK_FORMAT_R16G16_SFLOAT)
-				  .addressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE)
-				  .addUsageFlag(VK_IMAGE_USAGE_STORAGE_BIT)
-				  .layout(VK_IMAGE_LAYOUT_GENERAL)
-				  .addLayer(SolidTextureSource(glm::vec4 {}, resolution, resolution))
-				  .build();
-
-	auto descriptorPool =
-		DescriptorPool::Builder(device).SetMaxSets(1).AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1).Build();
+	for (size_t i = 0; i < retiredSkyboxes.size();) {
+		if (--retiredSkyboxes[i].second > 0) {
+			i++;
+			continue;
+		}
+		retiredSkyboxes[i] = std::move(retiredSkyboxes.back());
+		retiredSkyboxes.pop_back();
+	}
 
-	auto setLayout = DescriptorSetLayout::Builder(device)
-						 .AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
-						 .Build();
+	if (pendingSkybox && environmentLoading.IsDone() && pendingSkybox->IsReady()) {
+		// The frames in flight still draw with the old one
+		retiredSkyboxes.push_back({std::move(skyboxCubemap), SwapChain::MAX_FRAMES_IN_FLIGHT + 1});
+		skyboxCubemap = std::move(pendingSkybox);
+	}
 
-	auto brdfLutInfo = brdfLut->ImageInfo();
+	// The frame's last use of its set is done once BeginFrame returned
+	if (setSkyboxes[frameIndex] != skyboxCubemap.get()) {
+		auto skyboxImageInfo	 = skyboxCubemap->ImageInfo();
+		auto irradianceImageInfo = skyboxCubemap->IrradianceImageInfo();
+		DescriptorWriter(*globalSetLayout, *globalPool)
+			.WriteImage(1, &skyboxImageInfo)
+			.WriteImage(2, &irradianceImageInfo)
+			.Overwrite(globalDescriptorSets[frameIndex]);
+		setSkyboxes[frameIndex] = skyboxCubemap.get();
+	}
+}
 
-	VkDescriptorSet set;
-	DescriptorWriter(*setLayout, *descriptorPool).WriteImage(0, &brdfLutInfo).Build(set);
+void Render3DModule::GenerateBrdfLut(uint32_t resolution)
+{
+	std::shared_ptr<DescriptorSetLayout> setLayout =
+		DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+			.Build();
 
-	// create pipeline
-	std::unique_ptr<ComputePipeline> pipeline;
+	// create pipeline, it compiles on a worker while the LUT is created
+	auto pipeline = std::make_shared<AsyncPipeline<ComputePipeline>>();
 	VkPipelineLayout pipelineLayout;
 
 	std::vector<VkDescriptorSetLayout> descripotorSetLayouts {setLayout->GetDescriptorSetLayout()};
@@ -301,19 +264,43 @@ void Render3DModule::GenerateBrdfLut(uint32_t resolution)
 
 	vkCreatePipelineLayout(device.VulkanDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
 
-	pipeline = std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "brdfLutGenerator.comp.spv", pipelineLayout);
+	pipeline->Compile([&device = device, pipelineLayout] {
+		return std::make_unique<ComputePipeline>(device, SHADER_BINARY_DIR "brdfLutGenerator.comp.spv", pipelineLayout);
+	});
+
+	brdfLut = Texture::Builder(device)
+				  .format(VK_FORMAT_R16G16_SFLOAT)
+				  .addressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE)
+				  .addUsageFlag(VK_IMAGE_USAGE_STORAGE_BIT)
+				  .layout(VK_IMAGE_LAYOUT_GENERAL)
+				  .addLayer(SolidTextureSource(glm::vec4 {}, resolution, resolution))
+				  .build();
+
+	std::shared_ptr<DescriptorPool> descriptorPool =
+		DescriptorPool::Builder(device).SetMaxSets(1).AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1).Build();
+
+	std::vector<AsyncCompute::TextureUse> textures {{brdfLut.get(), VK_IMAGE_LAYOUT_GENERAL}};
+	brdfLutTicket = device.GetAsyncCompute().Submit(
+		"Render3DModule::GenerateBrdfLut", textures, [&](AsyncCompute::Job& job) {
+			auto brdfLutInfo = brdfLut->ImageInfo();
 
-	// render
-	auto commandBuffer = device.BeginSingleTimeCommands();
+			VkDescriptorSet set;
+			DescriptorWriter(*setLayout, *descriptorPool).WriteImage(0, &brdfLutInfo).Build(set);
 
-	pipeline->Bind(commandBuffer);
+			// render
+			auto commandBuffer = job.commandBuffer;
+			pipeline->Get().Bind(commandBuffer);
 
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0,
+									nullptr);
 
-	const glm::ivec3 shaderLocalSize {32, 32, 1};
-	vkCmdDispatch(commandBuffer, brdfLut->width() / shaderLocalSize.x, brdfLut->width() / shaderLocalSize.y, 1);
+			const glm::ivec3 shaderLocalSize {32, 32, 1};
+			vkCmdDispatch(commandBuffer, brdfLut->width() / shaderLocalSize.x, brdfLut->width() / shaderLocalSize.y,
+						  1);
 
-	device.EndSingleTimeCommands(commandBuffer);
-	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+			job.OnComplete([&device = device, pipelineLayout, setLayout, descriptorPool, pipeline] {
+				vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
+			});
+		});
 }
 } // namespace MVE
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
 
+#include "ClusteredLighting.h"
 #include "Descriptors.h"
 #include "Device.h"
 #include "MaterialSystem.h"
 #include "Renderer.h"
+#include "Scenes.h"
 #include "moduels/Module.h"
 #include "renderSystems/PbrRenderSystem.h"
 #include "renderSystems/PointLightSystem.h"
@@ -11,6 +13,10 @@
 
 #include "core/Application.h"
 #include "core/GameObject.h"
+#include "core/JobSystem.h"
+#include "core/SpatialIndex.h"
+
+#include <array>
 
 namespace MVE
 {
@@ -18,7 +24,11 @@ namespace MVE
 class Render3DModule : public Module
 {
   public:
-	Render3DModule()  = default;
+	// cpuCulling culls on the CPU even when the device could do it on the GPU
+	Render3DModule(const std::string& sceneName = "cerberus", bool cpuCulling = false):
+		sceneName(sceneName), cpuCulling(cpuCulling)
+	{
+	}
 	~Render3DModule() = default;
 
 	Render3DModule(const Render3DModule&) = delete;
@@ -27,28 +37,52 @@ class Render3DModule : public Module
 	void OnAttach() override;
 	void OnDetach() override;
 	void OnUpdate(Timestep dt) override;
+	const char* GetName() const override { return "Render3DModule"; }
+
+	Device& GetDevice() { return device; }
+	Renderer& GetRenderer() { return renderer; }
+	const RenderStats& GetFrameStats() const { return frameStats; }
+	const SpatialIndex& GetSpatialIndex() const { return spatialIndex; }
+	bool CullsOnGpu() const { return pbrRenderSystem->CullsOnGpu(); }
+
+	// Loads the HDRI and generates its maps in the background, the skybox changes once they are ready
+	void SetEnvironment(const std::string& hdriPath);
 
   private:
 	void LoadGameObjects();
 	void GenerateBrdfLut(uint32_t resolution = 512);
+	// Swaps in a loaded environment and points the frame's descriptor set at the current one
+	void UpdateEnvironment(int frameIndex);
 
   private:
+	std::string sceneName;
+	bool cpuCulling;
 	Device device {Application::Get()->GetWindow()};
 	Renderer renderer {device};
 
 	std::unique_ptr<DescriptorPool> globalPool;
 	std::unique_ptr<DescriptorSetLayout> globalSetLayout;
 	std::vector<VkDescriptorSet> globalDescriptorSets;
-	GameObject::Map gameObjects;
+	Registry registry;
+	SpatialIndex spatialIndex;
 	std::shared_ptr<Texture> brdfLut;
+	AsyncCompute::Ticket brdfLutTicket = 0;
 
 	std::vector<std::unique_ptr<Buffer>> globalUboBuffers;
 	std::unique_ptr<MaterialSystem> materialSystem;
+	std::unique_ptr<ClusteredLighting> clusteredLighting;
 	std::shared_ptr<Cubemap> skyboxCubemap;
+	std::shared_ptr<Cubemap> pendingSkybox; // Loaded by SetEnvironment, replaces skyboxCubemap once it is ready
+	JobCounter environmentLoading;
+	std::vector<std::pair<std::shared_ptr<Cubemap>, uint32_t>> retiredSkyboxes; // And the frames they are kept
+	std::array<const Cubemap*, SwapChain::MAX_FRAMES_IN_FLIGHT> setSkyboxes {}; // What each global set points to
 
 	std::unique_ptr<PbrRenderSystem> pbrRenderSystem;
 	std::unique_ptr<PointLightSystem> pointLightSystem;
 	std::unique_ptr<SkyboxSystem> skyboxSystem;
+	std::vector<VkCommandBuffer> secondaryCommandBuffers; // Executed in the swap chain render pass, reused every frame
 	Camera camera {};
+	RenderStats frameStats;
+	bool pipelineCacheSaved = false;
 };
 } // namespace MVE
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "RenderQueue.h"
+
+#include <cstring>
+
+namespace MVE
+{
+
+constexpr uint32_t RADIX_BITS	= 8;
+constexpr uint32_t RADIX_SIZE	= 1 << RADIX_BITS;
+constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+uint64_t RenderQueue::MakeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+	// Positive floats sort like their bit patterns, so the top bits of the pattern are a logarithmic quantization
+	uint32_t depthBits = 0;
+	if (depth > 0.0f) {
+		std::memcpy(&depthBits, &depth, sizeof(depth));
+		depthBits >>= 32 - DEPTH_BITS;
+	}
+
+	auto field = [](uint64_t value, uint32_t bits) { return value & ((uint64_t(1) << bits) - 1); };
+	return field(pipeline, PIPELINE_BITS) << (MATERIAL_BITS + MESH_BITS + DEPTH_BITS) |
+		   field(material, MATERIAL_BITS) << (MESH_BITS + DEPTH_BITS) | field(mesh, MESH_BITS) << DEPTH_BITS |
+		   depthBits;
+}
+
+void RenderQueue::Sort()
+{
+	MVE_PROFILE_FUNCTION();
+	if (items.size() < 2)
+		return;
+
+	// Histograms of every digit in one pass over the keys
+	std::array<std::array<uint32_t, RADIX_SIZE>, RADIX_PASSES> counts {};
+	for (auto& item : items) {
+		for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+			counts[pass][(item.key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+		}
+	}
+
+	scratch.resize(items.size());
+	for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+		uint32_t shift = pass * RADIX_BITS;
+		auto& offsets  = counts[pass];
+
+		// Every key has the same digit, this pass wouldn't move anything
+		if (offsets[(items[0].key >> shift) & (RADIX_SIZE - 1)] == items.size())
+			continue;
+
+		uint32_t offset = 0;
+		for (auto& count : offsets) {
+			uint32_t bucketSize = count;
+			count				= offset;
+			offset += bucketSize;
+		}
+
+		for (auto& item : items) { scratch[offsets[(item.key >> shift) & (RADIX_SIZE - 1)]++] = item; }
+		items.swap(scratch);
+	}
+}
+
+} // namespace MVE
\ No newline at end of file
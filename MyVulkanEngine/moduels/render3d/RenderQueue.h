@@ -0,0 +1,44 @@
+#pragma once
+
+namespace MVE
+{
+
+/// The draws of one frame, ordered by a 64-bit key so that state only has to change where the key does. From the
+/// most significant bits the key holds the pipeline, material, mesh and view depth, so every material is bound once,
+/// every mesh once per material, and the instances of a mesh are drawn front to back.
+class RenderQueue
+{
+  public:
+	static constexpr uint32_t PIPELINE_BITS = 4;
+	static constexpr uint32_t MATERIAL_BITS = 20; // Slot index of the MaterialId, unique among live materials
+	static constexpr uint32_t MESH_BITS		= 16;
+	static constexpr uint32_t DEPTH_BITS	= 24;
+	static_assert(PIPELINE_BITS + MATERIAL_BITS + MESH_BITS + DEPTH_BITS == 64);
+
+	struct Item
+	{
+		uint64_t key;
+		uint32_t index; // Into the caller's draw data
+	};
+
+  public:
+	// Ids are truncated to their bits, so two meshes may share a key prefix. Draws must still compare the real mesh
+	// and material before merging. Depth is the view space distance, negative values count as 0.
+	static uint64_t MakeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+	// Key without the depth, equal for draws that can be merged into one instanced call
+	static uint64_t StateBits(uint64_t key) { return key >> DEPTH_BITS; }
+
+	void Clear() { items.clear(); }
+	void Push(uint64_t key, uint32_t index) { items.push_back({key, index}); }
+	// Stable LSD radix sort over 8-bit digits, digits all keys share are skipped
+	void Sort();
+
+	const std::vector<Item>& Items() const { return items; }
+	size_t Size() const { return items.size(); }
+
+  private:
+	std::vector<Item> items;
+	std::vector<Item> scratch;
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+namespace MVE
+{
+
+/// Something the renderer can draw a frame into: the window swap chain, or an offscreen image when running headless.
+class RenderTarget
+{
+  public:
+	static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+
+	RenderTarget()			= default;
+	virtual ~RenderTarget() = default;
+
+	RenderTarget(const RenderTarget&)	= delete;
+	void operator=(const RenderTarget&) = delete;
+
+	virtual VkFramebuffer GetFrameBuffer(int index) = 0;
+	virtual VkRenderPass GetRenderPass()			= 0;
+	virtual size_t ImageCount()						= 0;
+	virtual VkFormat GetImageFormat()				= 0;
+	virtual VkFormat GetDepthFormat()				= 0;
+	virtual VkExtent2D GetExtent()					= 0;
+
+	virtual VkResult AcquireNextImage(uint32_t* imageIndex)								= 0;
+	virtual VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) = 0;
+
+	uint32_t Width() { return GetExtent().width; }
+	uint32_t Height() { return GetExtent().height; }
+
+	float ExtentAspectRatio()
+	{
+		auto extent = GetExtent();
+		return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+	}
+
+	bool CompareFormats(RenderTarget& other)
+	{
+		return GetImageFormat() == other.GetImageFormat() && GetDepthFormat() == other.GetDepthFormat();
+	}
+};
+
+} // namespace MVE
\ No newline at end of file
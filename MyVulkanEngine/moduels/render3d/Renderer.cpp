@@ -1,27 +1,32 @@
 #include "Renderer.h"
 
+#include "UploadManager.h"
+
 namespace MVE
 {
 
-Renderer::Renderer(Device& device): device(device)
+Renderer::Renderer(Device& device): device(device), gpuProfiler(device)
 {
 	// Figue out what to do about deleting the event callback
 	Application::Get()->GetWindow().ResizeEvent += new MemFuncEventCallback(this, &Renderer::OnWindowResize);
 
 	RecreateSwapChain();
 	CreateCommandBuffers();
+	CreateThreadCommandPools();
 }
 
 Renderer::~Renderer()
 {
+	DestroyThreadCommandPools();
 	FreeCommandBuffers();
 }
 
 VkCommandBuffer Renderer::BeginFrame()
 {
-	assert(!isFrameStarted, "Frame already in progress");
+	MVE_PROFILE_SCOPE("Renderer::BeginFrame");
+	MVE_ASSERT(!isFrameStarted, "Frame already in progress");
 
-	auto result = swapChain->AcquireNextImage(&currentImageIndex);
+	auto result = renderTarget->AcquireNextImage(&currentImageIndex);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 		RecreateSwapChain();
@@ -32,23 +37,35 @@ VkCommandBuffer Renderer::BeginFrame()
 
 	isFrameStarted = true;
 
+	// AcquireNextImage waited for the frame's fence, so none of its secondary command buffers are pending anymore
+	for (auto& thread : threadCommands[currentFrameIndex]) {
+		vkResetCommandPool(device.VulkanDevice(), thread.pool, 0);
+		thread.usedBuffers = 0;
+	}
+
 	auto commandBuffer = GetCurrentCommandBuffer();
 	VkCommandBufferBeginInfo beginInfo {};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
 	MVE_ASSERT(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS,
 			   "Failed to begin recording command buffer");
+
+	gpuProfiler.BeginFrame(commandBuffer, currentFrameIndex);
 	return commandBuffer;
 }
 
 void Renderer::EndFrame()
 {
-	assert(isFrameStarted, "Frame is not in progress");
+	MVE_PROFILE_SCOPE("Renderer::EndFrame");
+	MVE_ASSERT(isFrameStarted, "Frame is not in progress");
 
 	auto commandBuffer = GetCurrentCommandBuffer();
+	gpuProfiler.EndFrame(commandBuffer);
 	MVE_ASSERT(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS, "Failed to end recording command buffer");
 
-	auto result = swapChain->SubmitCommandBuffers(&commandBuffer, &currentImageIndex);
+	// Ahead of the frame, which may already draw with what was uploaded while recording it
+	device.GetUploadManager().Submit();
+	auto result = renderTarget->SubmitCommandBuffers(&commandBuffer, &currentImageIndex);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || wasResized) {
 		wasResized = false;
@@ -58,22 +75,22 @@ void Renderer::EndFrame()
 	}
 
 	isFrameStarted	  = false;
-	currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+	currentFrameIndex = (currentFrameIndex + 1) % RenderTarget::MAX_FRAMES_IN_FLIGHT;
 }
 
-void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
 {
-	assert(isFrameStarted, "Frame is not in progress. Cant begin swap chain render pass");
-	assert(commandBuffer == GetCurrentCommandBuffer(),
-		   "get begin swap chain render pass on a command buffer from a diffrent frame.");
+	MVE_ASSERT(isFrameStarted, "Frame is not in progress. Cant begin swap chain render pass");
+	MVE_ASSERT(commandBuffer == GetCurrentCommandBuffer(),
+			   "get begin swap chain render pass on a command buffer from a diffrent frame.");
 
 	VkRenderPassBeginInfo renderPassInfo {};
 	renderPassInfo.sType	   = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass  = swapChain->GetRenderPass();
-	renderPassInfo.framebuffer = swapChain->GetFrameBuffer(currentImageIndex);
+	renderPassInfo.renderPass  = renderTarget->GetRenderPass();
+	renderPassInfo.framebuffer = renderTarget->GetFrameBuffer(currentImageIndex);
 
 	renderPassInfo.renderArea.offset = {0, 0};
-	renderPassInfo.renderArea.extent = swapChain->GetSwapChainExtent();
+	renderPassInfo.renderArea.extent = renderTarget->GetExtent();
 
 	std::array<VkClearValue, 2> clearValues {};
 	clearValues[0].color		   = {0.1f, 0.1f, 0.1f, 1.0f};
@@ -81,34 +98,88 @@ void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer)
 	renderPassInfo.clearValueCount = clearValues.size();
 	renderPassInfo.pClearValues	   = clearValues.data();
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+	// The primary command buffer may only execute secondaries in the pass, they set their own viewport and scissor
+	if (contents == VK_SUBPASS_CONTENTS_INLINE)
+		SetViewportAndScissor(commandBuffer);
+}
+
+void Renderer::EndSwapChainRenderPass(VkCommandBuffer commandBuffer)
+{
+	MVE_ASSERT(isFrameStarted, "Frame is not in progress. Cant begin swap chain render pass");
+	MVE_ASSERT(commandBuffer == GetCurrentCommandBuffer(),
+			   "get begin swap chain render pass on a command buffer from a diffrent frame.");
+
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+VkCommandBuffer Renderer::BeginSecondaryCommandBuffer()
+{
+	MVE_ASSERT(isFrameStarted, "Frame is not in progress. Cant begin a secondary command buffer");
+
+	uint32_t threadIndex = JobSystem::ThreadIndex();
+	MVE_ASSERT(threadIndex < threadCommands[currentFrameIndex].size(),
+			   "Secondary command buffers can only be recorded on job system threads");
+
+	auto& thread = threadCommands[currentFrameIndex][threadIndex];
+	if (thread.usedBuffers == thread.buffers.size()) {
+		VkCommandBufferAllocateInfo allocInfo {};
+		allocInfo.sType				 = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level				 = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandPool		 = thread.pool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		auto error = vkAllocateCommandBuffers(device.VulkanDevice(), &allocInfo, &commandBuffer);
+		MVE_ASSERT(error == VK_SUCCESS, "Failed to allocate secondary command buffer");
+		thread.buffers.push_back(commandBuffer);
+	}
+	auto commandBuffer = thread.buffers[thread.usedBuffers++];
+
+	VkCommandBufferInheritanceInfo inheritanceInfo {};
+	inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass	= renderTarget->GetRenderPass();
+	inheritanceInfo.subpass		= 0;
+	inheritanceInfo.framebuffer = renderTarget->GetFrameBuffer(currentImageIndex);
+
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType			   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags			   = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	MVE_ASSERT(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS,
+			   "Failed to begin recording secondary command buffer");
+
+	// Dynamic state isn't inherited from the primary command buffer
+	SetViewportAndScissor(commandBuffer);
+	return commandBuffer;
+}
+
+void Renderer::EndSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+{
+	MVE_ASSERT(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS, "Failed to end recording secondary command buffer");
+}
 
+void Renderer::SetViewportAndScissor(VkCommandBuffer commandBuffer)
+{
 	VkViewport viewport {};
 	viewport.x		  = 0;
 	viewport.y		  = 0;
-	viewport.width	  = swapChain->GetSwapChainExtent().width;
-	viewport.height	  = swapChain->GetSwapChainExtent().height;
+	viewport.width	  = renderTarget->GetExtent().width;
+	viewport.height	  = renderTarget->GetExtent().height;
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 
-	VkRect2D scissor {{0, 0}, swapChain->GetSwapChainExtent()};
+	VkRect2D scissor {{0, 0}, renderTarget->GetExtent()};
 
 	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 }
 
-void Renderer::EndSwapChainRenderPass(VkCommandBuffer commandBuffer)
-{
-	assert(isFrameStarted, "Frame is not in progress. Cant begin swap chain render pass");
-	assert(commandBuffer == GetCurrentCommandBuffer(),
-		   "get begin swap chain render pass on a command buffer from a diffrent frame.");
-
-	vkCmdEndRenderPass(commandBuffer);
-}
-
 void Renderer::CreateCommandBuffers()
 {
-	commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+	commandBuffers.resize(RenderTarget::MAX_FRAMES_IN_FLIGHT);
 
 	VkCommandBufferAllocateInfo allocInfo {};
 	allocInfo.sType				 = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -128,22 +199,57 @@ void Renderer::FreeCommandBuffers()
 	commandBuffers.clear();
 }
 
+void Renderer::CreateThreadCommandPools()
+{
+	VkCommandPoolCreateInfo poolInfo {};
+	poolInfo.sType			  = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = device.FindPhysicalQueueFamilies().graphicsFamily;
+	poolInfo.flags			  = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	for (auto& frameCommands : threadCommands) {
+		frameCommands.resize(JobSystem::ThreadCount());
+		for (auto& thread : frameCommands) {
+			auto error = vkCreateCommandPool(device.VulkanDevice(), &poolInfo, nullptr, &thread.pool);
+			MVE_ASSERT(error == VK_SUCCESS, "Failed to create thread command pool");
+		}
+	}
+}
+
+void Renderer::DestroyThreadCommandPools()
+{
+	vkDeviceWaitIdle(device.VulkanDevice());
+
+	// Destroying a pool frees its command buffers
+	for (auto& frameCommands : threadCommands) {
+		for (auto& thread : frameCommands) { vkDestroyCommandPool(device.VulkanDevice(), thread.pool, nullptr); }
+		frameCommands.clear();
+	}
+}
+
 void Renderer::RecreateSwapChain()
 {
 	auto extent = GetWindowExtent(Application::Get()->GetWindow());
+
+	if (device.IsHeadless()) {
+		// Offscreen images never go out of date, so they are only created once
+		if (renderTarget == nullptr)
+			renderTarget = std::make_unique<OffscreenTarget>(device, extent);
+		return;
+	}
+
 	while (extent.width == 0 || extent.height == 0) {
 		extent = GetWindowExtent(Application::Get()->GetWindow());
 		glfwWaitEvents();
 	}
 	vkDeviceWaitIdle(device.VulkanDevice());
 
-	if (swapChain == nullptr) {
-		swapChain = std::make_unique<SwapChain>(device, extent, std::move(swapChain));
+	if (renderTarget == nullptr) {
+		renderTarget = std::make_unique<SwapChain>(device, extent);
 	} else {
-		std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
-		swapChain								= std::make_unique<SwapChain>(device, extent, oldSwapChain);
+		std::shared_ptr<SwapChain> oldSwapChain(static_cast<SwapChain*>(renderTarget.release()));
+		renderTarget = std::make_unique<SwapChain>(device, extent, oldSwapChain);
 
-		if (!oldSwapChain->CompareSwapFormats(*swapChain)) {
+		if (!oldSwapChain->CompareFormats(*renderTarget)) {
 			MVE_ERROR("Swap chain image format has changed");
 		}
 	}
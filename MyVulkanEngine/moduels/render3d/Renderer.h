@@ -2,6 +2,8 @@
 #include <vulkan/vulkan.h>
 
 #include "Device.h"
+#include "GpuProfiler.h"
+#include "OffscreenTarget.h"
 #include "SwapChain.h"
 #include "core/Application.h"
 #include "moduels/Module.h"
@@ -23,9 +25,11 @@ class Renderer
 	Renderer(const Renderer&)		= delete;
 	void operator=(const Renderer&) = delete;
 
-	VkRenderPass GetSwapChainRenderPass() const { return swapChain->GetRenderPass(); }
-	float GetAspectRatio() const { return swapChain->ExtentAspectRatio(); }
+	VkRenderPass GetSwapChainRenderPass() const { return renderTarget->GetRenderPass(); }
+	float GetAspectRatio() const { return renderTarget->ExtentAspectRatio(); }
+	VkExtent2D GetExtent() const { return renderTarget->GetExtent(); }
 	bool IsFrameInProgress() const { return isFrameStarted; }
+	GpuProfiler& GetGpuProfiler() { return gpuProfiler; }
 
 	VkCommandBuffer GetCurrentCommandBuffer() const
 	{
@@ -40,23 +44,46 @@ class Renderer
 
 	VkCommandBuffer BeginFrame();
 	void EndFrame();
-	void BeginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+	// With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS everything inside the pass has to be recorded into command
+	// buffers from BeginSecondaryCommandBuffer, which the primary command buffer then executes
+	void BeginSwapChainRenderPass(VkCommandBuffer commandBuffer,
+								  VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 	void EndSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+	// A secondary command buffer that continues the swap chain render pass, with the viewport and scissor already
+	// set. Can be called from any job system thread, each thread records from its own command pool. The buffer is
+	// only valid for the current frame and must be ended with EndSecondaryCommandBuffer.
+	VkCommandBuffer BeginSecondaryCommandBuffer();
+	void EndSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+
   private:
+	// A command pool per job system thread and frame in flight. The whole pool is reset once the frame's fence was
+	// waited on, instead of resetting every buffer.
+	struct ThreadCommands
+	{
+		VkCommandPool pool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> buffers;
+		uint32_t usedBuffers = 0;
+	};
+
 	void CreateCommandBuffers();
 	void FreeCommandBuffers();
+	void CreateThreadCommandPools();
+	void DestroyThreadCommandPools();
+	void SetViewportAndScissor(VkCommandBuffer commandBuffer);
 	void RecreateSwapChain();
 
 	void OnWindowResize(int width, int height);
 
   private:
 	Device& device;
-	std::unique_ptr<SwapChain> swapChain;
+	GpuProfiler gpuProfiler;
+	std::unique_ptr<RenderTarget> renderTarget;
 	std::vector<VkCommandBuffer> commandBuffers;
+	std::array<std::vector<ThreadCommands>, RenderTarget::MAX_FRAMES_IN_FLIGHT> threadCommands;
 
 	uint32_t currentImageIndex;
-	int currentFrameIndex;
+	int currentFrameIndex = 0;
 	bool isFrameStarted = false;
 
 	bool wasResized = false;
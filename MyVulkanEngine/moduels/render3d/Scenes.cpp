@@ -0,0 +1,210 @@
+#include "Scenes.h"
+
+#include "StressSceneGenerator.h"
+
+namespace MVE
+{
+
+static void LoadVaseScene(SceneContext& context)
+{
+	auto& device		 = context.device;
+	auto& materialSystem = context.materialSystem;
+	auto& registry		 = context.registry;
+
+	std::shared_ptr model = Model::CreateModelFromFile(device, RES_DIR "models/smooth_vase.obj");
+
+	// Materials
+	auto redMatId			= materialSystem.CreateMaterial();
+	auto& redMat			= materialSystem.Get(redMatId);
+	redMat.params.albedo	= glm::vec4(0.9f, 0.2f, 0.2f, 1.0f);
+	redMat.params.roughness = 0.85f;
+	redMat.params.metallic	= 0.0f;
+
+	auto goldMatId			 = materialSystem.CreateMaterial();
+	auto& goldMat			 = materialSystem.Get(goldMatId);
+	goldMat.params.albedo	 = glm::vec4(0.944f, 0.776f, 0.373f, 1.0f);
+	goldMat.params.roughness = 0.3f;
+	goldMat.params.metallic	 = 1.0f;
+
+	auto floorMatId			 = materialSystem.CreateMaterial();
+	auto& floorMat			 = materialSystem.Get(floorMatId);
+	floorMat.params.uvScale	 = glm::vec2 {5.0f};
+	floorMat.textures.albedo = Texture::Builder(device)
+								   .addLayer(FileTextureSource(RES_DIR "textures/floor/slate_floor_diff_2k.jpg"))
+								   .relocatable(true)
+								   .build();
+	floorMat.textures.arm = Texture::Builder(device)
+								.addLayer(FileTextureSource(RES_DIR "textures/floor/slate_floor_arm_2k.jpg"))
+								.format(VK_FORMAT_R8G8B8A8_UNORM)
+								.relocatable(true)
+								.build();
+	floorMat.textures.normal = Texture::Builder(device)
+								   .addLayer(FileTextureSource(RES_DIR "textures/floor/slate_floor_nor_gl_2k.jpg"))
+								   .format(VK_FORMAT_R8G8B8A8_UNORM)
+								   .relocatable(true)
+								   .build();
+
+	// Objects
+	auto object = GameObject::Create(registry);
+	object.Add<MeshRendererComponent>(model);
+	object.Add<MaterialComponent>(redMatId);
+	object.Transform().SetTranslation({0.5f, 0.0f, 0.0f});
+	object.Transform().SetScale(glm::vec3 {3.0f});
+
+	object = GameObject::Create(registry);
+	object.Add<MeshRendererComponent>(model);
+	object.Add<MaterialComponent>(goldMatId);
+	object.Transform().SetTranslation({-0.5f, 0.0f, 0.0f});
+	object.Transform().SetScale(glm::vec3 {1.0f, 0.3f, 0.5f} * 3.0f);
+
+	std::shared_ptr floor = Model::CreateModelFromFile(device, RES_DIR "models/quad.obj");
+
+	object = GameObject::Create(registry);
+	object.Add<MeshRendererComponent>(floor);
+	object.Add<MaterialComponent>(floorMatId);
+	object.Transform().SetTranslation({0.0f, 0.0f, 0.0f});
+	object.Transform().SetScale(glm::vec3 {5.0f});
+
+	// Lights
+
+	object = GameObject::CreatePointLight(registry, 0.5f, 0.1f, {0.5f, 0.1f, 0.1f});
+	object.Transform().SetTranslation({-1.0f, -1.0f, -1.0f});
+
+	object = GameObject::CreatePointLight(registry, 1.0f, 0.2f, {0.1f, 0.1f, 0.5f});
+	object.Transform().SetTranslation({1.0f, -1.0f, -1.0f});
+
+	object = GameObject::CreatePointLight(registry, 0.7f, 0.15f, {1.0f, 1.0f, 1.0f});
+	object.Transform().SetTranslation({0.0f, -0.5f, 0.0f});
+
+	object = GameObject::CreateDirectionalLight(registry, 1.5f, {1.0f, 1.0f, 1.0f});
+	object.Transform().SetRotation(glm::quat({0.7f, 0.0f, -1.5f}));
+}
+
+static void LoadSpheresScene(SceneContext& context)
+{
+	auto& device		 = context.device;
+	auto& materialSystem = context.materialSystem;
+	auto& registry		 = context.registry;
+
+	std::shared_ptr sphere = Model::CreateModelFromFile(device, RES_DIR "models/sphere.obj");
+	int n				   = 6;
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) {
+			auto matId			 = materialSystem.CreateMaterial();
+			auto& mat			 = materialSystem.Get(matId);
+			mat.params.albedo	 = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+			mat.params.roughness = float(i) / (n - 1);
+			mat.params.metallic	 = float(j) / (n - 1);
+
+			auto object = GameObject::Create(registry);
+			object.Add<MeshRendererComponent>(sphere);
+			object.Add<MaterialComponent>(matId);
+			object.Transform().SetTranslation(glm::vec3 {i - (n - 1) / 2.0f, j - (n - 1) / 2.0f, 0.0f});
+			object.Transform().SetScale(glm::vec3 {0.15f});
+		}
+	}
+
+	// Lights
+	auto light = GameObject::CreateDirectionalLight(registry, 1.5f, {1.0f, 1.0f, 1.0f});
+	light.Transform().SetRotation(glm::quat({0.7f, 0.0f, -1.0f}));
+}
+
+static void LoadCerberusScene(SceneContext& context)
+{
+	auto& device		 = context.device;
+	auto& materialSystem = context.materialSystem;
+	auto& registry		 = context.registry;
+
+	std::shared_ptr model = Model::CreateModelFromFile(device, RES_DIR "models/Cerberus/Cerberus_LP.FBX");
+
+	auto materialId		= materialSystem.CreateMaterial();
+	auto& mat			= materialSystem.Get(materialId);
+	mat.textures.albedo = Texture::Builder(device)
+							  .addLayer(FileTextureSource(RES_DIR "models/Cerberus/Textures/Cerberus_A.tga"))
+							  .relocatable(true)
+							  .build();
+	mat.textures.arm = Texture::Builder(device)
+						   .addLayer(FileTextureSource(RES_DIR "models/Cerberus/Textures/Cerberus_ORM.tga"))
+						   .format(VK_FORMAT_R8G8B8A8_UNORM)
+						   .relocatable(true)
+						   .build();
+	mat.textures.normal = Texture::Builder(device)
+							  .addLayer(FileTextureSource(RES_DIR "models/Cerberus/Textures/Cerberus_N.tga"))
+							  .format(VK_FORMAT_R8G8B8A8_UNORM)
+							  .relocatable(true)
+							  .build();
+
+	auto object = GameObject::Create(registry);
+	object.Add<MeshRendererComponent>(model);
+	object.Add<MaterialComponent>(materialId);
+	object.Transform().SetTranslation({0.0f, 0.0f, 0.0f});
+	object.Transform().SetScale(glm::vec3 {0.01f});
+	object.Transform().SetRotation(glm::quat(glm::radians(glm::vec3 {-90.0f, 90.0f, 0.0f})));
+}
+
+static Scenes::LoadFunction StressScene(uint32_t objectCount)
+{
+	return [objectCount](SceneContext& context) {
+		StressSceneSettings settings;
+		settings.objectCount = objectCount;
+		StressSceneGenerator::Generate(context, settings);
+	};
+}
+
+std::map<std::string, Scenes::LoadFunction>& Scenes::Registry()
+{
+	static std::map<std::string, LoadFunction> registry {
+		{"vase", LoadVaseScene},
+		{"spheres", LoadSpheresScene},
+		{"cerberus", LoadCerberusScene},
+		{"stress1k", StressScene(1000)},
+		{"stress10k", StressScene(10000)},
+		{"stress100k", StressScene(100000)},
+	};
+	return registry;
+}
+
+static const std::string STRESS_PREFIX = "stress:";
+
+static bool IsStressScene(const std::string& name)
+{
+	return name.rfind(STRESS_PREFIX, 0) == 0;
+}
+
+bool Scenes::Load(const std::string& name, SceneContext& context)
+{
+	if (IsStressScene(name)) {
+		MVE_PROFILE_SCOPE("Scenes::Load");
+		StressSceneGenerator::Generate(context, StressSceneSettings::Parse(name.substr(STRESS_PREFIX.size())));
+		return true;
+	}
+
+	auto it = Registry().find(name);
+	if (it == Registry().end()) {
+		MVE_ERROR("Unknown scene '{}'", name);
+		return false;
+	}
+
+	MVE_PROFILE_SCOPE("Scenes::Load");
+	it->second(context);
+	return true;
+}
+
+bool Scenes::Exists(const std::string& name)
+{
+	return IsStressScene(name) || Registry().count(name) > 0;
+}
+
+void Scenes::Register(const std::string& name, LoadFunction load)
+{
+	Registry()[name] = std::move(load);
+}
+
+std::vector<std::string> Scenes::Names()
+{
+	std::vector<std::string> names;
+	for (auto& [name, load] : Registry()) { names.push_back(name); }
+	return names;
+}
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Device.h"
+#include "MaterialSystem.h"
+
+#include "core/GameObject.h"
+
+#include <functional>
+
+namespace MVE
+{
+
+struct SceneContext
+{
+	Device& device;
+	MaterialSystem& materialSystem;
+	Registry& registry;
+};
+
+/// Named scenes that can be loaded by the app and the benchmark.
+class Scenes
+{
+  public:
+	using LoadFunction = std::function<void(SceneContext&)>;
+
+	// Besides the registered names, "stress:key=value,..." loads a generated stress scene
+	static bool Load(const std::string& name, SceneContext& context);
+	static bool Exists(const std::string& name);
+	static void Register(const std::string& name, LoadFunction load);
+	static std::vector<std::string> Names();
+
+  private:
+	static std::map<std::string, LoadFunction>& Registry();
+};
+
+} // namespace MVE
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "StressSceneGenerator.h"
+
+#include <random>
+
+namespace MVE
+{
+
+namespace
+{
+const char* STRESS_MODELS[] = {
+	RES_DIR "models/sphere.obj",
+	RES_DIR "models/cube.obj",
+	RES_DIR "models/smooth_vase.obj",
+	RES_DIR "models/flat_vase.obj",
+	RES_DIR "models/colored_cube.obj",
+};
+
+// std::uniform_*_distribution differ between standard libraries, so values are derived from the raw mt19937 output,
+// which is fully specified
+class Random
+{
+  public:
+	Random(uint32_t seed): engine(seed) {}
+
+	float Float() { return (engine() >> 8) * (1.0f / 16777216.0f); }
+	float Range(float min, float max) { return min + (max - min) * Float(); }
+	uint32_t Index(uint32_t count) { return uint32_t(uint64_t(engine()) * count >> 32); }
+	glm::vec3 Color() { return {Float(), Float(), Float()}; }
+
+  private:
+	std::mt19937 engine;
+};
+} // namespace
+
+StressSceneSettings StressSceneSettings::Parse(const std::string& options, StressSceneSettings settings)
+{
+	size_t start = 0;
+	while (start < options.size()) {
+		size_t end = options.find(',', start);
+		if (end == std::string::npos)
+			end = options.size();
+
+		std::string option = options.substr(start, end - start);
+		start			   = end + 1;
+
+		size_t separator = option.find('=');
+		if (separator == std::string::npos) {
+			MVE_WARN("Ignoring stress scene option '{}', expected key=value", option);
+			continue;
+		}
+
+		std::string key	  = option.substr(0, separator);
+		std::string value = option.substr(separator + 1);
+
+		if (key == "spacing") {
+			settings.spacing = std::stof(value);
+			continue;
+		}
+
+		uint32_t* target = nullptr;
+		if (key == "objects")
+			target = &settings.objectCount;
+		else if (key == "models")
+			target = &settings.modelCount;
+		else if (key == "materials")
+			target = &settings.materialCount;
+		else if (key == "textures")
+			target = &settings.textureCount;
+		else if (key == "textureSize")
+			target = &settings.textureSize;
+		else if (key == "pointLights")
+			target = &settings.pointLightCount;
+		else if (key == "directionalLights")
+			target = &settings.directionalLightCount;
+		else if (key == "seed")
+			target = &settings.seed;
+
+		if (target)
+			*target = std::stoul(value);
+		else
+			MVE_WARN("Unknown stress scene option '{}'", key);
+	}
+	return settings;
+}
+
+void StressSceneGenerator::Generate(SceneContext& context, const StressSceneSettings& settings)
+{
+	MVE_PROFILE_SCOPE("StressSceneGenerator::Generate");
+
+	auto& device		 = context.device;
+	auto& materialSystem = context.materialSystem;
+	auto& registry		 = context.registry;
+
+	Random random(settings.seed);
+
+	// Models
+	uint32_t modelCount = std::clamp<uint32_t>(settings.modelCount, 1, std::size(STRESS_MODELS));
+	if (modelCount != settings.modelCount)
+		MVE_WARN("Stress scene supports 1 to {} distinct models, using {}", std::size(STRESS_MODELS), modelCount);
+
+	std::vector<std::shared_ptr<Model>> models;
+	for (uint32_t i = 0; i < modelCount; i++) {
+		models.push_back(Model::CreateModelFromFile(device, STRESS_MODELS[i]));
+	}
+
+	// Textures
+	std::vector<std::shared_ptr<Texture>> textures;
+	for (uint32_t i = 0; i < settings.textureCount; i++) {
+		auto color = glm::vec4(random.Color(), 1.0f);
+		textures.push_back(Texture::Builder(device)
+							   .addLayer(SolidTextureSource(color, settings.textureSize, settings.textureSize))
+							   .relocatable(true)
+							   .build());
+	}
+
+	// Materials
+	std::vector<MaterialId> materials;
+	for (uint32_t i = 0; i < std::max(settings.materialCount, 1u); i++) {
+		auto id				 = materialSystem.CreateMaterial();
+		auto& mat			 = materialSystem.Get(id);
+		mat.params.albedo	 = glm::vec4(random.Color(), 1.0f);
+		mat.params.roughness = random.Range(0.05f, 1.0f);
+		mat.params.metallic	 = random.Float() < 0.3f ? 1.0f : 0.0f;
+		if (!textures.empty())
+			mat.textures.albedo = textures[random.Index(textures.size())];
+		materials.push_back(id);
+	}
+
+	// Objects are spread through a cube that grows with the object count, so density stays the same
+	float halfExtent = 0.5f * settings.spacing * std::cbrt(float(settings.objectCount));
+	for (uint32_t i = 0; i < settings.objectCount; i++) {
+		auto object = GameObject::Create(registry);
+		object.Add<MeshRendererComponent>(models[random.Index(models.size())]);
+		object.Add<MaterialComponent>(materials[random.Index(materials.size())]);
+
+		auto& transform = object.Transform();
+		transform.SetTranslation({random.Range(-halfExtent, halfExtent), random.Range(-halfExtent, halfExtent),
+								  random.Range(-halfExtent, halfExtent)});
+		transform.SetRotation(glm::quat(glm::vec3 {random.Range(0.0f, glm::two_pi<float>()),
+												   random.Range(0.0f, glm::two_pi<float>()),
+												   random.Range(0.0f, glm::two_pi<float>())}));
+		transform.SetScale(glm::vec3 {random.Range(0.2f, 0.5f)});
+	}
+
+	// Lights
+	for (uint32_t i = 0; i < settings.pointLightCount; i++) {
+		// Separate statements, the order function arguments are evaluated in is unspecified
+		float intensity = random.Range(0.5f, 2.0f);
+		glm::vec3 color = random.Color();
+
+		auto light = GameObject::CreatePointLight(registry, intensity, 0.1f, color);
+		light.Transform().SetTranslation({random.Range(-halfExtent, halfExtent), random.Range(-halfExtent, halfExtent),
+										  random.Range(-halfExtent, halfExtent)});
+	}
+
+	for (uint32_t i = 0; i < settings.directionalLightCount; i++) {
+		auto light = GameObject::CreateDirectionalLight(registry, random.Range(0.5f, 1.5f), glm::vec3 {1.0f});
+		light.Transform().SetRotation(
+			glm::quat(glm::vec3 {random.Range(0.2f, 1.2f), 0.0f, random.Range(-glm::pi<float>(), glm::pi<float>())}));
+	}
+
+	MVE_INFO("Generated stress scene: {} objects, {} models, {} materials, {} textures, {} point and {} directional "
+			 "lights (seed {})",
+			 settings.objectCount, models.size(), materials.size(), textures.size(), settings.pointLightCount,
+			 settings.directionalLightCount, settings.seed);
+}
+
+} // namespace MVE
\ No newline at end of file
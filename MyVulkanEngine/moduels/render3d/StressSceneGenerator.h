@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Scenes.h"
+
+namespace MVE
+{
+
+struct StressSceneSettings
+{
+	uint32_t objectCount		   = 1000;
+	uint32_t modelCount			   = 3; // Distinct meshes, picked from the models in res/models
+	uint32_t materialCount		   = 100;
+	uint32_t textureCount		   = 8; // Distinct albedo textures shared by the materials, 0 keeps the defaults
+	uint32_t textureSize		   = 256;
+	uint32_t pointLightCount	   = 8;
+	uint32_t directionalLightCount = 1;
+	uint32_t seed				   = 1337;
+	float spacing				   = 1.5f; // Average distance between neighbouring objects
+
+	// Reads overrides from a "key=value,key=value" list, e.g. "objects=5000,materials=200,seed=7"
+	static StressSceneSettings Parse(const std::string& options, StressSceneSettings settings = {});
+};
+
+/// Fills a scene with a large number of randomly placed objects for scaling tests.
+/// The same settings always produce the same scene, on every platform.
+class StressSceneGenerator
+{
+  public:
+	static void Generate(SceneContext& context, const StressSceneSettings& settings);
+};
+
+} // namespace MVE
\ No newline at end of file
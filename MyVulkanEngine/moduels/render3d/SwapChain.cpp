@@ -29,7 +29,7 @@ SwapChain::~SwapChain()
 	for (int i = 0; i < depthImages.size(); i++) {
 		vkDestroyImageView(device.VulkanDevice(), depthImageViews[i], nullptr);
 		vkDestroyImage(device.VulkanDevice(), depthImages[i], nullptr);
-		vkFreeMemory(device.VulkanDevice(), depthImageMemorys[i], nullptr);
+		device.FreeMemory(depthImageMemorys[i]);
 	}
 
 	for (auto framebuffer : swapChainFramebuffers) {
@@ -48,6 +48,7 @@ SwapChain::~SwapChain()
 
 VkResult SwapChain::AcquireNextImage(uint32_t* imageIndex)
 {
+	MVE_PROFILE_SCOPE("SwapChain::AcquireNextImage");
 	vkWaitForFences(device.VulkanDevice(), 1, &inFlightFences[currentFrame], VK_TRUE,
 					std::numeric_limits<uint64_t>::max());
 
@@ -60,6 +61,7 @@ VkResult SwapChain::AcquireNextImage(uint32_t* imageIndex)
 
 VkResult SwapChain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex)
 {
+	MVE_PROFILE_SCOPE("SwapChain::SubmitCommandBuffers");
 	if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
 		vkWaitForFences(device.VulkanDevice(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
 	}
@@ -82,7 +84,7 @@ VkResult SwapChain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_
 	submitInfo.pSignalSemaphores	= signalSemaphores;
 
 	vkResetFences(device.VulkanDevice(), 1, &inFlightFences[currentFrame]);
-	if (vkQueueSubmit(device.GraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+	if (device.QueueSubmit(device.GraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
 		MVE_ERROR("Failed to submit draw command buffer!");
 	}
 
@@ -98,7 +100,7 @@ VkResult SwapChain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_
 
 	presentInfo.pImageIndices = imageIndex;
 
-	auto result = vkQueuePresentKHR(device.PresentQueue(), &presentInfo);
+	auto result = device.QueuePresent(presentInfo);
 
 	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -190,7 +192,7 @@ void SwapChain::CreateImageViews()
 void SwapChain::CreateRenderPass()
 {
 	VkAttachmentDescription depthAttachment {};
-	depthAttachment.format		   = FindDepthFormat();
+	depthAttachment.format		   = device.FindDepthFormat();
 	depthAttachment.samples		   = VK_SAMPLE_COUNT_1_BIT;
 	depthAttachment.loadOp		   = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	depthAttachment.storeOp		   = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -204,7 +206,7 @@ void SwapChain::CreateRenderPass()
 	depthAttachmentRef.layout	  = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	VkAttachmentDescription colorAttachment = {};
-	colorAttachment.format					= GetSwapChainImageFormat();
+	colorAttachment.format					= GetImageFormat();
 	colorAttachment.samples					= VK_SAMPLE_COUNT_1_BIT;
 	colorAttachment.loadOp					= VK_ATTACHMENT_LOAD_OP_CLEAR;
 	colorAttachment.storeOp					= VK_ATTACHMENT_STORE_OP_STORE;
@@ -254,7 +256,7 @@ void SwapChain::CreateFramebuffers()
 	for (size_t i = 0; i < ImageCount(); i++) {
 		std::array<VkImageView, 2> attachments = {swapChainImageViews[i], depthImageViews[i]};
 
-		VkExtent2D swapChainExtent				= GetSwapChainExtent();
+		VkExtent2D swapChainExtent				= GetExtent();
 		VkFramebufferCreateInfo framebufferInfo = {};
 		framebufferInfo.sType					= VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 		framebufferInfo.renderPass				= renderPass;
@@ -273,9 +275,9 @@ void SwapChain::CreateFramebuffers()
 
 void SwapChain::CreateDepthResources()
 {
-	VkFormat depthFormat	   = FindDepthFormat();
+	VkFormat depthFormat	   = device.FindDepthFormat();
 	swapChainDepthFormat	   = depthFormat;
-	VkExtent2D swapChainExtent = GetSwapChainExtent();
+	VkExtent2D swapChainExtent = GetExtent();
 
 	depthImages.resize(ImageCount());
 	depthImageMemorys.resize(ImageCount());
@@ -389,10 +391,4 @@ VkExtent2D SwapChain::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilit
 		return actualExtent;
 	}
 }
-
-VkFormat SwapChain::FindDepthFormat()
-{
-	return device.FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
-									  VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-}
 } // namespace MVE
\ No newline at end of file
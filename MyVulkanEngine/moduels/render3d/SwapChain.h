@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Device.h"
+#include "RenderTarget.h"
 
 // vulkan headers
 #include <vulkan/vulkan.h>
@@ -8,40 +9,25 @@
 namespace MVE
 {
 
-class SwapChain
+class SwapChain : public RenderTarget
 {
   public:
-	static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
 	SwapChain(Device& deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> prev = nullptr);
 	~SwapChain();
 
 	SwapChain(const SwapChain&)		 = delete;
 	void operator=(const SwapChain&) = delete;
 
-	VkFramebuffer GetFrameBuffer(int index) { return swapChainFramebuffers[index]; }
-	VkRenderPass GetRenderPass() { return renderPass; }
+	VkFramebuffer GetFrameBuffer(int index) override { return swapChainFramebuffers[index]; }
+	VkRenderPass GetRenderPass() override { return renderPass; }
 	VkImageView GetImageView(int index) { return swapChainImageViews[index]; }
-	size_t ImageCount() { return swapChainImages.size(); }
-	VkFormat GetSwapChainImageFormat() { return swapChainImageFormat; }
-	VkExtent2D GetSwapChainExtent() { return swapChainExtent; }
-	uint32_t Width() { return swapChainExtent.width; }
-	uint32_t Height() { return swapChainExtent.height; }
-
-	float ExtentAspectRatio()
-	{
-		return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
-	}
-	VkFormat FindDepthFormat();
-
-	VkResult AcquireNextImage(uint32_t* imageIndex);
-	VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
-
-	bool CompareSwapFormats(const SwapChain& other)
-	{
-		return this->swapChainImageFormat == other.swapChainImageFormat &&
-			   this->swapChainDepthFormat == other.swapChainDepthFormat;
-	}
+	size_t ImageCount() override { return swapChainImages.size(); }
+	VkFormat GetImageFormat() override { return swapChainImageFormat; }
+	VkFormat GetDepthFormat() override { return swapChainDepthFormat; }
+	VkExtent2D GetExtent() override { return swapChainExtent; }
+
+	VkResult AcquireNextImage(uint32_t* imageIndex) override;
+	VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) override;
 
   private:
 	void CreateSwapChain();
@@ -64,7 +50,7 @@ class SwapChain
 	VkRenderPass renderPass;
 
 	std::vector<VkImage> depthImages;
-	std::vector<VkDeviceMemory> depthImageMemorys;
+	std::vector<Allocation> depthImageMemorys;
 	std::vector<VkImageView> depthImageViews;
 	std::vector<VkImage> swapChainImages;
 	std::vector<VkImageView> swapChainImageViews;
@@ -4,6 +4,10 @@
 #include <stb_image.h>
 
 #include "Buffer.h"
+#include "UploadManager.h"
+
+#include <cstring>
+#include <numeric>
 
 namespace MVE
 {
@@ -101,11 +105,6 @@ std::unique_ptr<Texture> Texture::Builder::build()
 	if (useMipmaps_)
 		mipmapCount_ = (std::floor(std::log2(std::max(width_, height_)))) + 1;
 
-	Buffer buffer(device_, imageSize, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-	buffer.Map();
-	for (int i = 0; i < layers_.size(); i++) { buffer.WriteToBuffer(layers_[i].data(), layerSize, layerSize * i); }
-	buffer.Flush();
-
 	VkImageCreateInfo createInfo {};
 	createInfo.sType		 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	createInfo.imageType	 = VK_IMAGE_TYPE_2D;
@@ -124,17 +123,36 @@ std::unique_ptr<Texture> Texture::Builder::build()
 
 	image_ = std::make_unique<Texture>(device_);
 	device_.CreateImageWithInfo(createInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_->image, image_->imageMemory);
+	image_->imageInfo = createInfo;
 
-	image_->TransitionImageLayout(format_, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-								  layers_.size(), mipmapCount_);
-
-	device_.CopyBufferToImage(buffer.GetBuffer(), image_->image, width_, height_, layers_.size());
-
-	if (useMipmaps_)
-		generateMipmaps();
-	else
-		image_->TransitionImageLayout(format_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout_, layers_.size(),
-									  mipmapCount_);
+	// The layers follow each other in the staging memory. The copy runs before the next frame, nothing waits for it.
+	auto write = [&](void* staging) {
+		for (size_t i = 0; i < layers_.size(); i++) {
+			std::memcpy(static_cast<char*>(staging) + layerSize * i, layers_[i].data(), layerSize);
+		}
+	};
+	// Blits and shader layouts are only for the graphics queue, the copy may run on a transfer queue
+	auto record = [&](const UploadManager::Commands& commands, VkBuffer staging, VkDeviceSize offset) {
+		image_->RecordLayoutTransition(commands.transfer, VK_IMAGE_LAYOUT_UNDEFINED,
+									   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layers_.size(), mipmapCount_);
+
+		VkBufferImageCopy region {};
+		region.bufferOffset		= offset;
+		region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, uint32_t(layers_.size())};
+		region.imageExtent		= {width_, height_, 1};
+		vkCmdCopyBufferToImage(commands.transfer, staging, image_->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+							   &region);
+		commands.HandOver(image_->image,
+						  {VK_IMAGE_ASPECT_COLOR_BIT, 0, uint32_t(mipmapCount_), 0, uint32_t(layers_.size())});
+
+		if (useMipmaps_)
+			generateMipmaps(commands.graphics);
+		else
+			image_->RecordLayoutTransition(commands.graphics, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout_,
+										   layers_.size(), mipmapCount_);
+	};
+	// Texel offsets have to be a multiple of the texel size and of 4
+	device_.GetUploadManager().Upload(imageSize, std::lcm<VkDeviceSize>(bpp_, 4), write, record);
 
 	image_->layout_	  = layout_;
 	image_->imageView = createImageView();
@@ -147,10 +165,12 @@ std::unique_ptr<Texture> Texture::Builder::build()
 	image_->mipMapsLevels_ = mipmapCount_;
 	image_->format_		   = format_;
 
+	if (relocatable_)
+		device_.GetDefragmenter().Register(image_.get());
 	return std::move(image_);
 }
 
-void Texture::Builder::generateMipmaps()
+void Texture::Builder::generateMipmaps(VkCommandBuffer commandBuffer)
 {
 	VkFormatProperties formatProperties;
 	vkGetPhysicalDeviceFormatProperties(device_.PhysicalDevice(), format_, &formatProperties);
@@ -158,8 +178,6 @@ void Texture::Builder::generateMipmaps()
 	MVE_ASSERT(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT,
 			   "Can't generate mipmaps. device is not supported.");
 
-	auto commandBuffer = device_.BeginSingleTimeCommands();
-
 	VkImageMemoryBarrier barrier {};
 	barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
@@ -222,8 +240,6 @@ void Texture::Builder::generateMipmaps()
 
 	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
 						 nullptr, 0, nullptr, 1, &barrier);
-
-	device_.EndSingleTimeCommands(commandBuffer);
 }
 
 VkImageView Texture::Builder::createImageView()
@@ -242,6 +258,7 @@ VkImageView Texture::Builder::createImageView()
 	VkImageView imageView;
 	auto code = vkCreateImageView(device_.VulkanDevice(), &createInfo, nullptr, &imageView);
 	MVE_ASSERT(code == VK_SUCCESS, "Failed to create image view");
+	image_->viewInfo = createInfo;
 
 	return imageView;
 }
@@ -276,10 +293,75 @@ VkSampler Texture::Builder::createSampler()
 
 Texture::~Texture()
 {
+	if (IsRegistered())
+		device.GetDefragmenter().Unregister(this);
 	vkDestroySampler(device.VulkanDevice(), sampler, nullptr);
 	vkDestroyImageView(device.VulkanDevice(), imageView, nullptr);
 	vkDestroyImage(device.VulkanDevice(), image, nullptr);
-	vkFreeMemory(device.VulkanDevice(), imageMemory, nullptr);
+	device.FreeMemory(imageMemory);
+}
+
+bool Texture::Relocate(VkCommandBuffer commandBuffer, OldHandles& old)
+{
+	VkImage moved;
+	if (vkCreateImage(device.VulkanDevice(), &imageInfo, nullptr, &moved) != VK_SUCCESS)
+		return false;
+
+	auto movedMemory = device.GetMemoryAllocator().RelocateImage(moved, imageMemory);
+	if (movedMemory.kind == Allocation::Kind::None) {
+		vkDestroyImage(device.VulkanDevice(), moved, nullptr);
+		return false;
+	}
+
+	VkImageViewCreateInfo movedViewInfo = viewInfo;
+	movedViewInfo.image					= moved;
+	VkImageView movedView;
+	auto code = vkCreateImageView(device.VulkanDevice(), &movedViewInfo, nullptr, &movedView);
+	MVE_ASSERT(code == VK_SUCCESS, "Failed to create image view");
+
+	// The old image isn't sampled again, it only has to stay alive for the frames in flight that already did
+	VkImageMemoryBarrier barriers[2] {};
+	for (auto& barrier : barriers) {
+		barrier.sType				= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange	= viewInfo.subresourceRange;
+	}
+	barriers[0].image		  = image;
+	barriers[0].oldLayout	  = layout_;
+	barriers[0].newLayout	  = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barriers[1].image		  = moved;
+	barriers[1].oldLayout	  = VK_IMAGE_LAYOUT_UNDEFINED;
+	barriers[1].newLayout	  = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+						 nullptr, 0, nullptr, 2, barriers);
+
+	std::vector<VkImageCopy> regions(mipMapsLevels_);
+	for (uint32_t mip = 0; mip < mipMapsLevels_; mip++) {
+		auto& region		  = regions[mip];
+		region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, layers_};
+		region.dstSubresource = region.srcSubresource;
+		region.extent		  = {std::max(width_ >> mip, 1u), std::max(height_ >> mip, 1u), 1};
+	}
+	vkCmdCopyImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, moved,
+				   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(), regions.data());
+
+	barriers[1].oldLayout	  = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barriers[1].newLayout	  = layout_;
+	barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0,
+						 nullptr, 0, nullptr, 1, &barriers[1]);
+
+	old.image	   = image;
+	old.imageView  = imageView;
+	old.allocation = imageMemory;
+	image		   = moved;
+	imageView	   = movedView;
+	imageMemory	   = movedMemory;
+	return true;
 }
 
 VkDescriptorImageInfo Texture::ImageInfo() const
@@ -291,11 +373,9 @@ VkDescriptorImageInfo Texture::ImageInfo() const
 	return imageInfo;
 }
 
-void Texture::TransitionImageLayout(VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout,
-									uint32_t layerCount, uint32_t mipmapCount)
+void Texture::RecordLayoutTransition(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout,
+									 uint32_t layerCount, uint32_t mipmapCount)
 {
-	auto commandBuffer = device.BeginSingleTimeCommands();
-
 	VkImageMemoryBarrier barrier {};
 	barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	barrier.oldLayout						= oldLayout;
@@ -345,8 +425,6 @@ void Texture::TransitionImageLayout(VkFormat format, VkImageLayout oldLayout, Vk
 
 	vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
-	device.EndSingleTimeCommands(commandBuffer);
-
 	layout_ = newLayout;
 }
 } // namespace MVE
\ No newline at end of file
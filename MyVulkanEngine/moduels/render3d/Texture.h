@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Defragmenter.h"
 #include "Device.h"
 
 namespace MVE
@@ -47,9 +48,10 @@ class FloatSolidTextureSource : public TextureSource
 	FloatSolidTextureSource(glm::vec4 color, uint32_t width = 1, uint32_t height = 1);
 };
 
-class Texture
+class Texture : public Relocatable
 {
 	friend class Cubemap;
+	friend class AsyncCompute;
 
   public:
 	class Builder
@@ -95,11 +97,17 @@ class Texture
 			layout_ = layout;
 			return *this;
 		}
+		// Lets the Defragmenter move the texture, only for textures that are bound through the MaterialSystem
+		Builder& relocatable(bool value)
+		{
+			relocatable_ = value;
+			return *this;
+		}
 
 		std::unique_ptr<Texture> build();
 
 	  private:
-		void generateMipmaps();
+		void generateMipmaps(VkCommandBuffer commandBuffer);
 		VkImageView createImageView();
 		VkSampler createSampler();
 
@@ -117,6 +125,7 @@ class Texture
 		VkSamplerAddressMode addressMode_ = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		bool isCubemap_					  = false;
 		bool useMipmaps_				  = false;
+		bool relocatable_				  = false;
 		VkSamplerMipmapMode mipmapMode_	  = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 		int mipmapCount_				  = 1;
 		VkImageUsageFlags usage			  = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
@@ -125,7 +134,7 @@ class Texture
 
   public:
 	Texture(Device& device): device(device) {}
-	~Texture();
+	~Texture() override;
 
 	VkImageView ImageView() const { return imageView; }
 	VkSampler Sampler() const { return sampler; }
@@ -137,19 +146,26 @@ class Texture
 	uint32_t bpp() const { return bpp_; }
 	uint32_t mipMaps() const { return mipMapsLevels_; }
 	VkFormat Format() const { return format_; }
+	const Allocation& GetAllocation() const override { return imageMemory; }
 
   public:
-	void TransitionImageLayout(VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t layerCount,
-							   uint32_t mipmapCount);
+	void RecordLayoutTransition(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout,
+								uint32_t layerCount, uint32_t mipmapCount);
+
+  protected:
+	bool Relocate(VkCommandBuffer commandBuffer, OldHandles& old) override;
 
   private:
 	Device& device;
 	VkImage image;
-	VkDeviceMemory imageMemory;
+	Allocation imageMemory;
 	VkImageView imageView;
 	VkSampler sampler;
 	VkImageLayout layout_;
 	VkFormat format_;
+	// How the image and its view were created, for creating them again when the texture is relocated
+	VkImageCreateInfo imageInfo {};
+	VkImageViewCreateInfo viewInfo {};
 
 	uint32_t layers_;
 	uint32_t width_;
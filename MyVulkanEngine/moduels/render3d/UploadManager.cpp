@@ -0,0 +1,393 @@
+#include "UploadManager.h"
+
+#include <cstring>
+
+namespace MVE
+{
+
+constexpr VkDeviceSize RING_SIZE = VkDeviceSize(64) << 20;
+// Bigger uploads get a staging buffer of their own instead of taking up most of the ring
+constexpr VkDeviceSize MAX_RING_UPLOAD = RING_SIZE / 4;
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+void UploadManager::Commands::HandOver(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) const
+{
+	// On a single queue the barrier at the end of the batch covers it
+	if (transferFamily == graphicsFamily)
+		return;
+
+	VkBufferMemoryBarrier barrier {};
+	barrier.sType				= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = transferFamily;
+	barrier.dstQueueFamilyIndex = graphicsFamily;
+	barrier.buffer				= buffer;
+	barrier.offset				= offset;
+	barrier.size				= size;
+	bufferHandOvers->push_back(barrier);
+}
+
+void UploadManager::Commands::HandOver(VkImage image, const VkImageSubresourceRange& range) const
+{
+	// On a single queue the commands recorded into graphics wait for the copy themselves
+	if (transferFamily == graphicsFamily)
+		return;
+
+	VkImageMemoryBarrier barrier {};
+	barrier.sType				= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout			= VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout			= VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = transferFamily;
+	barrier.dstQueueFamilyIndex = graphicsFamily;
+	barrier.image				= image;
+	barrier.subresourceRange	= range;
+
+	// The release only makes the copy available, the acquire makes it visible to the commands after it
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(transfer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+						 0, nullptr, 1, &barrier);
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(graphics, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+						 0, nullptr, 1, &barrier);
+}
+
+UploadManager::UploadManager(Device& device): device(device)
+{
+	auto families	 = device.FindPhysicalQueueFamilies();
+	transferFamily	 = families.transferFamily;
+	graphicsFamily	 = families.graphicsFamily;
+	hasTransferQueue = transferFamily != graphicsFamily;
+
+	VkCommandPoolCreateInfo poolInfo {};
+	poolInfo.sType			  = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = transferFamily;
+	poolInfo.flags			  = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+	auto code = vkCreateCommandPool(device.VulkanDevice(), &poolInfo, nullptr, &transferPool);
+	MVE_ASSERT(code == VK_SUCCESS, "Failed to create the upload command pool");
+
+	graphicsPool = transferPool;
+	if (hasTransferQueue) {
+		poolInfo.queueFamilyIndex = graphicsFamily;
+		code					  = vkCreateCommandPool(device.VulkanDevice(), &poolInfo, nullptr, &graphicsPool);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to create the upload command pool");
+	}
+
+	ring = std::make_unique<Buffer>(device, RING_SIZE, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+									VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	ring->Map();
+}
+
+UploadManager::~UploadManager()
+{
+	Submit();
+	for (auto& batch : inFlight) { vkWaitForFences(device.VulkanDevice(), 1, &batch.fence, VK_TRUE, UINT64_MAX); }
+	Retire();
+
+	// Destroying the pools frees the command buffers
+	for (auto& batch : freeBatches) {
+		vkDestroySemaphore(device.VulkanDevice(), batch.recorded, nullptr);
+		vkDestroySemaphore(device.VulkanDevice(), batch.transferred, nullptr);
+		vkDestroyFence(device.VulkanDevice(), batch.fence, nullptr);
+	}
+	if (hasTransferQueue)
+		vkDestroyCommandPool(device.VulkanDevice(), graphicsPool, nullptr);
+	vkDestroyCommandPool(device.VulkanDevice(), transferPool, nullptr);
+}
+
+UploadManager::Ticket UploadManager::Upload(VkDeviceSize size, VkDeviceSize alignment, const WriteFunction& write,
+											const RecordFunction& record)
+{
+	MVE_PROFILE_FUNCTION();
+	std::lock_guard lock(mutex);
+
+	if (size > MAX_RING_UPLOAD) {
+		auto staging = std::make_unique<Buffer>(device, size, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+												VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+													VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+												1, MemoryLifetime::Transient);
+		staging->Map();
+		write(staging->GetMappedMemory());
+
+		auto& batch = Recording();
+		record(GetCommands(batch), staging->GetBuffer(), 0);
+		batch.hasUploads = true;
+		batch.oversized.push_back(std::move(staging));
+		return batch.ticket;
+	}
+
+	VkDeviceSize offset;
+	while (!TryAllocate(size, alignment, offset)) {
+		// The ring is full, what was recorded so far goes out and the oldest batch has to finish
+		if (recording)
+			SubmitRecording();
+		MVE_ASSERT(!inFlight.empty(), "Staging ring is full without any uploads in flight");
+		vkWaitForFences(device.VulkanDevice(), 1, &inFlight.front().fence, VK_TRUE, UINT64_MAX);
+		Retire();
+	}
+	write(static_cast<char*>(ring->GetMappedMemory()) + offset);
+
+	auto& batch = Recording();
+	record(GetCommands(batch), ring->GetBuffer(), offset);
+	batch.hasUploads = true;
+	return batch.ticket;
+}
+
+UploadManager::Ticket UploadManager::UploadToBuffer(VkBuffer destination, VkDeviceSize offset, const void* data,
+													VkDeviceSize size)
+{
+	return Upload(
+		size, 4, [&](void* staging) { std::memcpy(staging, data, size); },
+		[&](const Commands& commands, VkBuffer staging, VkDeviceSize stagingOffset) {
+			VkBufferCopy region {stagingOffset, offset, size};
+			vkCmdCopyBuffer(commands.transfer, staging, destination, 1, &region);
+			commands.HandOver(destination, offset, size);
+		});
+}
+
+UploadManager::Ticket UploadManager::Record(const std::function<void(VkCommandBuffer commandBuffer)>& record)
+{
+	std::lock_guard lock(mutex);
+	// On a transfer queue the uploads already in the batch would run after what is recorded now
+	if (hasTransferQueue && recording && recording->hasUploads)
+		SubmitRecording();
+
+	auto& batch = Recording();
+	record(batch.recordCommands);
+	batch.hasRecords = true;
+	return batch.ticket;
+}
+
+void UploadManager::Submit()
+{
+	std::lock_guard lock(mutex);
+	if (recording)
+		SubmitRecording();
+	Retire();
+}
+
+bool UploadManager::IsComplete(Ticket ticket)
+{
+	std::lock_guard lock(mutex);
+	Retire();
+	return ticket <= completedTicket;
+}
+
+void UploadManager::Wait(Ticket ticket)
+{
+	MVE_PROFILE_FUNCTION();
+	std::lock_guard lock(mutex);
+	if (recording && recording->ticket <= ticket)
+		SubmitRecording();
+
+	while (!inFlight.empty() && inFlight.front().ticket <= ticket) {
+		vkWaitForFences(device.VulkanDevice(), 1, &inFlight.front().fence, VK_TRUE, UINT64_MAX);
+		Retire();
+	}
+}
+
+UploadManager::Batch& UploadManager::Recording()
+{
+	if (recording)
+		return *recording;
+
+	Retire();
+	if (freeBatches.empty()) {
+		Batch batch {};
+
+		VkCommandBufferAllocateInfo allocInfo {};
+		allocInfo.sType				 = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level				 = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool		 = transferPool;
+		allocInfo.commandBufferCount = 1;
+
+		auto code = vkAllocateCommandBuffers(device.VulkanDevice(), &allocInfo, &batch.transferCommands);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to allocate an upload command buffer");
+		batch.recordCommands   = batch.transferCommands;
+		batch.graphicsCommands = batch.transferCommands;
+
+		if (hasTransferQueue) {
+			VkCommandBuffer graphicsCommands[2];
+			allocInfo.commandPool		 = graphicsPool;
+			allocInfo.commandBufferCount = 2;
+
+			code = vkAllocateCommandBuffers(device.VulkanDevice(), &allocInfo, graphicsCommands);
+			MVE_ASSERT(code == VK_SUCCESS, "Failed to allocate an upload command buffer");
+			batch.recordCommands   = graphicsCommands[0];
+			batch.graphicsCommands = graphicsCommands[1];
+
+			VkSemaphoreCreateInfo semaphoreInfo {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			for (auto semaphore : {&batch.recorded, &batch.transferred}) {
+				code = vkCreateSemaphore(device.VulkanDevice(), &semaphoreInfo, nullptr, semaphore);
+				MVE_ASSERT(code == VK_SUCCESS, "Failed to create an upload semaphore");
+			}
+		}
+
+		VkFenceCreateInfo fenceInfo {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		code			= vkCreateFence(device.VulkanDevice(), &fenceInfo, nullptr, &batch.fence);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to create an upload fence");
+
+		freeBatches.push_back(std::move(batch));
+	}
+
+	recording = std::make_unique<Batch>(std::move(freeBatches.back()));
+	freeBatches.pop_back();
+	recording->ticket	  = nextTicket++;
+	recording->hasRecords = false;
+	recording->hasUploads = false;
+
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(recording->transferCommands, &beginInfo);
+	if (hasTransferQueue) {
+		vkBeginCommandBuffer(recording->recordCommands, &beginInfo);
+		vkBeginCommandBuffer(recording->graphicsCommands, &beginInfo);
+	}
+	return *recording;
+}
+
+UploadManager::Commands UploadManager::GetCommands(Batch& batch)
+{
+	Commands commands;
+	commands.transfer		 = batch.transferCommands;
+	commands.graphics		 = batch.graphicsCommands;
+	commands.transferFamily	 = transferFamily;
+	commands.graphicsFamily	 = graphicsFamily;
+	commands.bufferHandOvers = &batch.bufferHandOvers;
+	return commands;
+}
+
+void UploadManager::SubmitRecording()
+{
+	MVE_PROFILE_FUNCTION();
+	auto& batch = *recording;
+
+	auto& handOvers = batch.bufferHandOvers;
+	if (!handOvers.empty()) {
+		for (auto& barrier : handOvers) { barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT; }
+		vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT,
+							 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, handOvers.size(), handOvers.data(), 0,
+							 nullptr);
+		for (auto& barrier : handOvers) {
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		}
+		vkCmdPipelineBarrier(batch.graphicsCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+							 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, handOvers.size(), handOvers.data(), 0,
+							 nullptr);
+		handOvers.clear();
+	}
+
+	// Later submits to the graphics queue, like the frame's command buffer, see the uploaded data
+	VkMemoryBarrier barrier {};
+	barrier.sType		  = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	vkCmdPipelineBarrier(batch.graphicsCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+						 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkResetFences(device.VulkanDevice(), 1, &batch.fence);
+	if (hasTransferQueue) {
+		vkEndCommandBuffer(batch.recordCommands);
+		vkEndCommandBuffer(batch.transferCommands);
+		vkEndCommandBuffer(batch.graphicsCommands);
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkSubmitInfo submits[3] {};
+		for (auto& submit : submits) {
+			submit.sType			  = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submit.commandBufferCount = 1;
+			submit.pWaitDstStageMask  = &waitStage;
+		}
+		submits[0].pCommandBuffers		= &batch.recordCommands;
+		submits[0].signalSemaphoreCount = 1;
+		submits[0].pSignalSemaphores	= &batch.recorded;
+		submits[1].pCommandBuffers		= &batch.transferCommands;
+		submits[1].waitSemaphoreCount	= batch.hasRecords ? 1 : 0;
+		submits[1].pWaitSemaphores		= &batch.recorded;
+		submits[1].signalSemaphoreCount = 1;
+		submits[1].pSignalSemaphores	= &batch.transferred;
+		submits[2].pCommandBuffers		= &batch.graphicsCommands;
+		submits[2].waitSemaphoreCount	= 1;
+		submits[2].pWaitSemaphores		= &batch.transferred;
+
+		// Only the acquires wait for the copies, the frames before them keep rendering meanwhile
+		auto code = VK_SUCCESS;
+		if (batch.hasRecords)
+			code = device.QueueSubmit(device.GraphicsQueue(), 1, &submits[0], VK_NULL_HANDLE);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to submit uploads");
+		code = device.QueueSubmit(device.TransferQueue(), 1, &submits[1], VK_NULL_HANDLE);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to submit uploads");
+		code = device.QueueSubmit(device.GraphicsQueue(), 1, &submits[2], batch.fence);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to submit uploads");
+	} else {
+		vkEndCommandBuffer(batch.transferCommands);
+
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType			  = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers	  = &batch.transferCommands;
+
+		auto code = device.QueueSubmit(device.GraphicsQueue(), 1, &submitInfo, batch.fence);
+		MVE_ASSERT(code == VK_SUCCESS, "Failed to submit uploads");
+	}
+
+	batch.ringEnd = head;
+	inFlight.push_back(std::move(batch));
+	recording.reset();
+}
+
+void UploadManager::Retire()
+{
+	while (!inFlight.empty() && vkGetFenceStatus(device.VulkanDevice(), inFlight.front().fence) == VK_SUCCESS) {
+		auto& batch		= inFlight.front();
+		tail			= batch.ringEnd;
+		completedTicket = batch.ticket;
+		batch.oversized.clear();
+
+		freeBatches.push_back(std::move(batch));
+		inFlight.pop_front();
+	}
+}
+
+bool UploadManager::TryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+	// Nothing in the ring is read anymore, start over at the front
+	if (inFlight.empty() && !recording) {
+		head = 0;
+		tail = 0;
+	}
+
+	// head never catches up with tail, head == tail means the ring is empty
+	VkDeviceSize aligned = AlignUp(head, alignment);
+	if (head >= tail) {
+		if (aligned + size <= RING_SIZE) {
+			offset = aligned;
+			head   = aligned + size;
+			return true;
+		}
+		// Wraps around, the rest of the end stays unused until the tail passed it
+		if (size < tail) {
+			offset = 0;
+			head   = size;
+			return true;
+		}
+		return false;
+	}
+
+	if (aligned + size < tail) {
+		offset = aligned;
+		head   = aligned + size;
+		return true;
+	}
+	return false;
+}
+
+} // namespace MVE
\ No newline at end of file
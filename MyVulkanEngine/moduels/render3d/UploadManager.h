@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Buffer.h"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace MVE
+{
+
+/// Streams data into device local buffers and images through one persistently mapped staging ring. The copies are
+/// recorded into a batch that is submitted once per frame, right before the frame's own command buffer, so the frame
+/// can already use the data. Every batch has a fence that tells when its part of the ring can be written again.
+/// Nothing waits for the queue to go idle, only a full ring waits for its oldest batch. Thread safe.
+///
+/// When the device has a dedicated transfer queue the copies run there, next to the frames still rendering on the
+/// graphics queue. The uploaded resources are then released by the transfer queue and acquired by the graphics queue,
+/// in a short command buffer that waits for the copies before the frame is submitted.
+class UploadManager
+{
+  public:
+	// Where an upload records its commands. transfer runs first, on the transfer queue, and graphics after it on the
+	// graphics queue. They are the same command buffer when the device has no transfer queue.
+	class Commands
+	{
+	  public:
+		VkCommandBuffer transfer = VK_NULL_HANDLE;
+		VkCommandBuffer graphics = VK_NULL_HANDLE;
+
+		// Makes what transfer wrote to the range available to graphics and the frames after it
+		void HandOver(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) const;
+		// Same for an image, which stays in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+		void HandOver(VkImage image, const VkImageSubresourceRange& range) const;
+
+	  private:
+		friend class UploadManager;
+
+		uint32_t transferFamily = 0;
+		uint32_t graphicsFamily = 0;
+		// Recorded all at once when the batch is submitted
+		std::vector<VkBufferMemoryBarrier>* bufferHandOvers = nullptr;
+	};
+
+	// Identifies the batch an upload was recorded into
+	using Ticket = uint64_t;
+	// Fills the staging memory
+	using WriteFunction = std::function<void(void* staging)>;
+	// Records the copies out of the staging memory, at offset in staging
+	using RecordFunction = std::function<void(const Commands& commands, VkBuffer staging, VkDeviceSize offset)>;
+
+  public:
+	explicit UploadManager(Device& device);
+	~UploadManager();
+
+	UploadManager(const UploadManager&)	 = delete;
+	void operator=(const UploadManager&) = delete;
+
+	// Reserves size bytes of staging memory aligned to alignment, lets write fill them and record copy them out. Both
+	// are called before Upload returns.
+	Ticket Upload(VkDeviceSize size, VkDeviceSize alignment, const WriteFunction& write, const RecordFunction& record);
+	Ticket UploadToBuffer(VkBuffer destination, VkDeviceSize offset, const void* data, VkDeviceSize size);
+	// Records other transfers on the graphics queue, in order with the uploads: the ones before see what was
+	// uploaded before, the ones after run after them
+	Ticket Record(const std::function<void(VkCommandBuffer commandBuffer)>& record);
+
+	// Submits the copies recorded so far. Called by Renderer::EndFrame, and before every other submit to the graphics
+	// queue that may read what was uploaded.
+	void Submit();
+	bool IsComplete(Ticket ticket);
+	// Blocks until the ticket's batch finished on the GPU, submitting it first if it wasn't yet
+	void Wait(Ticket ticket);
+
+  private:
+	// Without a transfer queue the three command buffers are the same one and there are no semaphores
+	struct Batch
+	{
+		VkCommandBuffer recordCommands	 = VK_NULL_HANDLE; // Graphics queue, what Record adds, before the uploads
+		VkCommandBuffer transferCommands = VK_NULL_HANDLE; // Transfer queue, the uploads
+		VkCommandBuffer graphicsCommands = VK_NULL_HANDLE; // Graphics queue, the acquires, after the uploads
+		VkSemaphore recorded			 = VK_NULL_HANDLE;
+		VkSemaphore transferred			 = VK_NULL_HANDLE;
+		VkFence fence					 = VK_NULL_HANDLE; // Of the last submit, the others are done before it
+		Ticket ticket					 = 0;
+		VkDeviceSize ringEnd			 = 0; // Ring head at the submit, the tail moves here once the batch is done
+		bool hasRecords					 = false;
+		bool hasUploads					 = false;
+		std::vector<VkBufferMemoryBarrier> bufferHandOvers;
+		std::vector<std::unique_ptr<Buffer>> oversized; // Staging of uploads too big for the ring
+	};
+
+	// Batch the uploads are recorded into, begun if there is none
+	Batch& Recording();
+	Commands GetCommands(Batch& batch);
+	void SubmitRecording();
+	// Reclaims the staging memory of the batches that finished
+	void Retire();
+	bool TryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+
+  private:
+	Device& device;
+	uint32_t transferFamily;
+	uint32_t graphicsFamily;
+	bool hasTransferQueue;
+	VkCommandPool transferPool = VK_NULL_HANDLE;
+	VkCommandPool graphicsPool = VK_NULL_HANDLE; // The same as transferPool without a transfer queue
+
+	std::mutex mutex;
+	std::unique_ptr<Buffer> ring;
+	VkDeviceSize head = 0; // Where the next upload goes
+	VkDeviceSize tail = 0; // Start of the oldest upload that may still be read, equal to head when the ring is empty
+
+	std::unique_ptr<Batch> recording;
+	std::deque<Batch> inFlight; // In submission order, their fences signal in that order too
+	std::vector<Batch> freeBatches;
+	Ticket nextTicket	   = 1;
+	Ticket completedTicket = 0;
+};
+
+} // namespace MVE
\ No newline at end of file
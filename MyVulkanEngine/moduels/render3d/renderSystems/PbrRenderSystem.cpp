@@ -1,44 +1,50 @@
 #include "PbrRenderSystem.h"
 
+#include "../SwapChain.h"
+
+#include <algorithm>
+
 namespace MVE
 {
-// TEMP
-struct SimplePushConstantData
-{
-	glm::mat4 modelMatrix {1.0f};
-	glm::mat4 normalMatrix {1.0f};
-};
+
+constexpr uint32_t INSTANCE_BINDING		   = 1;
+constexpr uint32_t FIRST_INSTANCE_LOCATION = 6;
+constexpr uint32_t MIN_INSTANCE_CAPACITY   = 1024;
+constexpr uint32_t PBR_PIPELINE			   = 0; // The only pipeline so far, bound once for the whole queue
+constexpr uint32_t MIN_RUNS_PER_CHUNK	   = 128;
 
 PbrRenderSystem::PbrRenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
-								 MaterialSystem& materialSystem):
+								 MaterialSystem& materialSystem, bool cpuCulling):
 	device(device)
 {
 	CreatePipelineLayout(globalSetLayout, materialSystem);
 	CreatePipeline(renderPass);
+	instanceBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+	if (cpuCulling)
+		MVE_INFO("Culling on the CPU");
+	else if (GpuCulling::IsSupported(device))
+		gpuCulling = std::make_unique<GpuCulling>(device, materialSystem);
+	else
+		MVE_WARN("Device doesn't support indirect draws with a first instance, culling on the CPU");
 }
 
 PbrRenderSystem::~PbrRenderSystem()
 {
 	vkDeviceWaitIdle(device.VulkanDevice());
+	pipeline.Wait();
 	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
 }
 
 void PbrRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout, MaterialSystem& materialSystem)
 {
-	VkPushConstantRange pushRange {};
-	pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-	pushRange.offset	 = 0;
-	pushRange.size		 = sizeof(SimplePushConstantData);
-
 	std::vector<VkDescriptorSetLayout> descriptorSetLayouts {globalSetLayout,
 															 materialSystem.GetLayout()->GetDescriptorSetLayout()};
 
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
-	pipelineLayoutInfo.sType				  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount		  = descriptorSetLayouts.size();
-	pipelineLayoutInfo.pSetLayouts			  = descriptorSetLayouts.data();
-	pipelineLayoutInfo.pushConstantRangeCount = 1;
-	pipelineLayoutInfo.pPushConstantRanges	  = &pushRange;
+	pipelineLayoutInfo.sType		  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = descriptorSetLayouts.size();
+	pipelineLayoutInfo.pSetLayouts	  = descriptorSetLayouts.data();
 
 	auto error = vkCreatePipelineLayout(device.VulkanDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
 	MVE_ASSERT(error == VK_SUCCESS, "Failed to create pipeline labs");
@@ -48,41 +54,244 @@ void PbrRenderSystem::CreatePipeline(VkRenderPass renderPass)
 {
 	MVE_ASSERT(pipelineLayout != nullptr, "Pipeline can't be created before pipeline layout");
 
-	PipelineConfigInfo pipelineConfig {};
-	Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+	// Compiled on a worker, RenderGameObjects skips the pass until it's done
+	pipeline.Compile([&device = device, renderPass, layout = pipelineLayout] {
+		PipelineConfigInfo pipelineConfig {};
+		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+
+		pipelineConfig.bindingDescription.push_back(
+			{INSTANCE_BINDING, sizeof(InstanceData), VK_VERTEX_INPUT_RATE_INSTANCE});
+		// One attribute per matrix column, 4 for the model matrix and 3 for the normal matrix
+		for (uint32_t column = 0; column < 7; column++) {
+			pipelineConfig.attributeDescription.push_back({FIRST_INSTANCE_LOCATION + column, INSTANCE_BINDING,
+														   VK_FORMAT_R32G32B32A32_SFLOAT,
+														   uint32_t(column * sizeof(glm::vec4))});
+		}
 
-	pipelineConfig.renderPass	  = renderPass;
-	pipelineConfig.pipelineLayout = pipelineLayout;
-	pipeline					  = std::make_unique<GraphicsPipeline>(device, SHADER_BINARY_DIR "pbr.vert.spv",
-												   SHADER_BINARY_DIR "pbr.frag.spv", pipelineConfig);
+		pipelineConfig.renderPass	  = renderPass;
+		pipelineConfig.pipelineLayout = layout;
+		return std::make_unique<GraphicsPipeline>(device, SHADER_BINARY_DIR "pbr.vert.spv",
+												  SHADER_BINARY_DIR "pbr.frag.spv", pipelineConfig);
+	});
 }
 
-void PbrRenderSystem::RenderGameObjects(FrameInfo& frameInfo, GameObject::Map& gameObjects,
-										MaterialSystem& materialSystem)
+void PbrRenderSystem::PrepareGameObjects(FrameInfo& frameInfo, Registry& registry)
 {
-	pipeline->Bind(frameInfo.commandBuffer);
-
-	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
-							&frameInfo.globalDescriptorSet, 0, nullptr);
+	if (gpuCulling)
+		gpuCulling->Cull(frameInfo, registry);
+}
 
+void PbrRenderSystem::RenderGameObjects(FrameInfo& frameInfo, Registry& registry, const SpatialIndex& spatialIndex,
+										MaterialSystem& materialSystem, Renderer& renderer,
+										std::vector<VkCommandBuffer>& commandBuffers)
+{
+	MVE_PROFILE_SCOPE("PbrRenderSystem::RenderGameObjects");
 	materialSystem.FlushAll(frameInfo.frameIndex);
+	if (!pipeline.TryGet())
+		return;
+
+	drawRuns.clear();
+	VkBuffer instanceBuffer = VK_NULL_HANDLE;
+	if (gpuCulling) {
+		CollectIndirectDraws();
+		instanceBuffer = gpuCulling->InstanceBuffer(frameInfo.frameIndex);
+	} else {
+		instanceBuffer = CollectDraws(frameInfo, registry, spatialIndex, materialSystem);
+	}
+	if (drawRuns.empty())
+		return;
+
+	RecordDrawRuns(frameInfo, materialSystem, renderer, instanceBuffer, commandBuffers);
+	frameInfo.stats.drawCalls += drawRuns.size();
+}
 
-	for (auto& [id, go] : gameObjects) {
-		if (go.model == nullptr)
+VkBuffer PbrRenderSystem::CollectDraws(FrameInfo& frameInfo, Registry& registry, const SpatialIndex& spatialIndex,
+									   const MaterialSystem& materialSystem)
+{
+	CullGameObjects(frameInfo, registry, spatialIndex, materialSystem);
+
+	renderQueue.Clear();
+	const glm::mat4& view = frameInfo.camera.GetView();
+	for (uint32_t i = 0; i < candidates.size(); i++) {
+		if (!visible[i])
 			continue;
 
-		materialSystem.Bind(go.materialId, frameInfo.commandBuffer, pipelineLayout, 1, frameInfo.frameIndex);
+		// The camera looks down +z in view space, so z is the distance in front of it and sorts front to back
+		auto& candidate = candidates[i];
+		float depth		=
+			view[0][2] * spheres[0][i] + view[1][2] * spheres[1][i] + view[2][2] * spheres[2][i] + view[3][2];
+		renderQueue.Push(RenderQueue::MakeKey(PBR_PIPELINE, Handle::Index(candidate.material), candidate.model->GetId(),
+											  depth),
+						 i);
+	}
+	if (renderQueue.Size() == 0)
+		return VK_NULL_HANDLE;
+
+	renderQueue.Sort();
+	auto& items = renderQueue.Items();
+
+	auto& instanceBuffer = GetInstanceBuffer(frameInfo.frameIndex, items.size());
+	auto instances		 = static_cast<InstanceData*>(instanceBuffer.GetMappedMemory());
+	for (size_t i = 0; i < items.size(); i++) {
+		auto transform			  = candidates[items[i].index].transform;
+		instances[i].modelMatrix  = transform->WorldMatrix();
+		instances[i].normalMatrix = glm::mat3x4(transform->NormalMatrix());
+	}
+
+	// Runs of the same model and material are drawn with one instanced call. Truncated ids may put different models
+	// in one run of keys, so the candidates themselves are compared.
+	auto sameBatch = [&](const DrawCandidate& a, const DrawCandidate& b) {
+		return a.model == b.model && a.material == b.material;
+	};
+
+	for (uint32_t first = 0; first < items.size();) {
+		auto& batch	   = candidates[items[first].index];
+		uint32_t count = 1;
+		while (first + count < items.size() && sameBatch(candidates[items[first + count].index], batch)) { count++; }
+
+		drawRuns.push_back({batch.model, batch.material, first, count});
+		frameInfo.stats.triangles += uint64_t(batch.model->TriangleCount()) * count;
+		first += count;
+	}
+	return instanceBuffer.GetBuffer();
+}
+
+void PbrRenderSystem::CollectIndirectDraws()
+{
+	// Visible object and triangle counts are only known on the GPU, GpuCulling reads them back into the stats later
+	auto& batches	= gpuCulling->Batches();
+	auto& drawOrder = gpuCulling->DrawOrder();
 
-		SimplePushConstantData push {};
-		push.modelMatrix  = go.transform.Mat4();
-		push.normalMatrix = go.transform.NormalMatrix();
+	// The commands are in draw order, so a run of batches with the same material, page and command type is one
+	// multi-draw
+	auto sameDraw = [&](const GpuCulling::Batch& a, const GpuCulling::Batch& b) {
+		return a.material == b.material && a.model->GetMesh().page == b.model->GetMesh().page &&
+			   a.model->IsIndexed() == b.model->IsIndexed();
+	};
 
-		vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout,
-						   VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+	for (uint32_t first = 0; first < drawOrder.size();) {
+		auto& batch	   = batches[drawOrder[first]];
+		uint32_t count = 1;
+		while (first + count < drawOrder.size() && sameDraw(batches[drawOrder[first + count]], batch)) { count++; }
+
+		drawRuns.push_back({batch.model, batch.material, first, count});
+		first += count;
+	}
+}
+
+void PbrRenderSystem::RecordDrawRuns(FrameInfo& frameInfo, MaterialSystem& materialSystem, Renderer& renderer,
+									 VkBuffer instanceBuffer, std::vector<VkCommandBuffer>& commandBuffers)
+{
+	// Small scenes aren't worth a job per thread and end up in a single command buffer
+	uint32_t chunkCount = std::clamp<uint32_t>(drawRuns.size() / MIN_RUNS_PER_CHUNK, 1, JobSystem::ThreadCount());
+	size_t firstBuffer	= commandBuffers.size();
+	commandBuffers.resize(firstBuffer + chunkCount);
+
+	VkBuffer indirectBuffer = gpuCulling ? gpuCulling->IndirectBuffer(frameInfo.frameIndex) : VK_NULL_HANDLE;
+	auto& meshPool			= device.GetMeshPool();
+	auto& pbrPipeline		= pipeline.Get(); // Checked by RenderGameObjects, doesn't wait
+
+	// Every chunk is recorded from scratch, so each starts by binding everything. The buffers are executed in chunk
+	// order, which keeps the sorted draw order.
+	JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t chunk = begin; chunk < end; chunk++) {
+			MVE_PROFILE_SCOPE("PbrRenderSystem::RecordChunk");
+			auto commandBuffer = renderer.BeginSecondaryCommandBuffer();
+
+			pbrPipeline.Bind(commandBuffer);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
+									&frameInfo.globalDescriptorSet, 0, nullptr);
+			VkBuffer buffers[]	   = {instanceBuffer};
+			VkDeviceSize offsets[] = {0};
+			vkCmdBindVertexBuffers(commandBuffer, INSTANCE_BINDING, 1, buffers, offsets);
+
+			uint32_t firstRun		= drawRuns.size() * chunk / chunkCount;
+			uint32_t endRun			= drawRuns.size() * (chunk + 1) / chunkCount;
+			const DrawRun* previous = nullptr;
+			for (uint32_t i = firstRun; i < endRun; i++) {
+				auto& run = drawRuns[i];
+				if (previous == nullptr || previous->material != run.material)
+					materialSystem.Bind(run.material, commandBuffer, pipelineLayout, 1, frameInfo.frameIndex);
+				if (previous == nullptr || previous->model->GetMesh().page != run.model->GetMesh().page)
+					run.model->Bind(commandBuffer);
+				previous = &run;
+
+				if (gpuCulling) {
+					meshPool.DrawIndirect(commandBuffer, run.model->IsIndexed(), indirectBuffer,
+										  gpuCulling->IndirectOffset(run.first), run.count);
+				} else {
+					run.model->Draw(commandBuffer, run.count, run.first);
+				}
+			}
+
+			renderer.EndSecondaryCommandBuffer(commandBuffer);
+			commandBuffers[firstBuffer + chunk] = commandBuffer;
+		}
+	});
+}
+
+Buffer& PbrRenderSystem::GetInstanceBuffer(int frameIndex, size_t instanceCount)
+{
+	auto& buffer = instanceBuffers[frameIndex];
+	if (buffer == nullptr || buffer->GetInstanceCount() < instanceCount) {
+		// BeginFrame waited for the last frame that used this index, nothing reads the old buffer anymore
+		size_t capacity = std::max<size_t>(instanceCount + instanceCount / 2, MIN_INSTANCE_CAPACITY);
+		buffer			= std::make_unique<Buffer>(device, sizeof(InstanceData), capacity,
+										   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+										   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		buffer->Map();
+	}
+	return *buffer;
+}
+
+void PbrRenderSystem::CullGameObjects(FrameInfo& frameInfo, Registry& registry, const SpatialIndex& spatialIndex,
+									  const MaterialSystem& materialSystem)
+{
+	MVE_PROFILE_SCOPE("PbrRenderSystem::CullGameObjects");
+
+	candidates.clear();
+	for (auto& component : spheres) { component.clear(); }
+
+	Frustum frustum = frameInfo.camera.GetFrustum();
+
+	// The BVH skips whole groups of off-screen objects, only the ones near the frustum are tested one by one
+	auto& transforms	= registry.Pool<TransformComponent>();
+	auto& meshRenderers = registry.Pool<MeshRendererComponent>();
+	auto& materials		= registry.Pool<MaterialComponent>();
+	spatialIndex.Renderables().Query(frustum, [&](Entity entity) {
+		auto& transform = transforms.Get(entity);
+		auto& model		= meshRenderers.Get(entity).model;
+		auto material	= materials.TryGet(entity);
+		candidates.push_back({&transform, model.get(), materialSystem.Resolve(material ? material->id : NULL_HANDLE)});
+
+		auto sphere = model->GetBoundingSphere().Transformed(transform.WorldMatrix());
+		spheres[0].push_back(sphere.center.x);
+		spheres[1].push_back(sphere.center.y);
+		spheres[2].push_back(sphere.center.z);
+		spheres[3].push_back(sphere.radius);
+	});
+
+	SphereSoA soa {};
+	soa.center[0] = spheres[0].data();
+	soa.center[1] = spheres[1].data();
+	soa.center[2] = spheres[2].data();
+	soa.radius	  = spheres[3].data();
+	soa.count	  = candidates.size();
+
+	visible.resize(candidates.size());
+	size_t visibleCount = frustum.CullSpheres(soa, visible.data());
+
+	// Spheres are loose around long or flat models, their boxes reject most of what slipped through
+	for (size_t i = 0; i < candidates.size(); i++) {
+		if (!visible[i])
+			continue;
 
-		go.model->Bind(frameInfo.commandBuffer);
-		go.model->Draw(frameInfo.commandBuffer);
+		auto& candidate = candidates[i];
+		auto box		= candidate.model->GetBoundingBox().Transformed(candidate.transform->WorldMatrix());
+		visible[i]		= frustum.Intersects(box);
+		visibleCount -= !visible[i];
 	}
+	frameInfo.stats.culledObjects += spatialIndex.Renderables().ProxyCount() - visibleCount;
 }
 
 } // namespace MVE
\ No newline at end of file
@@ -1,13 +1,18 @@
 #pragma once
 
+#include "../AsyncPipeline.h"
+#include "../Buffer.h"
 #include "../Device.h"
 #include "../FrameInfo.h"
+#include "../GpuCulling.h"
 #include "../MaterialSystem.h"
-#include "../Pipeline.h"
+#include "../RenderQueue.h"
+#include "../Renderer.h"
 #include "moduels/Module.h"
 
 #include "core/Application.h"
 #include "core/GameObject.h"
+#include "core/SpatialIndex.h"
 
 namespace MVE
 {
@@ -15,23 +20,75 @@ namespace MVE
 class PbrRenderSystem : public Module
 {
   public:
+	// cpuCulling keeps the CPU path on devices that could cull on the GPU, to compare the two
 	PbrRenderSystem(Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
-					MaterialSystem& materialSystem);
+					MaterialSystem& materialSystem, bool cpuCulling = false);
 	~PbrRenderSystem();
 
 	PbrRenderSystem(const PbrRenderSystem&) = delete;
 	void operator=(const PbrRenderSystem&)	= delete;
 
-	void RenderGameObjects(FrameInfo& frameInfo, GameObject::Map& gameObjects, MaterialSystem& materialSystem);
+	// Records the work that can't be inside a render pass, before RenderGameObjects
+	void PrepareGameObjects(FrameInfo& frameInfo, Registry& registry);
+	// Records the draws into secondary command buffers for the swap chain render pass, split over the job system
+	// threads when there are enough of them. Appends the buffers to commandBuffers in the order they must execute.
+	void RenderGameObjects(FrameInfo& frameInfo, Registry& registry, const SpatialIndex& spatialIndex,
+						   MaterialSystem& materialSystem, Renderer& renderer,
+						   std::vector<VkCommandBuffer>& commandBuffers);
+
+	bool CullsOnGpu() const { return gpuCulling != nullptr; }
 
   private:
 	void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout, MaterialSystem& materialSystem);
 	void CreatePipeline(VkRenderPass renderPass);
+	// Fills candidates with the objects near the camera frustum and marks the ones inside it as visible
+	void CullGameObjects(FrameInfo& frameInfo, Registry& registry, const SpatialIndex& spatialIndex,
+						 const MaterialSystem& materialSystem);
+	// Fill drawRuns from the CPU culled render queue, or from the batches of the GPU culling. CollectDraws returns the
+	// instance buffer, VK_NULL_HANDLE when nothing is visible.
+	VkBuffer CollectDraws(FrameInfo& frameInfo, Registry& registry, const SpatialIndex& spatialIndex,
+						  const MaterialSystem& materialSystem);
+	void CollectIndirectDraws();
+	void RecordDrawRuns(FrameInfo& frameInfo, MaterialSystem& materialSystem, Renderer& renderer,
+						VkBuffer instanceBuffer, std::vector<VkCommandBuffer>& commandBuffers);
+	// Grows the frame's instance buffer when it can't hold instanceCount instances
+	Buffer& GetInstanceBuffer(int frameIndex, size_t instanceCount);
+
+  private:
+	struct DrawCandidate
+	{
+		const TransformComponent* transform;
+		Model* model;
+		MaterialId material;
+	};
+
+	// One draw call, instanced or a multi-draw of indirect commands
+	struct DrawRun
+	{
+		Model* model;
+		MaterialId material;
+		uint32_t first; // First instance, or first indirect command with GPU culling
+		uint32_t count;
+	};
 
   private:
 	Device& device;
 
-	std::unique_ptr<GraphicsPipeline> pipeline;
+	AsyncPipeline<GraphicsPipeline> pipeline;
 	VkPipelineLayout pipelineLayout;
+
+	// Culling scratch, kept between frames so the allocations are reused
+	std::vector<DrawCandidate> candidates;
+	std::array<std::vector<float>, 4> spheres; // World space center x, y, z and radius of each candidate
+	std::vector<uint8_t> visible;
+	RenderQueue renderQueue; // Visible candidates by material, mesh and depth
+	std::vector<DrawRun> drawRuns;
+
+	std::vector<std::unique_ptr<Buffer>> instanceBuffers; // Per frame in flight, host visible
+
+	// Culls on the GPU and draws indirect, so the CPU work doesn't grow with the object count. Its batches aren't
+	// ordered by depth, only the CPU path draws front to back. Null when the device doesn't support it or CPU culling
+	// was asked for, then the objects are culled and sorted on the CPU.
+	std::unique_ptr<GpuCulling> gpuCulling;
 };
 } // namespace MVE
\ No newline at end of file
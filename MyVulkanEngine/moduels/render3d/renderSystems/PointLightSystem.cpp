@@ -1,5 +1,7 @@
 #include "PointLightSystem.h"
 
+#include <algorithm>
+
 namespace MVE
 {
 
@@ -20,6 +22,7 @@ PointLightSystem::PointLightSystem(Device& device, VkRenderPass renderPass, VkDe
 PointLightSystem::~PointLightSystem()
 {
 	vkDeviceWaitIdle(device.VulkanDevice());
+	pipeline.Wait();
 	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
 }
 
@@ -47,58 +50,73 @@ void PointLightSystem::CreatePipeline(VkRenderPass renderPass)
 {
 	MVE_ASSERT(pipelineLayout != nullptr, "Pipeline can't be created before pipeline layout");
 
-	PipelineConfigInfo pipelineConfig {};
-	Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
-	Pipeline::EnableAlphaBlending(pipelineConfig);
-
-	pipelineConfig.bindingDescription.clear();
-	pipelineConfig.attributeDescription.clear();
-	pipelineConfig.renderPass	  = renderPass;
-	pipelineConfig.pipelineLayout = pipelineLayout;
-	pipeline					  = std::make_unique<GraphicsPipeline>(device, SHADER_BINARY_DIR "point_light.vert.spv",
-												   SHADER_BINARY_DIR "point_light.frag.spv", pipelineConfig);
+	// Compiled on a worker, Render skips the draws until it's done
+	pipeline.Compile([&device = device, renderPass, layout = pipelineLayout] {
+		PipelineConfigInfo pipelineConfig {};
+		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+		Pipeline::EnableAlphaBlending(pipelineConfig);
+
+		pipelineConfig.bindingDescription.clear();
+		pipelineConfig.attributeDescription.clear();
+		pipelineConfig.renderPass	  = renderPass;
+		pipelineConfig.pipelineLayout = layout;
+		return std::make_unique<GraphicsPipeline>(device, SHADER_BINARY_DIR "point_light.vert.spv",
+												  SHADER_BINARY_DIR "point_light.frag.spv", pipelineConfig);
+	});
 }
 
-void PointLightSystem::Update(FrameInfo& frameInfo, GameObject::Map& gameObjects, GlobalUbo& ubo)
+void PointLightSystem::Update(FrameInfo& frameInfo, Registry& registry, GlobalUbo& ubo)
 {
-	int i = 0;
-	int j = 0;
-	for (auto& [id, go] : gameObjects) {
-		if (go.pointLight != nullptr) {
-			ubo.pointLights[i].position = glm::vec4(go.transform.translation, 1.0f);
-			ubo.pointLights[i].color	= glm::vec4(go.color, go.pointLight->lightIntensity);
-			i++;
-		} else if (go.directionalLight != nullptr) {
-			ubo.directionalLights[j].direction = glm::vec4(go.transform.Mat4()[0]);
-			ubo.directionalLights[j].color	   = glm::vec4(go.color, go.directionalLight->lightIntensity);
+	MVE_PROFILE_SCOPE("PointLightSystem::Update");
+	// Point lights are uploaded by ClusteredLighting, only the few directional lights go into the UBO
+	int j		= 0;
+	int skipped = 0;
+	registry.View<TransformComponent, DirectionalLightComponent>().Each(
+		[&](Entity entity, TransformComponent& transform, DirectionalLightComponent& light) {
+			if (j == MAX_DIRECTIONAL_LIGHTS) {
+				skipped++;
+				return;
+			}
+			ubo.directionalLights[j].direction = glm::vec4(transform.WorldMatrix()[0]);
+			ubo.directionalLights[j].color	   = glm::vec4(light.color, light.lightIntensity);
 			j++;
-		}
-	};
-	ubo.numPointLights		 = i;
+		});
 	ubo.numDirectionalLights = j;
+
+	static bool warned = false;
+	if (skipped > 0 && !warned) {
+		MVE_WARN("Scene has more than {} directional lights, {} lights are ignored", MAX_DIRECTIONAL_LIGHTS, skipped);
+		warned = true;
+	}
 }
 
-void PointLightSystem::Render(FrameInfo& frameInfo, GameObject::Map& gameObjects)
+void PointLightSystem::Render(FrameInfo& frameInfo, Registry& registry, const SpatialIndex& spatialIndex)
 {
-	// sort lights by distance from camera.
-	std::multimap<float, GameObject::id_t> lightsDistance;
+	MVE_PROFILE_SCOPE("PointLightSystem::Render");
+	auto lightPipeline = pipeline.TryGet();
+	if (!lightPipeline)
+		return;
+
+	// sort lights by distance from camera, furthest first.
+	std::vector<std::pair<float, Entity>> lightsDistance;
 	glm::vec3 cameraPos = frameInfo.camera.GetPosition();
-	for (auto& [id, go] : gameObjects) {
-		if (go.pointLight == nullptr)
-			continue;
-		auto diff = go.transform.translation - cameraPos;
-		lightsDistance.emplace(glm::dot(diff, diff), id);
-	}
+	auto& transforms	= registry.Pool<TransformComponent>();
+	spatialIndex.PointLights().Query(frameInfo.camera.GetFrustum(), [&](Entity entity) {
+		auto diff = transforms.Get(entity).GetTranslation() - cameraPos;
+		lightsDistance.emplace_back(glm::dot(diff, diff), entity);
+	});
+	std::sort(lightsDistance.begin(), lightsDistance.end(), std::greater());
 
-	pipeline->Bind(frameInfo.commandBuffer);
+	lightPipeline->Bind(frameInfo.commandBuffer);
 
-	for (auto it = lightsDistance.rbegin(); it != lightsDistance.rend(); it++) {
-		auto& go = gameObjects.at(it->second);
+	for (auto& [distance, entity] : lightsDistance) {
+		auto& transform = registry.Get<TransformComponent>(entity);
+		auto& light		= registry.Get<PointLightComponent>(entity);
 
 		PointLightPushConstants pushConstants {};
-		pushConstants.color	   = glm::vec4(go.color, go.pointLight->lightIntensity);
-		pushConstants.position = glm::vec4(go.transform.translation, 1.0f);
-		pushConstants.radius   = go.transform.scale.x;
+		pushConstants.color	   = glm::vec4(light.color, light.lightIntensity);
+		pushConstants.position = glm::vec4(transform.GetTranslation(), 1.0f);
+		pushConstants.radius   = transform.GetScale().x;
 
 		vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout,
 						   VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
@@ -108,6 +126,8 @@ void PointLightSystem::Render(FrameInfo& frameInfo, GameObject::Map& gameObjects
 								&frameInfo.globalDescriptorSet, 0, nullptr);
 
 		vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
+		frameInfo.stats.drawCalls++;
+		frameInfo.stats.triangles += 2;
 	}
 }
 
@@ -2,11 +2,12 @@
 
 #include "../Device.h"
 #include "../FrameInfo.h"
-#include "../Pipeline.h"
+#include "../AsyncPipeline.h"
 #include "moduels/Module.h"
 
 #include "core/Application.h"
 #include "core/GameObject.h"
+#include "core/SpatialIndex.h"
 
 namespace MVE
 {
@@ -20,8 +21,10 @@ class PointLightSystem : public Module
 	PointLightSystem(const PointLightSystem&) = delete;
 	void operator=(const PointLightSystem&)	  = delete;
 
-	void Update(FrameInfo& frameInfo, GameObject::Map& gameObjects, GlobalUbo& ubo);
-	void Render(FrameInfo& frameInfo, GameObject::Map& gameObjects);
+	// Writes the directional lights into ubo, the point lights are ClusteredLighting's
+	void Update(FrameInfo& frameInfo, Registry& registry, GlobalUbo& ubo);
+	// Draws the lights in the camera frustum as billboards
+	void Render(FrameInfo& frameInfo, Registry& registry, const SpatialIndex& spatialIndex);
 
   private:
 	void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout);
@@ -30,7 +33,7 @@ class PointLightSystem : public Module
   private:
 	Device& device;
 
-	std::unique_ptr<GraphicsPipeline> pipeline;
+	AsyncPipeline<GraphicsPipeline> pipeline;
 	VkPipelineLayout pipelineLayout;
 };
 } // namespace MVE
\ No newline at end of file
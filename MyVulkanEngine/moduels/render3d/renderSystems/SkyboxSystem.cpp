@@ -12,6 +12,7 @@ SkyboxSystem::SkyboxSystem(Device& device, VkRenderPass renderPass, VkDescriptor
 SkyboxSystem::~SkyboxSystem()
 {
 	vkDeviceWaitIdle(device.VulkanDevice());
+	pipeline.Wait();
 	vkDestroyPipelineLayout(device.VulkanDevice(), pipelineLayout, nullptr);
 }
 
@@ -34,26 +35,36 @@ void SkyboxSystem::CreatePipeline(VkRenderPass renderPass)
 {
 	MVE_ASSERT(pipelineLayout != nullptr, "Pipeline can't be created before pipeline layout");
 
-	PipelineConfigInfo pipelineConfig {};
-	Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
-	pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	// Compiled on a worker, Render skips the draws until it's done
+	pipeline.Compile([&device = device, renderPass, layout = pipelineLayout] {
+		PipelineConfigInfo pipelineConfig {};
+		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+		pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
 
-	pipelineConfig.bindingDescription.clear();
-	pipelineConfig.attributeDescription.clear();
-	pipelineConfig.renderPass	  = renderPass;
-	pipelineConfig.pipelineLayout = pipelineLayout;
-	pipeline					  = std::make_unique<GraphicsPipeline>(device, SHADER_BINARY_DIR "skybox.vert.spv",
-												   SHADER_BINARY_DIR "skybox.frag.spv", pipelineConfig);
+		pipelineConfig.bindingDescription.clear();
+		pipelineConfig.attributeDescription.clear();
+		pipelineConfig.renderPass	  = renderPass;
+		pipelineConfig.pipelineLayout = layout;
+		return std::make_unique<GraphicsPipeline>(device, SHADER_BINARY_DIR "skybox.vert.spv",
+												  SHADER_BINARY_DIR "skybox.frag.spv", pipelineConfig);
+	});
 }
 
 void SkyboxSystem::Render(FrameInfo& frameInfo, const Cubemap& cubemap)
 {
-	pipeline->Bind(frameInfo.commandBuffer);
+	MVE_PROFILE_SCOPE("SkyboxSystem::Render");
+	auto skyboxPipeline = pipeline.TryGet();
+	if (!skyboxPipeline)
+		return;
+
+	skyboxPipeline->Bind(frameInfo.commandBuffer);
 
 	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
 							&frameInfo.globalDescriptorSet, 0, nullptr);
 
 	vkCmdDraw(frameInfo.commandBuffer, 36, 1, 0, 0);
+	frameInfo.stats.drawCalls++;
+	frameInfo.stats.triangles += 12;
 }
 
 } // namespace MVE
\ No newline at end of file
@@ -3,7 +3,7 @@
 #include "../Cubemap.h"
 #include "../Device.h"
 #include "../FrameInfo.h"
-#include "../Pipeline.h"
+#include "../AsyncPipeline.h"
 #include "moduels/Module.h"
 
 #include "core/Application.h"
@@ -30,7 +30,7 @@ class SkyboxSystem : public Module
   private:
 	Device& device;
 
-	std::unique_ptr<GraphicsPipeline> pipeline;
+	AsyncPipeline<GraphicsPipeline> pipeline;
 	VkPipelineLayout pipelineLayout;
 };
 } // namespace MVE
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "core/Event.h"
 #include "core/EventCallback.h"
 #include "core/Log.h"
+#include "core/Profiler.h"
 
 #include <array>
 #include <cstdint>
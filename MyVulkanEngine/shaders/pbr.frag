@@ -8,7 +8,7 @@ layout(location = 2) in vec3 vPositionWorld;
 layout(location = 3) in mat3 vTBN;
 
 struct PointLight{
-	vec4 position;
+	vec4 position; // w is the range
 	vec4 color;
 };
 
@@ -23,9 +23,9 @@ layout(set=0, binding=0) uniform GlobalUbo{
 	mat4 projection;
 	mat4 inverseView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
 	DirectionalLight directionalLights[10];
-	int numPointLights;
+	vec4 clusterScale;
+	uvec4 clusterGrid;
 	int numDirectionalLights;
 } uUbo;
 
@@ -33,6 +33,11 @@ layout(set=0, binding=1) uniform samplerCube uSkybox;
 layout(set=0, binding=2) uniform samplerCube uIrradiance;
 layout(set=0, binding=3) uniform sampler2D uBrdfLut;
 
+// Written by cluster.comp, see ClusteredLighting
+layout(std430, set=0, binding=4) readonly buffer PointLights { PointLight pointLights[]; };
+layout(std430, set=0, binding=5) readonly buffer ClusterCounts { uint clusterCounts[]; };
+layout(std430, set=0, binding=6) readonly buffer ClusterIndices { uint clusterIndices[]; };
+
 layout(set=1, binding=0) uniform MaterialParams
 {
 	vec4 albedo;
@@ -47,12 +52,6 @@ layout(set=1, binding=2) uniform sampler2D armTexture;
 layout(set=1, binding=3) uniform sampler2D normalTexture;
 
 
-layout(push_constant) uniform Push{
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} uPush;
-
-
 layout(location = 0) out vec4 oColor;
 
 const float PI = 3.14159265358979;
@@ -107,6 +106,24 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }   
 
+// Inverse square falloff, smoothly windowed to 0 at the light's range so lights outside a cluster can be skipped
+float rangeAttenuation(float distance2, float range)
+{
+	float ratio2 = distance2 / (range * range);
+	float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+	return window * window / max(distance2, 0.0001);
+}
+
+// Index of the cluster this fragment is in, the same order as in cluster.comp
+uint clusterIndex()
+{
+	float viewDepth = (uUbo.view * vec4(vPositionWorld, 1.0)).z;
+	uvec2 tile = min(uvec2(gl_FragCoord.xy * uUbo.clusterScale.xy), uUbo.clusterGrid.xy - 1u);
+	float slice = log(max(viewDepth, 0.0001)) * uUbo.clusterScale.z + uUbo.clusterScale.w;
+	uint z = min(uint(max(slice, 0.0)), uUbo.clusterGrid.z - 1u);
+	return tile.x + uUbo.clusterGrid.x * (tile.y + uUbo.clusterGrid.y * z);
+}
+
 void main()
 {
 	vec3 cameraPosWorld = uUbo.inverseView[3].xyz;
@@ -137,15 +154,16 @@ void main()
 
 	vec3 outLight = (kd * diffuseAmbient + specularAmbient) * ao;
 
-	//for each point light
-	
-	for(int i = 0; i < uUbo.numPointLights; i++)
+	//for each point light in the fragment's cluster
+	uint cluster = clusterIndex();
+	uint lightCount = min(clusterCounts[cluster], uUbo.clusterGrid.w);
+	for(uint i = 0; i < lightCount; i++)
 	{
-		PointLight light = uUbo.pointLights[i];
+		PointLight light = pointLights[clusterIndices[cluster * uUbo.clusterGrid.w + i]];
 		vec3 lightColor = light.color.xyz * light.color.w;
 
 		vec3 L = light.position.xyz - vPositionWorld;
-		float attenuation = 1.0 / dot(L,L);
+		float attenuation = rangeAttenuation(dot(L,L), light.position.w);
 		L = normalize(L);
 		vec3 H = normalize(V + L);
 
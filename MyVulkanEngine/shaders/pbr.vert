@@ -7,10 +7,9 @@ layout(location = 3) in vec3 aTanget;
 layout(location = 4) in vec3 aBitanget;
 layout(location = 5) in vec2 aUV;
 
-struct PointLight{
-	vec4 position;
-	vec4 color;
-};
+// Per instance
+layout(location = 6) in mat4 aModelMatrix;
+layout(location = 10) in mat3x4 aNormalMatrix;
 
 struct DirectionalLight
 {
@@ -23,17 +22,12 @@ layout(set=0, binding=0) uniform GlobalUbo{
 	mat4 projection;
 	mat4 inverseView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
 	DirectionalLight directionalLights[10];
-	int numPointLights;
+	vec4 clusterScale;
+	uvec4 clusterGrid;
 	int numDirectionalLights;
 } uUbo;
 
-layout(push_constant) uniform Push{
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} uPush;
-
 layout(location = 0) out vec3 vColor;
 layout(location = 1) out vec2 vUV;
 layout(location = 2) out vec3 vPositionWorld;
@@ -41,11 +35,12 @@ layout(location = 3) out mat3 vTBN;
 
 void main()
 {
-	vec4 positionWorld = uPush.modelMatrix * vec4(aPos, 1.0);
+	vec4 positionWorld = aModelMatrix * vec4(aPos, 1.0);
 
-	vec3 normalWorld = normalize(mat3(uPush.normalMatrix) * aNormal);
-	vec3 tangetWorld = normalize(mat3(uPush.normalMatrix) * aTanget);
-	vec3 bitangetWorld = normalize(mat3(uPush.normalMatrix) * aBitanget);
+	mat3 normalMatrix = mat3(aNormalMatrix);
+	vec3 normalWorld = normalize(normalMatrix * aNormal);
+	vec3 tangetWorld = normalize(normalMatrix * aTanget);
+	vec3 bitangetWorld = normalize(normalMatrix * aBitanget);
 	vTBN = mat3(tangetWorld, bitangetWorld, normalWorld);
 
 	vColor = aColor;
@@ -16,11 +16,6 @@ layout(push_constant) uniform Push{
 	float radius;
 } uPush;
 
-struct PointLight{
-	vec4 position;
-	vec4 color;
-};
-
 struct DirectionalLight
 {
 	vec4 direction;
@@ -32,9 +27,9 @@ layout(set=0, binding=0) uniform GlobalUbo{
 	mat4 projection;
 	mat4 inverseView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
 	DirectionalLight directionalLights[10];
-	int numPointLights;
+	vec4 clusterScale;
+	uvec4 clusterGrid;
 	int numDirectionalLights;
 } uUbo;
 
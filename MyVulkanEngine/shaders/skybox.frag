@@ -2,11 +2,6 @@
 
 layout(location = 0) in vec3 vUVW;
 
-struct PointLight{
-	vec4 position;
-	vec4 color;
-};
-
 struct DirectionalLight
 {
 	vec4 direction;
@@ -18,9 +13,9 @@ layout(set=0, binding=0) uniform GlobalUbo{
 	mat4 projection;
 	mat4 inverseView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
 	DirectionalLight directionalLights[10];
-	int numPointLights;
+	vec4 clusterScale;
+	uvec4 clusterGrid;
 	int numDirectionalLights;
 } uUbo;
 
@@ -51,11 +51,6 @@ const vec3 VERTICES[] = vec3[](
     vec3( 1.0f, -1.0f,  1.0f)
 );
 
-struct PointLight{
-	vec4 position;
-	vec4 color;
-};
-
 struct DirectionalLight
 {
 	vec4 direction;
@@ -67,9 +62,9 @@ layout(set=0, binding=0) uniform GlobalUbo{
 	mat4 projection;
 	mat4 inverseView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
 	DirectionalLight directionalLights[10];
-	int numPointLights;
+	vec4 clusterScale;
+	uvec4 clusterGrid;
 	int numDirectionalLights;
 } uUbo;
 